@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "generate.h"
+
+// Benchmarks the main operations on random wffs of 10 to max_nodes variables
+// and operators, reporting the time and the number of heap allocations
+// (malloc, calloc and realloc, counted through the linker's --wrap) each one
+// takes. Run with "make bench"; see bench_usage for the options.
+
+typedef struct BenchCase BenchCase;
+typedef struct BenchOperation BenchOperation;
+
+// What an operation works on, made once per size outside the timed loop.
+struct BenchCase {
+    const char* string;
+    WffArena* arena;
+    WffTokenList* tokens;
+    WffParseTree* parse_tree;
+    Wff* wff;
+    // Rewritten over and over by wff_substitute.
+    Wff* subject;
+    char* buffer;
+};
+
+struct BenchOperation {
+    const char* name;
+    // Bigger wffs are skipped: 0 for no limit.
+    size_t max_nodes;
+    void (*run)(BenchCase* bench_case);
+};
+
+void bench_tokenize(BenchCase* bench_case);
+void bench_parse_tree_create(BenchCase* bench_case);
+void bench_tree_create(BenchCase* bench_case);
+void bench_subwffs(BenchCase* bench_case);
+void bench_match(BenchCase* bench_case);
+void bench_substitute(BenchCase* bench_case);
+void bench_render(BenchCase* bench_case);
+
+const BenchOperation BENCH_OPERATIONS[] = {
+    {"wff_tokenize", 0, bench_tokenize},
+    {"wff_parse_tree_create", 0, bench_parse_tree_create},
+    {"wff_tree_create", 0, bench_tree_create},
+    // Every subwff becomes a wff with an arena of its own, all alive at once.
+    {"wff_subwffs", 100000, bench_subwffs},
+    {"wff_match", 0, bench_match},
+    {"wff_substitute", 0, bench_substitute},
+    {"wff_parse_tree_render", 0, bench_render},
+};
+#define BENCH_OPERATION_COUNT (sizeof(BENCH_OPERATIONS) / sizeof(BENCH_OPERATIONS[0]))
+
+size_t bench_allocations = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    bench_allocations++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    bench_allocations++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    bench_allocations++;
+    return __real_realloc(ptr, size);
+}
+
+
+void bench_tokenize(BenchCase* bench_case) {
+    WffArena* arena = wff_arena_create();
+    wff_tokenize(bench_case->string, arena);
+    wff_arena_destroy(arena);
+}
+
+void bench_parse_tree_create(BenchCase* bench_case) {
+    WffArena* arena = wff_arena_create();
+    wff_parse_tree_create(bench_case->tokens, arena);
+    wff_arena_destroy(arena);
+}
+
+void bench_tree_create(BenchCase* bench_case) {
+    WffArena* arena = wff_arena_create();
+    wff_tree_create(bench_case->parse_tree, arena);
+    wff_arena_destroy(arena);
+}
+
+void bench_subwffs(BenchCase* bench_case) {
+    WffList* subwffs = wff_subwffs(bench_case->wff);
+    WffVectorIterator iterator = wff_list_iterate(subwffs);
+    for (Wff* subwff = wff_list_next(&iterator); subwff != NULL; subwff = wff_list_next(&iterator)) {
+        wff_destroy(subwff);
+    }
+    wff_list_destroy(subwffs);
+}
+
+void bench_match(BenchCase* bench_case) {
+    WffMatchList* matches = wff_match(bench_case->wff, "(a v b)");
+    wff_match_list_destroy(matches);
+}
+
+// Commutes the first disjunction, so the wff goes back and forth between two
+// shapes and every run does the same work.
+void bench_substitute(BenchCase* bench_case) {
+    wff_substitute(bench_case->subject, "(a v b)", "(b v a)", 0);
+}
+
+void bench_render(BenchCase* bench_case) {
+    wff_parse_tree_render(bench_case->wff->parse_tree->root, bench_case->buffer);
+}
+
+
+double bench_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Runs 'operation' until at least 'min_seconds' have gone by, doubling the
+// number of runs between clock readings, and prints the averages.
+void bench_measure(const BenchOperation* operation, BenchCase* bench_case, size_t node_count, double min_seconds) {
+    size_t runs = 0;
+    size_t allocations = bench_allocations;
+    double start = bench_now();
+    double elapsed = 0;
+    for (size_t batch = 1; elapsed < min_seconds; batch *= 2) {
+        for (size_t i = 0; i < batch; i++) {
+            operation->run(bench_case);
+        }
+        runs += batch;
+        elapsed = bench_now() - start;
+    }
+    allocations = bench_allocations - allocations;
+    printf("%-24s %10zu %16.0f %14.1f %10zu\n", operation->name, node_count, elapsed * 1e9 / runs, (double) allocations / runs, runs);
+    fflush(stdout);
+}
+
+void bench_case_create(BenchCase* bench_case, const char* string) {
+    bench_case->string = string;
+    bench_case->arena = wff_arena_create();
+    bench_case->tokens = wff_tokenize(string, bench_case->arena);
+    bench_case->parse_tree = wff_parse_tree_create(bench_case->tokens, bench_case->arena);
+    bench_case->wff = wff_create(string);
+    bench_case->subject = wff_create(string);
+    bench_case->buffer = malloc((strlen(string) + 1) * sizeof(char));
+}
+
+void bench_case_destroy(BenchCase* bench_case) {
+    wff_arena_destroy(bench_case->arena);
+    wff_destroy(bench_case->wff);
+    wff_destroy(bench_case->subject);
+    free(bench_case->buffer);
+}
+
+void bench_usage() {
+    fprintf(stderr, "Usage: bench [-s seed] [-n variables] [-d max depth] [-w weights of ~,^,v,=>,<=>] [-m max nodes] [-t seconds per measurement]\n");
+}
+
+bool bench_parse_size(const char* string, size_t* value) {
+    char* end;
+    unsigned long long parsed = strtoull(string, &end, 10);
+    if (*string == '\0' || *string == '-' || *end != '\0') {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+bool bench_parse_weights(const char* string, unsigned* weights) {
+    for (size_t i = 0; i < WFF_GENERATOR_OPERATOR_COUNT; i++) {
+        char* end;
+        unsigned long weight = strtoul(string, &end, 10);
+        if (end == string || *string == '-' || *end != (i + 1 < WFF_GENERATOR_OPERATOR_COUNT ? ',' : '\0')) {
+            return false;
+        }
+        weights[i] = weight;
+        string = end + 1;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    WffGenerator generator;
+    uint64_t seed = 1;
+    wff_generator_init(&generator, seed);
+    size_t max_nodes = 1000000;
+    double min_seconds = 0.25;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 == argc || argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0') {
+            bench_usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        size_t parsed;
+        bool valid;
+        switch (argv[i - 1][1]) {
+            case 's':
+                valid = bench_parse_size(value, &parsed);
+                seed = parsed;
+                break;
+            case 'n':
+                valid = bench_parse_size(value, &generator.var_count) && generator.var_count >= 1 && generator.var_count <= WFF_GENERATOR_MAX_VARIABLES;
+                break;
+            case 'd':
+                valid = bench_parse_size(value, &generator.max_depth);
+                break;
+            case 'w':
+                valid = bench_parse_weights(value, generator.weights);
+                break;
+            case 'm':
+                valid = bench_parse_size(value, &max_nodes);
+                break;
+            case 't':
+                min_seconds = strtod(value, NULL);
+                valid = min_seconds > 0;
+                break;
+            default:
+                valid = false;
+        }
+        if (!valid) {
+            fprintf(stderr, "ERROR: Invalid value %s for %s\n", value, argv[i - 1]);
+            bench_usage();
+            return 1;
+        }
+    }
+
+    printf("seed %llu, %zu variables, max depth %zu, weights ~ %u ^ %u v %u => %u <=> %u\n\n", (unsigned long long) seed,
+           generator.var_count, generator.max_depth, generator.weights[WO_NOT], generator.weights[WO_AND],
+           generator.weights[WO_OR], generator.weights[WO_COND], generator.weights[WO_BICOND]);
+    printf("%-24s %10s %16s %14s %10s\n", "operation", "nodes", "ns/op", "allocs/op", "runs");
+    for (size_t node_count = 10; node_count <= max_nodes; node_count *= 10) {
+        // Each size gets a stream of its own, so a size's wff doesn't depend on
+        // which sizes came before it.
+        generator.state = seed ^ node_count;
+        char* string = wff_generator_string(&generator, node_count);
+        BenchCase bench_case;
+        bench_case_create(&bench_case, string);
+        for (size_t i = 0; i < BENCH_OPERATION_COUNT; i++) {
+            const BenchOperation* operation = &BENCH_OPERATIONS[i];
+            if (operation->max_nodes == 0 || node_count <= operation->max_nodes) {
+                bench_measure(operation, &bench_case, node_count, min_seconds);
+            }
+        }
+        bench_case_destroy(&bench_case);
+        free(string);
+    }
+    return 0;
+}
@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "rules.h"
+#include "proof.h"
+#include "batch.h"
+#include "vector.h"
+#include "generate.h"
+#include "check.h"
+
+// Largest wff a proof starts from, and most steps it takes from there.
+#define CHECK_BATCH_MAX_NODES 10
+#define CHECK_BATCH_MAX_STEPS 6
+// Operands of the chain given to the normalizer: a quadratic one takes
+// seconds over it, a linear one milliseconds.
+#define CHECK_BATCH_CHAIN_LENGTH 100000
+// Valid proofs written for each run of the batch checker.
+#define CHECK_BATCH_FILE_COUNT 8
+
+typedef struct CheckProof CheckProof;
+
+// Binary operators from the loosest to the tightest binding, as proofs read
+// them.
+const WffOperator CHECK_BATCH_LEVELS[] = {WO_BICOND, WO_COND, WO_OR, WO_AND};
+#define CHECK_BATCH_LEVEL_COUNT (sizeof(CHECK_BATCH_LEVELS) / sizeof(CHECK_BATCH_LEVELS[0]))
+
+
+// A generated proof and what wff_proof_check must make of it.
+struct CheckProof {
+    char* text;
+    WffProofStatus status;
+};
+
+void _check_batch_normalize(Wff* wff, const char* string);
+void _check_batch_chain();
+CheckProof _check_batch_proof(WffGenerator* generator, const CheckOptions* options, size_t i);
+void _check_batch_run(WffVector* kept, WffProofStatus status);
+int _check_batch_main_quietly(int argc, char** argv);
+void _check_batch_write(const char* path, const char* text);
+void _check_batch_render(CheckBuffer* buffer, WffParseTreeNode* node);
+void _check_batch_render_operand(CheckBuffer* buffer, WffParseTreeNode* node, bool parenthesize);
+size_t _check_batch_level(WffParseTreeNode* node);
+
+
+// The normalizer on wffs written with as few parentheses as precedence
+// allows, and on a long chain; wff_proof_check on generated proofs, valid
+// and broken in each way a proof can be; and main --check over files of them,
+// which must exit with 0 iff every one is valid.
+void check_batch(const CheckOptions* options) {
+    _check_batch_chain();
+
+    WffVector kept[WPS_UNREADABLE + 1];
+    for (WffProofStatus status = WPS_VALID; status <= WPS_UNREADABLE; status++) {
+        wff_vector_init(&kept[status], sizeof(char*), NULL);
+    }
+    WffGenerator generator;
+    check_generator_init(&generator, options, "batch");
+    for (size_t i = 0; i < options->case_count; i++) {
+        char* string = check_generate(&generator, i, options->max_nodes);
+        Wff* wff = wff_create(string);
+        _check_batch_normalize(wff, string);
+        wff_destroy(wff);
+        free(string);
+
+        CheckProof proof = _check_batch_proof(&generator, options, i);
+        WffProofReport report;
+        if (wff_proof_check(proof.text, check_rule_index, &report) != proof.status) {
+            check_fail_string("wff_proof_check", proof.text);
+        }
+        if (wff_vector_length(&kept[proof.status]) < CHECK_BATCH_FILE_COUNT) {
+            wff_vector_append(&kept[proof.status], &proof.text);
+        } else {
+            free(proof.text);
+        }
+    }
+
+    for (WffProofStatus status = WPS_VALID; status <= WPS_UNREADABLE; status++) {
+        _check_batch_run(kept, status);
+    }
+    for (WffProofStatus status = WPS_VALID; status <= WPS_UNREADABLE; status++) {
+        WffVectorIterator iterator = wff_vector_iterate(&kept[status]);
+        for (char** text = wff_vector_iterator_next(&iterator); text != NULL; text = wff_vector_iterator_next(&iterator)) {
+            free(*text);
+        }
+        wff_vector_finish(&kept[status]);
+    }
+}
+
+// The wff, written fully parenthesized and with as few parentheses as
+// possible, must come back from the normalizer as the same tree.
+void _check_batch_normalize(Wff* wff, const char* string) {
+    char* expected = wff_parse_tree_get_subwff_string(wff->parse_tree->root);
+    CheckBuffer minimal = {NULL, 0, 0};
+    _check_batch_render(&minimal, wff->parse_tree->root);
+    const char* inputs[2] = {string, minimal.data};
+    for (size_t k = 0; k < 2; k++) {
+        char* normalized = wff_proof_normalize(inputs[k]);
+        if (normalized == NULL) {
+            check_fail_string("wff_proof_normalize", inputs[k]);
+            continue;
+        }
+        Wff* result = wff_create(normalized);
+        char* actual = wff_parse_tree_get_subwff_string(result->parse_tree->root);
+        if (strcmp(actual, expected) != 0) {
+            check_fail_string("wff_proof_normalize", inputs[k]);
+        }
+        free(actual);
+        wff_destroy(result);
+        free(normalized);
+    }
+    free(minimal.data);
+    free(expected);
+}
+
+// p ^ q ^ p ^ ... groups to the left, so every opening parenthesis goes in
+// front.
+void _check_batch_chain() {
+    CheckBuffer chain = {NULL, 0, 0};
+    for (size_t i = 0; i < CHECK_BATCH_CHAIN_LENGTH; i++) {
+        check_buffer_append(&chain, i == 0 ? "p" : i % 2 == 0 ? " ^ p" : " ^ q");
+    }
+    char* normalized = wff_proof_normalize(chain.data);
+    size_t opens = CHECK_BATCH_CHAIN_LENGTH - 1;
+    bool valid = normalized != NULL && strlen(normalized) == chain.length + 2 * opens && normalized[opens - 1] == '(' &&
+                 normalized[opens] == 'p' && normalized[strlen(normalized) - 1] == ')';
+    if (!valid) {
+        check_fail_string("wff_proof_normalize", "a long chain of ^");
+    }
+    free(normalized);
+    free(chain.data);
+}
+
+// A proof of a few random rule steps from a small wff, written with as few
+// parentheses as possible. Depending on 'i' it is left valid, stops a step
+// short of its goal, gives its last step a rule that doesn't apply, or
+// misnumbers its last line.
+CheckProof _check_batch_proof(WffGenerator* generator, const CheckOptions* options, size_t i) {
+    char* string = check_generate(generator, i, options->max_nodes < CHECK_BATCH_MAX_NODES ? options->max_nodes : CHECK_BATCH_MAX_NODES);
+    Wff* lines[CHECK_BATCH_MAX_STEPS + 1];
+    const WffRule* rules[CHECK_BATCH_MAX_STEPS + 1];
+    lines[0] = wff_create(string);
+    rules[0] = NULL;
+    size_t count = 1;
+    size_t steps = 1 + i % CHECK_BATCH_MAX_STEPS;
+    while (count <= steps) {
+        WffRuleMatchList* matches = wff_rule_index_match(check_rule_index, lines[count - 1]);
+        size_t match_count = wff_rule_match_list_length(matches);
+        if (match_count > 0) {
+            WffRuleMatch* match = wff_rule_match_list_get(matches, (7 * i + count) % match_count);
+            rules[count] = wff_rule_match_get_rule(match);
+            lines[count] = wff_rule_match_rewrite(lines[count - 1], match);
+        }
+        check_match_list_destroy(matches);
+        if (match_count == 0) {
+            break;
+        }
+        count++;
+    }
+
+    CheckProof proof = {NULL, WPS_VALID};
+    size_t last = count - 1;
+    size_t written = count;
+    size_t last_number = count;
+    const WffRule* last_rule = rules[last];
+    char* before_last = last > 0 ? wff_parse_tree_get_subwff_string(lines[last - 1]->parse_tree->root) : NULL;
+    char* goal = wff_parse_tree_get_subwff_string(lines[last]->parse_tree->root);
+    if (last > 0) {
+        switch (i % 4) {
+            case 1:
+                written--;
+                proof.status = strcmp(before_last, goal) == 0 ? WPS_VALID : WPS_INCOMPLETE;
+                break;
+            case 2:
+                for (size_t r = 0; r < WFF_RULE_COUNT && proof.status == WPS_VALID; r++) {
+                    if (!wff_rule_verify(check_rule_index, lines[last - 1], &WFF_RULES[r], lines[last], NULL)) {
+                        last_rule = &WFF_RULES[r];
+                        proof.status = WPS_INVALID;
+                    }
+                }
+                break;
+            case 3:
+                last_number = count + 1;
+                proof.status = WPS_MALFORMED;
+                break;
+        }
+    }
+
+    CheckBuffer text = {NULL, 0, 0};
+    check_buffer_append(&text, "PROVE (");
+    _check_batch_render(&text, lines[0]->parse_tree->root);
+    check_buffer_append(&text, ") => (");
+    _check_batch_render(&text, lines[last]->parse_tree->root);
+    check_buffer_append(&text, ")\n(Direct Proof)\n");
+    for (size_t k = 0; k < written; k++) {
+        char number[64];
+        snprintf(number, sizeof(number), "%zu. ", k == last ? last_number : k + 1);
+        check_buffer_append(&text, number);
+        _check_batch_render(&text, lines[k]->parse_tree->root);
+        if (k == 0) {
+            check_buffer_append(&text, "    (hypothesis)\n");
+        } else {
+            snprintf(number, sizeof(number), "    (%s, %zu)\n", (k == last ? last_rule : rules[k])->name, k);
+            check_buffer_append(&text, number);
+        }
+    }
+    proof.text = text.data;
+
+    free(goal);
+    free(before_last);
+    for (size_t k = 0; k < count; k++) {
+        wff_destroy(lines[k]);
+    }
+    free(string);
+    return proof;
+}
+
+// Runs main --check over the valid proofs and, unless 'status' is WPS_VALID,
+// one proof with that status, which must make it fail. Proofs that can't be
+// read at all stand for a path that doesn't exist.
+void _check_batch_run(WffVector* kept, WffProofStatus status) {
+    if (status != WPS_VALID && status != WPS_UNREADABLE && wff_vector_length(&kept[status]) == 0) {
+        return;
+    }
+    char directory[] = "/tmp/wff-check-XXXXXX";
+    if (mkdtemp(directory) == NULL) {
+        check_fail_string("mkdtemp", directory);
+        return;
+    }
+    size_t valid_count = wff_vector_length(&kept[WPS_VALID]);
+    char paths[valid_count + 1][sizeof(directory) + 32];
+    for (size_t k = 0; k < valid_count; k++) {
+        snprintf(paths[k], sizeof(paths[k]), "%s/valid-%zu", directory, k);
+        _check_batch_write(paths[k], *(char**) wff_vector_get(&kept[WPS_VALID], k));
+    }
+    snprintf(paths[valid_count], sizeof(paths[valid_count]), "%s/broken", directory);
+    if (status != WPS_VALID && status != WPS_UNREADABLE) {
+        _check_batch_write(paths[valid_count], *(char**) wff_vector_get(&kept[status], 0));
+    }
+
+    // The directory, and the broken proof or missing file by name as well.
+    char* argv[] = {"-j", status % 2 == 0 ? "2" : "1", directory, paths[valid_count]};
+    int argc = status == WPS_VALID ? 3 : 4;
+    int result = _check_batch_main_quietly(argc, argv);
+    if ((result == 0) != (status == WPS_VALID)) {
+        check_fail_string("wff_batch_main exit status", wff_proof_status_string(status));
+    }
+
+    for (size_t k = 0; k < valid_count; k++) {
+        unlink(paths[k]);
+    }
+    unlink(paths[valid_count]);
+    rmdir(directory);
+}
+
+// wff_batch_main with its reports and throughput sent to /dev/null.
+int _check_batch_main_quietly(int argc, char** argv) {
+    fflush(stdout);
+    fflush(stderr);
+    int saved_out = dup(STDOUT_FILENO);
+    int saved_err = dup(STDERR_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    dup2(null, STDERR_FILENO);
+    int result = wff_batch_main(argc, argv);
+    fflush(stdout);
+    fflush(stderr);
+    dup2(saved_out, STDOUT_FILENO);
+    dup2(saved_err, STDERR_FILENO);
+    close(null);
+    close(saved_err);
+    close(saved_out);
+    return result;
+}
+
+void _check_batch_write(const char* path, const char* text) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        check_fail_string("fopen", path);
+        return;
+    }
+    fputs(text, file);
+    fclose(file);
+}
+
+// Writes the subwff of 'node' with parentheses only where precedence and
+// grouping need them, as a person would type it.
+void _check_batch_render(CheckBuffer* buffer, WffParseTreeNode* node) {
+    if (node->child_count == 1) {
+        check_buffer_append(buffer, wff_token_get_string(node->children[0]->token));
+    } else if (node->child_count == 2) {
+        check_buffer_append(buffer, STR_NOT);
+        _check_batch_render_operand(buffer, node->children[1], node->children[1]->child_count == 5);
+    } else {
+        // => groups to the right, everything else to the left, so only an
+        // operand on the other side at the same level needs parentheses.
+        size_t level = _check_batch_level(node);
+        bool right = node->children[2]->token->operator == WO_COND;
+        size_t left_level = _check_batch_level(node->children[1]);
+        size_t right_level = _check_batch_level(node->children[3]);
+        _check_batch_render_operand(buffer, node->children[1], left_level < level || (left_level == level && right));
+        check_buffer_append(buffer, " ");
+        check_buffer_append(buffer, wff_token_get_string(node->children[2]->token));
+        check_buffer_append(buffer, " ");
+        _check_batch_render_operand(buffer, node->children[3], right_level < level || (right_level == level && !right));
+    }
+}
+
+void _check_batch_render_operand(CheckBuffer* buffer, WffParseTreeNode* node, bool parenthesize) {
+    check_buffer_append(buffer, parenthesize ? "(" : "");
+    _check_batch_render(buffer, node);
+    check_buffer_append(buffer, parenthesize ? ")" : "");
+}
+
+// Index of the operator of 'node' in CHECK_BATCH_LEVELS, or the level count
+// if it isn't a binary operation.
+size_t _check_batch_level(WffParseTreeNode* node) {
+    if (node->child_count != 5) {
+        return CHECK_BATCH_LEVEL_COUNT;
+    }
+    size_t level = 0;
+    while (CHECK_BATCH_LEVELS[level] != node->children[2]->token->operator) {
+        level++;
+    }
+    return level;
+}
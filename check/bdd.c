@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "bdd.h"
+#include "bdd_internal.h"
+#include "generate.h"
+#include "check.h"
+
+// Cases between garbage collections, so that diagrams get built again from
+// a unique table that has had nodes freed.
+#define CHECK_BDD_GC_PERIOD 64
+
+bool _check_bdd_matches(WffBddManager* manager, WffBdd* bdd, Wff* wff);
+bool _check_bdd_reduced(WffBdd* bdd);
+bool _check_bdd_value(WffBddManager* manager, WffBdd* bdd, const size_t* level_ids, const bool* values);
+WffBdd* _check_bdd_format(WffBddManager* manager, const char* format, const char* x, const char* y, const char* z);
+
+
+// Each diagram against the truth table of its wff, row by row, and for being
+// reduced and ordered; then canonicity, with equivalent wffs getting the same
+// node and others not, and ITE and negation against the diagrams of the wffs
+// they stand for. A second manager orders the variables the other way round.
+void check_bdd(const CheckOptions* options) {
+    WffBddManager* managers[2] = {wff_bdd_manager_create(NULL), wff_bdd_manager_create("basrqp")};
+    WffGenerator generator;
+    check_generator_init(&generator, options, "bdd");
+    for (size_t i = 0; i < options->case_count; i++) {
+        WffBddManager* manager = managers[i % 2];
+        char* string1 = check_generate(&generator, i, options->max_nodes);
+        char* string2 = check_generate(&generator, i + 1, options->max_nodes);
+        char* string3 = check_generate(&generator, i + 2, options->max_nodes);
+        Wff* wff1 = wff_create(string1);
+        Wff* wff2 = wff_create(string2);
+        Wff* equivalent = check_equivalent_wff(wff1, i);
+
+        WffBdd* bdd1 = wff_bdd_create(manager, wff1);
+        WffBdd* bdd2 = wff_bdd_create(manager, wff2);
+        if (!_check_bdd_matches(manager, bdd1, wff1)) {
+            check_fail("wff_bdd_create", wff1, NULL);
+        }
+
+        CheckVariables variables;
+        check_variables(wff1, wff2, &variables);
+        bool expected = check_truth_table(wff1, &variables) == check_truth_table(wff2, &variables);
+        if ((bdd1 == bdd2) != expected || wff_bdd_equivalent(manager, wff1, wff2) != expected) {
+            check_fail("wff_bdd_equivalent", wff1, wff2);
+        }
+        if (equivalent != NULL) {
+            WffBdd* bdd = wff_bdd_create(manager, equivalent);
+            if (bdd != bdd1 || !wff_bdd_equivalent(manager, wff1, equivalent)) {
+                check_fail("wff_bdd_equivalent", wff1, equivalent);
+            }
+            wff_bdd_deref(bdd);
+            wff_destroy(equivalent);
+        }
+
+        WffBdd* negation = wff_bdd_not(manager, bdd1);
+        WffBdd* expected_negation = _check_bdd_format(manager, "~%s", string1, NULL, NULL);
+        if (negation != expected_negation) {
+            check_fail("wff_bdd_not", wff1, NULL);
+        }
+        wff_bdd_deref(expected_negation);
+        wff_bdd_deref(negation);
+
+        WffBdd* bdd3 = _check_bdd_format(manager, "%s", string3, NULL, NULL);
+        WffBdd* ite = wff_bdd_ite(manager, bdd1, bdd2, bdd3);
+        WffBdd* expected_ite = _check_bdd_format(manager, "((%s ^ %s) v (~%s ^ %s))", string1, string2, string3);
+        if (ite != expected_ite) {
+            check_fail("wff_bdd_ite", wff1, wff2);
+        }
+        wff_bdd_deref(expected_ite);
+        wff_bdd_deref(ite);
+        wff_bdd_deref(bdd3);
+        wff_bdd_deref(bdd2);
+        wff_bdd_deref(bdd1);
+
+        if (i % CHECK_BDD_GC_PERIOD == CHECK_BDD_GC_PERIOD - 1) {
+            wff_bdd_manager_gc(manager);
+        }
+        wff_destroy(wff2);
+        wff_destroy(wff1);
+        free(string3);
+        free(string2);
+        free(string1);
+    }
+    wff_bdd_manager_destroy(managers[1]);
+    wff_bdd_manager_destroy(managers[0]);
+}
+
+// Whether 'bdd' is reduced, ordered and has the value of 'wff' under every
+// assignment of its variables.
+bool _check_bdd_matches(WffBddManager* manager, WffBdd* bdd, Wff* wff) {
+    if (!_check_bdd_reduced(bdd)) {
+        return false;
+    }
+    size_t level_ids[WFF_VARIABLE_COUNT];
+    for (size_t id = 0; id < WFF_VARIABLE_COUNT; id++) {
+        if (manager->levels[id] >= 0) {
+            level_ids[manager->levels[id]] = id;
+        }
+    }
+    CheckVariables variables;
+    check_variables(wff, NULL, &variables);
+    uint64_t table = check_truth_table(wff, &variables);
+    bool values[WFF_VARIABLE_COUNT] = {false};
+    for (uint64_t row = 0; row < (1ULL << variables.count); row++) {
+        for (size_t k = 0; k < variables.count; k++) {
+            values[variables.ids[k]] = (row >> k) & 1;
+        }
+        if (_check_bdd_value(manager, bdd, level_ids, values) != ((table >> row) & 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// No node has equal children, and levels increase on the way down.
+bool _check_bdd_reduced(WffBdd* bdd) {
+    if (bdd->level == WFF_BDD_TERMINAL_LEVEL) {
+        return true;
+    }
+    return bdd->low != bdd->high && bdd->low->level > bdd->level && bdd->high->level > bdd->level &&
+           _check_bdd_reduced(bdd->low) && _check_bdd_reduced(bdd->high);
+}
+
+bool _check_bdd_value(WffBddManager* manager, WffBdd* bdd, const size_t* level_ids, const bool* values) {
+    while (bdd->level != WFF_BDD_TERMINAL_LEVEL) {
+        bdd = values[level_ids[bdd->level]] ? bdd->high : bdd->low;
+    }
+    return bdd == manager->one;
+}
+
+// The diagram of the wff 'format' makes of 'x', 'y', 'x' again and 'z', in
+// that order; a format may use only the first of them.
+WffBdd* _check_bdd_format(WffBddManager* manager, const char* format, const char* x, const char* y, const char* z) {
+    size_t length = strlen(format) + 2 * strlen(x) + (y == NULL ? 0 : strlen(y)) + (z == NULL ? 0 : strlen(z)) + 1;
+    char* string = malloc(length);
+    sprintf(string, format, x, y, x, z);
+    Wff* wff = wff_create(string);
+    WffBdd* bdd = wff_bdd_create(manager, wff);
+    wff_destroy(wff);
+    free(string);
+    return bdd;
+}
@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "rules.h"
+#include "rules_internal.h"
+#include "generate.h"
+#include "vector.h"
+#include "check.h"
+
+// Runs random wffs through each feature and checks every answer against
+// brute force, e.g. a naive evaluator or every outcome of a rewrite, with one
+// suite per feature in the other files here. Run with "make check"; see
+// check_usage for the options. Exits with status 1 if anything disagrees.
+
+const CheckSuite CHECK_SUITES[] = {
+    {"batch", check_batch},
+    {"bdd", check_bdd},
+    {"cursor", check_cursor},
+    {"eval", check_eval},
+    {"flat", check_flat},
+    {"infer", check_infer},
+    {"normal", check_normal},
+    {"parallel", check_parallel},
+    {"pattern", check_pattern},
+    {"preview", check_preview},
+    {"prover", check_prover},
+    {"sat", check_sat},
+    {"verify", check_verify},
+};
+#define CHECK_SUITE_COUNT (sizeof(CHECK_SUITES) / sizeof(CHECK_SUITES[0]))
+
+WffRuleIndex* check_rule_index = NULL;
+size_t check_failures = 0;
+
+
+void check_fail(const char* what, Wff* wff1, Wff* wff2) {
+    check_failures++;
+    if (wff2 == NULL) {
+        printf("FAIL %s: %s\n", what, wff_get_string(wff1));
+    } else {
+        printf("FAIL %s: %s and %s\n", what, wff_get_string(wff1), wff_get_string(wff2));
+    }
+    fflush(stdout);
+}
+
+void check_fail_string(const char* what, const char* string) {
+    check_failures++;
+    printf("FAIL %s: %s\n", what, string);
+    fflush(stdout);
+}
+
+void check_buffer_append(CheckBuffer* buffer, const char* string) {
+    size_t length = strlen(string);
+    if (buffer->length + length + 1 > buffer->capacity) {
+        buffer->capacity = 2 * (buffer->length + length + 1);
+        buffer->data = realloc(buffer->data, buffer->capacity);
+    }
+    memcpy(buffer->data + buffer->length, string, length + 1);
+    buffer->length += length;
+}
+
+void check_generator_init(WffGenerator* generator, const CheckOptions* options, const char* suite) {
+    // FNV-1a of the suite's name.
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (const char* c = suite; *c != '\0'; c++) {
+        hash = (hash ^ (unsigned char) *c) * 0x100000001B3ULL;
+    }
+    wff_generator_init(generator, options->seed ^ hash);
+}
+
+char* check_generate(WffGenerator* generator, size_t i, size_t max_nodes) {
+    generator->var_count = 1 + i % CHECK_MAX_VARIABLES;
+    return wff_generator_string(generator, 1 + (i / CHECK_MAX_VARIABLES) % max_nodes);
+}
+
+void _check_collect(WffParseTreeNode* node, bool* present) {
+    if (node->type == WPTNT_TERMINAL) {
+        if (node->token->type == WTT_PROPOSITION) {
+            present[node->token->variable->id] = true;
+        }
+        return;
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        _check_collect(node->children[i], present);
+    }
+}
+
+// Variables of 'wff1' and, if it isn't NULL, 'wff2'.
+void check_variables(Wff* wff1, Wff* wff2, CheckVariables* variables) {
+    bool present[WFF_VARIABLE_COUNT] = {false};
+    _check_collect(wff1->parse_tree->root, present);
+    if (wff2 != NULL) {
+        _check_collect(wff2->parse_tree->root, present);
+    }
+    variables->count = 0;
+    for (size_t id = 0; id < WFF_VARIABLE_COUNT; id++) {
+        if (present[id]) {
+            variables->ids[variables->count++] = id;
+        }
+    }
+}
+
+// The value of the subwff under 'values', indexed by variable ID, straight
+// from the definitions of the operators.
+bool check_evaluate(WffParseTreeNode* node, const bool* values) {
+    if (node->child_count == 1) {
+        WffToken* token = node->children[0]->token;
+        return token->type == WTT_CONSTANT ? token->value : values[token->variable->id];
+    } else if (node->child_count == 2) {
+        return !check_evaluate(node->children[1], values);
+    }
+    bool a = check_evaluate(node->children[1], values);
+    bool b = check_evaluate(node->children[3], values);
+    switch (node->children[2]->token->operator) {
+        case WO_AND:
+            return a && b;
+        case WO_OR:
+            return a || b;
+        case WO_COND:
+            return !a || b;
+        case WO_BICOND:
+            return a == b;
+        default:
+            printf("ERROR: Unhandled case\n");
+            abort();
+    }
+}
+
+uint64_t check_truth_table(Wff* wff, const CheckVariables* variables) {
+    uint64_t table = 0;
+    bool values[WFF_VARIABLE_COUNT] = {false};
+    for (uint64_t row = 0; row < (1ULL << variables->count); row++) {
+        for (size_t k = 0; k < variables->count; k++) {
+            values[variables->ids[k]] = (row >> k) & 1;
+        }
+        if (check_evaluate(wff->parse_tree->root, values)) {
+            table |= 1ULL << row;
+        }
+    }
+    return table;
+}
+
+// Every row of a table over 'variables'.
+uint64_t check_all_rows(const CheckVariables* variables) {
+    return variables->count == CHECK_MAX_VARIABLES ? UINT64_MAX : (1ULL << (1ULL << variables->count)) - 1;
+}
+
+// The value of the wff under an assignment reported by eval or SAT, with any
+// variable it leaves out false.
+bool check_assignment_value(Wff* wff, const WffEvalAssignment* assignment) {
+    bool values[WFF_VARIABLE_COUNT] = {false};
+    for (size_t i = 0; i < assignment->var_count; i++) {
+        values[_wff_variable_index(assignment->names[i])] = assignment->values[i];
+    }
+    return check_evaluate(wff->parse_tree->root, values);
+}
+
+Wff* check_equivalent_wff(Wff* wff, size_t i) {
+    WffRuleMatchList* matches = wff_rule_index_match(check_rule_index, wff);
+    size_t count = wff_rule_match_list_length(matches);
+    Wff* result = count == 0 ? NULL : wff_rule_match_rewrite(wff, wff_rule_match_list_get(matches, i % count));
+    check_match_list_destroy(matches);
+    return result;
+}
+
+void check_match_list_destroy(WffRuleMatchList* list) {
+    WffVectorIterator iterator = wff_rule_match_list_iterate(list);
+    for (WffRuleMatch* match = wff_rule_match_list_next(&iterator); match != NULL; match = wff_rule_match_list_next(&iterator)) {
+        wff_rule_match_destroy(match);
+    }
+    wff_rule_match_list_destroy(list);
+}
+
+// Appends the sites in the subtree of 'node' where 'search' matches.
+void check_pattern_sites(WffParseTreeNode* node, WffParseTreeNode* search, size_t* site, WffVector* sites) {
+    if (node->type != WPTNT_NONTERMINAL) {
+        return;
+    }
+    WffParseTreeNode* bindings[WFF_VARIABLE_COUNT] = {NULL};
+    if (check_pattern_match(node, search, bindings)) {
+        wff_vector_append(sites, &(CheckSite){*site, node});
+    }
+    (*site)++;
+    for (int i = 0; i < node->child_count; i++) {
+        check_pattern_sites(node->children[i], search, site, sites);
+    }
+}
+
+// Whether 'search', parsed as an ordinary wff, matches at 'node', with each of
+// its variables standing for any subwff, the same one every time it occurs.
+bool check_pattern_match(WffParseTreeNode* node, WffParseTreeNode* search, WffParseTreeNode** bindings) {
+    if (search->type == WPTNT_NONTERMINAL && search->child_count == 1 && search->children[0]->token->type == WTT_PROPOSITION) {
+        size_t id = search->children[0]->token->variable->id;
+        if (bindings[id] != NULL && !check_pattern_equal(bindings[id], node)) {
+            return false;
+        }
+        bindings[id] = node;
+        return true;
+    }
+    if (node->type != search->type) {
+        return false;
+    }
+    if (node->type == WPTNT_TERMINAL) {
+        return wff_token_equal(node->token, search->token);
+    }
+    if (node->child_count != search->child_count) {
+        return false;
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        if (!check_pattern_match(node->children[i], search->children[i], bindings)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool check_pattern_equal(WffParseTreeNode* node1, WffParseTreeNode* node2) {
+    if (node1->type != node2->type || node1->child_count != node2->child_count) {
+        return false;
+    }
+    if (node1->type == WPTNT_TERMINAL) {
+        return wff_token_equal(node1->token, node2->token);
+    }
+    for (int i = 0; i < node1->child_count; i++) {
+        if (!check_pattern_equal(node1->children[i], node2->children[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void check_usage() {
+    fprintf(stderr, "Usage: check [-s seed] [-n cases per suite] [-m max nodes] [-o only this suite]\n");
+}
+
+bool check_parse_size(const char* string, size_t* value) {
+    char* end;
+    unsigned long long parsed = strtoull(string, &end, 10);
+    if (*string == '\0' || *string == '-' || *end != '\0') {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    size_t seed = 1;
+    CheckOptions options = {.case_count = 2000, .max_nodes = 40};
+    const char* only = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 == argc || argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0') {
+            check_usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        bool valid;
+        switch (argv[i - 1][1]) {
+            case 's':
+                valid = check_parse_size(value, &seed);
+                break;
+            case 'n':
+                valid = check_parse_size(value, &options.case_count);
+                break;
+            case 'm':
+                valid = check_parse_size(value, &options.max_nodes) && options.max_nodes >= 1;
+                break;
+            case 'o':
+                only = value;
+                valid = false;
+                for (size_t k = 0; k < CHECK_SUITE_COUNT; k++) {
+                    valid = valid || strcmp(CHECK_SUITES[k].name, value) == 0;
+                }
+                break;
+            default:
+                valid = false;
+        }
+        if (!valid) {
+            fprintf(stderr, "ERROR: Invalid value %s for %s\n", value, argv[i - 1]);
+            check_usage();
+            return 1;
+        }
+    }
+    options.seed = seed;
+
+    check_rule_index = wff_rule_index_create(WFF_RULES, WFF_RULE_COUNT);
+    printf("seed %zu, %zu cases per suite, up to %zu nodes\n\n", seed, options.case_count, options.max_nodes);
+    size_t total = 0;
+    for (size_t i = 0; i < CHECK_SUITE_COUNT; i++) {
+        const CheckSuite* suite = &CHECK_SUITES[i];
+        if (only != NULL && strcmp(suite->name, only) != 0) {
+            continue;
+        }
+        check_failures = 0;
+        suite->run(&options);
+        printf("%-10s %s\n", suite->name, check_failures == 0 ? "ok" : "FAILED");
+        fflush(stdout);
+        total += check_failures;
+    }
+    wff_rule_index_destroy(check_rule_index);
+
+    printf("\n%zu failures\n", total);
+    return total == 0 ? 0 : 1;
+}
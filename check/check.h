@@ -0,0 +1,107 @@
+#ifndef CHECK_H_
+#define CHECK_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "eval.h"
+#include "rules.h"
+#include "generate.h"
+#include "vector.h"
+
+typedef struct CheckBuffer CheckBuffer;
+typedef struct CheckOptions CheckOptions;
+typedef struct CheckSite CheckSite;
+typedef struct CheckSuite CheckSuite;
+typedef struct CheckVariables CheckVariables;
+
+// Variables per wff, so that a truth table fits in one word.
+#define CHECK_MAX_VARIABLES 6
+
+
+// A string built up piece by piece; 'data' is NULL until the first append
+// and then the caller's to free.
+struct CheckBuffer {
+    char* data;
+    size_t length;
+    size_t capacity;
+};
+
+struct CheckOptions {
+    uint64_t seed;
+    size_t case_count;
+    // Largest wff drawn, in variables and operators. Suites that try every
+    // outcome of a wff draw smaller ones.
+    size_t max_nodes;
+};
+
+// A site where a search expression matches, numbered in preorder over the
+// nonterminals like WffMatch::site.
+struct CheckSite {
+    size_t site;
+    WffParseTreeNode* root;
+};
+
+// One feature's checks, which draw 'case_count' wffs of their own and report
+// each disagreement with check_fail.
+struct CheckSuite {
+    const char* name;
+    void (*run)(const CheckOptions* options);
+};
+
+// Variables of one or two wffs, by ID in increasing order. Row i of a truth
+// table over them sets ids[k] to bit k of i.
+struct CheckVariables {
+    size_t ids[WFF_VARIABLE_COUNT];
+    size_t count;
+};
+
+
+// The rule library, indexed once for every suite.
+extern WffRuleIndex* check_rule_index;
+extern size_t check_failures;
+
+
+void check_fail(const char* what, Wff* wff1, Wff* wff2);
+void check_fail_string(const char* what, const char* string);
+void check_buffer_append(CheckBuffer* buffer, const char* string);
+// A generator for a suite, seeded so that suites don't depend on each other.
+void check_generator_init(WffGenerator* generator, const CheckOptions* options, const char* suite);
+// The i'th wff of a suite: sizes and variable counts cycle so that small
+// wffs, constants and repeats all turn up. The caller frees it.
+char* check_generate(WffGenerator* generator, size_t i, size_t max_nodes);
+
+void check_variables(Wff* wff1, Wff* wff2, CheckVariables* variables);
+bool check_evaluate(WffParseTreeNode* node, const bool* values);
+uint64_t check_truth_table(Wff* wff, const CheckVariables* variables);
+uint64_t check_all_rows(const CheckVariables* variables);
+bool check_assignment_value(Wff* wff, const WffEvalAssignment* assignment);
+// A wff equivalent to 'wff': its i'th outcome (wrapping around) under the
+// rule library, or NULL if no rule applies. The caller destroys it.
+Wff* check_equivalent_wff(Wff* wff, size_t i);
+void check_match_list_destroy(WffRuleMatchList* list);
+// A naive matcher, which tries each site of the tree in turn.
+void check_pattern_sites(WffParseTreeNode* node, WffParseTreeNode* search, size_t* site, WffVector* sites);
+bool check_pattern_match(WffParseTreeNode* node, WffParseTreeNode* search, WffParseTreeNode** bindings);
+bool check_pattern_equal(WffParseTreeNode* node1, WffParseTreeNode* node2);
+
+
+/* === Suites === */
+void check_batch(const CheckOptions* options);
+void check_bdd(const CheckOptions* options);
+void check_cursor(const CheckOptions* options);
+void check_eval(const CheckOptions* options);
+void check_flat(const CheckOptions* options);
+void check_infer(const CheckOptions* options);
+void check_normal(const CheckOptions* options);
+void check_parallel(const CheckOptions* options);
+void check_pattern(const CheckOptions* options);
+void check_preview(const CheckOptions* options);
+void check_prover(const CheckOptions* options);
+void check_sat(const CheckOptions* options);
+void check_verify(const CheckOptions* options);
+
+#endif
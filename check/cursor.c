@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "vector.h"
+#include "generate.h"
+#include "check.h"
+
+// Search and replace expressions tried on every wff, one of them without
+// variables.
+const char* const CHECK_CURSOR_PATTERNS[][2] = {
+    {"(a ^ b)", "(b ^ a)"},
+    {"~~a", "a"},
+    {"(a v a)", "a"},
+    {"~T", "F"},
+    {"((a => b) v c)", "(c v (~b => ~a))"},
+    {"a", "~~a"},
+};
+#define CHECK_CURSOR_PATTERN_COUNT (sizeof(CHECK_CURSOR_PATTERNS) / sizeof(CHECK_CURSOR_PATTERNS[0]))
+
+// Variables binding is asked about: those of the patterns and one that's in
+// none of them.
+#define CHECK_CURSOR_VARIABLES "abcy"
+
+void _check_cursor_wff(Wff* wff, size_t i, size_t k);
+bool _check_cursor_none(WffOutcomeCursor* cursor);
+bool _check_cursor_at(WffOutcomeCursor* cursor, size_t index, WffVector* sites, char** outcomes, Wff* search);
+
+
+// Walks every outcome of a set of patterns with next, prev and seek in turn,
+// checking each against the naive matcher's sites and bindings and against
+// wff_pattern_rewrite. next wraps from the last outcome to the first and prev
+// from the first to the last; seek past the end stays put.
+void check_cursor(const CheckOptions* options) {
+    WffGenerator generator;
+    check_generator_init(&generator, options, "cursor");
+    for (size_t i = 0; i < options->case_count; i++) {
+        char* string = check_generate(&generator, i, options->max_nodes);
+        // The generator only writes variables, so some become constants.
+        if (i % 2 == 0) {
+            for (char* c = string; *c != '\0'; c++) {
+                *c = *c == 'r' ? 'T' : *c == 's' ? 'F' : *c;
+            }
+        }
+        Wff* wff = wff_create(string);
+        for (size_t k = 0; k < CHECK_CURSOR_PATTERN_COUNT; k++) {
+            _check_cursor_wff(wff, i, k);
+        }
+        wff_destroy(wff);
+        free(string);
+    }
+}
+
+// Pattern k on one wff, walked one of three ways by i.
+void _check_cursor_wff(Wff* wff, size_t i, size_t k) {
+    WffPattern* pattern = wff_pattern_create(CHECK_CURSOR_PATTERNS[k][0], CHECK_CURSOR_PATTERNS[k][1]);
+    Wff* search = wff_create(CHECK_CURSOR_PATTERNS[k][0]);
+    WffVector sites;
+    wff_vector_init(&sites, sizeof(CheckSite), NULL);
+    size_t site = 0;
+    check_pattern_sites(wff->parse_tree->root, search->parse_tree->root, &site, &sites);
+    size_t count = wff_vector_length(&sites);
+    char* outcomes[count];
+    for (size_t j = 0; j < count; j++) {
+        Wff* result = wff_pattern_rewrite(wff, pattern, j);
+        outcomes[j] = result == NULL ? NULL : wff_parse_tree_get_subwff_string(result->parse_tree->root);
+        if (result != NULL) {
+            wff_destroy(result);
+        }
+    }
+
+    WffOutcomeCursor* cursor = wff_outcome_cursor_create(wff, pattern);
+    bool valid = _check_cursor_none(cursor);
+    if (count == 0) {
+        valid = valid && !wff_outcome_cursor_next(cursor) && !wff_outcome_cursor_prev(cursor) &&
+                !wff_outcome_cursor_seek(cursor, 0) && _check_cursor_none(cursor);
+    } else if (i % 3 == 0) {
+        // Outcomes are found one at a time, and next goes round again.
+        for (size_t j = 0; j <= count && valid; j++) {
+            valid = wff_outcome_cursor_next(cursor) && _check_cursor_at(cursor, j % count, &sites, outcomes, search) &&
+                    wff_outcome_cursor_count(cursor) >= (j < count ? j + 1 : count);
+        }
+        valid = valid && wff_outcome_cursor_count(cursor) == count;
+    } else if (i % 3 == 1) {
+        // The first prev finds them all, and prev goes round again.
+        for (size_t j = 0; j <= count && valid; j++) {
+            valid = wff_outcome_cursor_prev(cursor) && _check_cursor_at(cursor, (2 * count - 1 - j) % count, &sites, outcomes, search) &&
+                    wff_outcome_cursor_count(cursor) == count;
+        }
+    } else {
+        // Seeking back and forth, and past the end, which stays put.
+        for (size_t j = 0; j < count && valid; j++) {
+            size_t index = (j % 2 == 0 ? j / 2 : count - 1 - j / 2);
+            valid = wff_outcome_cursor_seek(cursor, index) && _check_cursor_at(cursor, index, &sites, outcomes, search) &&
+                    !wff_outcome_cursor_seek(cursor, count + j) && _check_cursor_at(cursor, index, &sites, outcomes, search);
+        }
+    }
+    if (!valid) {
+        check_fail(CHECK_CURSOR_PATTERNS[k][0], wff, NULL);
+    }
+    wff_outcome_cursor_destroy(cursor);
+
+    for (size_t j = 0; j < count; j++) {
+        free(outcomes[j]);
+    }
+    wff_vector_finish(&sites);
+    wff_destroy(search);
+    wff_pattern_destroy(pattern);
+}
+
+// Whether the cursor has no current outcome.
+bool _check_cursor_none(WffOutcomeCursor* cursor) {
+    char* string = wff_outcome_cursor_string(cursor);
+    Wff* rewrite = wff_outcome_cursor_rewrite(cursor);
+    char* binding = wff_outcome_cursor_binding(cursor, "a");
+    bool none = wff_outcome_cursor_index(cursor) == WFF_OUTCOME_NONE && wff_outcome_cursor_site(cursor) == WFF_OUTCOME_NONE &&
+                string == NULL && rewrite == NULL && binding == NULL;
+    free(binding);
+    free(string);
+    if (rewrite != NULL) {
+        wff_destroy(rewrite);
+    }
+    return none;
+}
+
+// Whether the cursor is on outcome 'index': its site, what each variable is
+// bound to there and the wff it leaves.
+bool _check_cursor_at(WffOutcomeCursor* cursor, size_t index, WffVector* sites, char** outcomes, Wff* search) {
+    CheckSite* expected = wff_vector_get(sites, index);
+    if (wff_outcome_cursor_index(cursor) != index || wff_outcome_cursor_site(cursor) != expected->site) {
+        return false;
+    }
+    WffParseTreeNode* bindings[WFF_VARIABLE_COUNT] = {NULL};
+    check_pattern_match(expected->root, search->parse_tree->root, bindings);
+    bool valid = true;
+    for (const char* c = CHECK_CURSOR_VARIABLES; *c != '\0'; c++) {
+        char variable[2] = {*c, '\0'};
+        WffParseTreeNode* binding = bindings[_wff_variable_index(*c)];
+        char* expected_binding = binding == NULL ? NULL : wff_parse_tree_get_subwff_string(binding);
+        char* actual_binding = wff_outcome_cursor_binding(cursor, variable);
+        valid = valid && (expected_binding == NULL ? actual_binding == NULL :
+                          actual_binding != NULL && strcmp(actual_binding, expected_binding) == 0);
+        free(actual_binding);
+        free(expected_binding);
+    }
+
+    char* string = wff_outcome_cursor_string(cursor);
+    Wff* rewrite = wff_outcome_cursor_rewrite(cursor);
+    char* rewrite_string = rewrite == NULL ? NULL : wff_parse_tree_get_subwff_string(rewrite->parse_tree->root);
+    valid = valid && outcomes[index] != NULL && string != NULL && rewrite_string != NULL &&
+            strcmp(string, outcomes[index]) == 0 && strcmp(rewrite_string, outcomes[index]) == 0;
+    free(rewrite_string);
+    free(string);
+    if (rewrite != NULL) {
+        wff_destroy(rewrite);
+    }
+    return valid;
+}
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "eval.h"
+#include "generate.h"
+#include "check.h"
+
+// Variables of the wffs too wide for a truth table here, which take the
+// evaluator past one word of assignments.
+#define CHECK_EVAL_WIDE_VARIABLES 12
+
+Wff* _check_eval_create(const char* format, const char* string);
+
+
+// The verdicts of the truth-table evaluator against the naive one, then on
+// wffs with too many variables for that, whose verdicts are known by
+// construction: X v ~X is a tautology and X ^ ~X a contradiction.
+void check_eval(const CheckOptions* options) {
+    WffGenerator generator;
+    check_generator_init(&generator, options, "eval");
+    for (size_t i = 0; i < options->case_count; i++) {
+        char* string1 = check_generate(&generator, i, options->max_nodes);
+        char* string2 = check_generate(&generator, i + 1, options->max_nodes);
+        Wff* wff1 = wff_create(string1);
+        Wff* wff2 = wff_create(string2);
+        CheckVariables variables;
+        check_variables(wff1, NULL, &variables);
+        uint64_t table = check_truth_table(wff1, &variables);
+        bool tautology = table == check_all_rows(&variables);
+        bool contradiction = table == 0;
+
+        WffEvalVerdict verdict = wff_eval_classify(wff1);
+        if (verdict != (tautology ? WEV_TAUTOLOGY : contradiction ? WEV_CONTRADICTION : WEV_CONTINGENT) ||
+            wff_eval_is_tautology(wff1) != tautology || wff_eval_is_contradiction(wff1) != contradiction) {
+            check_fail("wff_eval_classify", wff1, NULL);
+        }
+
+        Wff* equivalent = check_equivalent_wff(wff1, i);
+        Wff* pairs[2] = {equivalent, wff2};
+        for (size_t k = 0; k < 2; k++) {
+            if (pairs[k] == NULL) {
+                continue;
+            }
+            check_variables(wff1, pairs[k], &variables);
+            bool expected = check_truth_table(wff1, &variables) == check_truth_table(pairs[k], &variables);
+            if (wff_eval_equivalent(wff1, pairs[k]) != expected) {
+                check_fail("wff_eval_equivalent", wff1, pairs[k]);
+            }
+        }
+        if (equivalent != NULL) {
+            wff_destroy(equivalent);
+        }
+        wff_destroy(wff2);
+        wff_destroy(wff1);
+        free(string2);
+        free(string1);
+
+        generator.var_count = CHECK_MAX_VARIABLES + 1 + i % (CHECK_EVAL_WIDE_VARIABLES - CHECK_MAX_VARIABLES);
+        char* string = wff_generator_string(&generator, generator.var_count + i % options->max_nodes);
+        Wff* wide = _check_eval_create("%s", string);
+        Wff* valid = _check_eval_create("(%s v ~%s)", string);
+        Wff* invalid = _check_eval_create("(%s ^ ~%s)", string);
+        if (wff_eval_classify(valid) != WEV_TAUTOLOGY || wff_eval_classify(invalid) != WEV_CONTRADICTION) {
+            check_fail("wff_eval_classify", valid, invalid);
+        }
+        // ~X is equivalent to X => ~X, and never to X.
+        Wff* negation = _check_eval_create("~%s", string);
+        Wff* implies_negation = _check_eval_create("(%s => ~%s)", string);
+        if (!wff_eval_equivalent(negation, implies_negation) || wff_eval_equivalent(negation, wide)) {
+            check_fail("wff_eval_equivalent", wide, negation);
+        }
+        wff_destroy(implies_negation);
+        wff_destroy(negation);
+        wff_destroy(invalid);
+        wff_destroy(valid);
+        wff_destroy(wide);
+        free(string);
+    }
+}
+
+// The wff 'format' makes of 'string', which takes the place of each %s.
+Wff* _check_eval_create(const char* format, const char* string) {
+    char* built = malloc(strlen(format) + 2 * strlen(string) + 1);
+    sprintf(built, format, string, string);
+    Wff* wff = wff_create(built);
+    free(built);
+    return wff;
+}
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "flat.h"
+#include "vector.h"
+#include "generate.h"
+#include "check.h"
+
+// Search and replace expressions tried on every wff.
+const char* const CHECK_FLAT_PATTERNS[][2] = {
+    {"(a ^ b)", "(b ^ a)"},
+    {"~~a", "a"},
+    {"(a v a)", "a"},
+    {"~T", "F"},
+    {"(a => b)", "(~b => ~z)"},
+    {"a", "~~a"},
+};
+#define CHECK_FLAT_PATTERN_COUNT (sizeof(CHECK_FLAT_PATTERNS) / sizeof(CHECK_FLAT_PATTERNS[0]))
+
+// Strings that aren't wffs, which neither parser may accept.
+const char* const CHECK_FLAT_INVALID[] = {"", "(p ^ q", "p q", "(p ~ q)", "~", "(p ^ q))", "((p))"};
+#define CHECK_FLAT_INVALID_COUNT (sizeof(CHECK_FLAT_INVALID) / sizeof(CHECK_FLAT_INVALID[0]))
+
+void _check_flat_sites(WffParseTreeNode* node, WffVector* sites);
+void _check_flat_patterns(Wff* wff, WffFlatTree* tree, size_t i);
+
+
+// The flat tree against the parse tree of the same wff: a node per site, in
+// the same order and rendering the same; variables, subtree equality,
+// matching and substitution against their parse tree counterparts.
+void check_flat(const CheckOptions* options) {
+    for (size_t k = 0; k < CHECK_FLAT_INVALID_COUNT; k++) {
+        WffFlatTree* tree = wff_flat_tree_create(CHECK_FLAT_INVALID[k]);
+        if (tree != NULL) {
+            check_fail_string("wff_flat_tree_create of an invalid wff", CHECK_FLAT_INVALID[k]);
+            wff_flat_tree_destroy(tree);
+        }
+    }
+
+    WffGenerator generator;
+    check_generator_init(&generator, options, "flat");
+    for (size_t i = 0; i < options->case_count; i++) {
+        char* string = check_generate(&generator, i, options->max_nodes);
+        // The generator only writes variables, so some become constants.
+        if (i % 2 == 0) {
+            for (char* c = string; *c != '\0'; c++) {
+                *c = *c == 'r' ? 'T' : *c == 's' ? 'F' : *c;
+            }
+        }
+        char* other_string = check_generate(&generator, i + 1, options->max_nodes);
+        Wff* wff = wff_create(string);
+        WffFlatTree* tree = wff_flat_tree_create(string);
+        WffFlatTree* converted = wff_flat_tree_from_parse_tree(wff->parse_tree);
+        WffFlatTree* other = wff_flat_tree_create(other_string);
+        if (tree == NULL || other == NULL) {
+            check_fail("wff_flat_tree_create", wff, NULL);
+            wff_flat_tree_destroy(converted);
+            if (tree != NULL) {
+                wff_flat_tree_destroy(tree);
+            }
+            if (other != NULL) {
+                wff_flat_tree_destroy(other);
+            }
+            wff_destroy(wff);
+            free(other_string);
+            free(string);
+            continue;
+        }
+
+        WffVector sites;
+        wff_vector_init(&sites, sizeof(WffParseTreeNode*), NULL);
+        _check_flat_sites(wff->parse_tree->root, &sites);
+        size_t length = wff_vector_length(&sites);
+        if (wff_flat_tree_length(tree) != length || wff_flat_tree_length(converted) != length) {
+            check_fail("wff_flat_tree_length", wff, NULL);
+            length = 0;
+        }
+        size_t var_count = 0;
+        for (size_t s = 0; s < length; s++) {
+            WffParseTreeNode* node = *(WffParseTreeNode**) wff_vector_get(&sites, s);
+            char* expected = wff_parse_tree_get_subwff_string(node);
+            char* actual = wff_flat_tree_get_subwff_string(tree, s);
+            char* actual_converted = wff_flat_tree_get_subwff_string(converted, s);
+            if (strcmp(actual, expected) != 0 || strcmp(actual_converted, expected) != 0) {
+                check_fail("wff_flat_tree_get_subwff_string", wff, NULL);
+            }
+            var_count += node->child_count == 1 && node->children[0]->token->type == WTT_PROPOSITION;
+            free(actual_converted);
+            free(actual);
+            free(expected);
+        }
+        size_t indices[wff_flat_tree_length(tree)];
+        size_t found = wff_flat_tree_find_vars(tree, indices);
+        bool vars_agree = found == var_count;
+        for (size_t k = 0; k < found && vars_agree; k++) {
+            char* variable = wff_flat_tree_get_subwff_string(tree, indices[k]);
+            vars_agree = strlen(variable) == 1 && _wff_variable_index(variable[0]) >= 0;
+            free(variable);
+        }
+        if (!vars_agree) {
+            check_fail("wff_flat_tree_find_vars", wff, NULL);
+        }
+
+        // Subtrees are equal iff they render the same.
+        for (size_t k = 0; k < length; k++) {
+            size_t index1 = (i + 7 * k) % length;
+            size_t index2 = k % wff_flat_tree_length(other);
+            const WffFlatTree* trees[2] = {tree, other};
+            size_t indices2[2] = {k, index2};
+            for (size_t t = 0; t < 2; t++) {
+                char* string1 = wff_flat_tree_get_subwff_string(tree, index1);
+                char* string2 = wff_flat_tree_get_subwff_string(trees[t], indices2[t]);
+                if (wff_flat_tree_subtree_equals(tree, index1, trees[t], indices2[t]) != (strcmp(string1, string2) == 0)) {
+                    check_fail_string("wff_flat_tree_subtree_equals", string1);
+                }
+                free(string2);
+                free(string1);
+            }
+        }
+
+        _check_flat_patterns(wff, tree, i);
+
+        wff_vector_finish(&sites);
+        wff_flat_tree_destroy(other);
+        wff_flat_tree_destroy(converted);
+        wff_flat_tree_destroy(tree);
+        wff_destroy(wff);
+        free(other_string);
+        free(string);
+    }
+}
+
+// Each pattern must match at the sites the outcome cursor finds, and
+// substituting at each must give what wff_pattern_rewrite does there.
+void _check_flat_patterns(Wff* wff, WffFlatTree* tree, size_t i) {
+    size_t length = wff_flat_tree_length(tree);
+    for (size_t k = 0; k < CHECK_FLAT_PATTERN_COUNT; k++) {
+        WffPattern* pattern = wff_pattern_create(CHECK_FLAT_PATTERNS[k][0], CHECK_FLAT_PATTERNS[k][1]);
+        WffFlatTree* search = wff_flat_tree_create(CHECK_FLAT_PATTERNS[k][0]);
+        WffFlatTree* replace = wff_flat_tree_create(CHECK_FLAT_PATTERNS[k][1]);
+        size_t sites[length];
+        size_t count = wff_flat_tree_match(tree, search, sites);
+
+        WffOutcomeCursor* cursor = wff_outcome_cursor_create(wff, pattern);
+        bool agree = true;
+        for (size_t j = 0; j < count && agree; j++) {
+            if (!wff_outcome_cursor_seek(cursor, j) || wff_outcome_cursor_site(cursor) != sites[j]) {
+                agree = false;
+                break;
+            }
+            WffFlatTree* result = wff_flat_tree_substitute(tree, sites[j], search, replace);
+            Wff* expected = wff_pattern_rewrite(wff, pattern, j);
+            char* actual_string = result == NULL ? NULL : wff_flat_tree_get_subwff_string(result, 0);
+            char* expected_string = wff_parse_tree_get_subwff_string(expected->parse_tree->root);
+            agree = actual_string != NULL && strcmp(actual_string, expected_string) == 0;
+            free(expected_string);
+            free(actual_string);
+            wff_destroy(expected);
+            if (result != NULL) {
+                wff_flat_tree_destroy(result);
+            }
+        }
+        agree = agree && !wff_outcome_cursor_seek(cursor, count);
+        wff_outcome_cursor_destroy(cursor);
+
+        // Somewhere it doesn't match, substitution must refuse.
+        size_t site = i % (length + 1);
+        bool matches = false;
+        for (size_t j = 0; j < count; j++) {
+            matches = matches || sites[j] == site;
+        }
+        WffFlatTree* refused = matches ? NULL : wff_flat_tree_substitute(tree, site, search, replace);
+        if (refused != NULL) {
+            agree = false;
+            wff_flat_tree_destroy(refused);
+        }
+        if (!agree) {
+            check_fail(CHECK_FLAT_PATTERNS[k][0], wff, NULL);
+        }
+        wff_flat_tree_destroy(replace);
+        wff_flat_tree_destroy(search);
+        wff_pattern_destroy(pattern);
+    }
+}
+
+// The nonterminals of the tree in preorder, as sites are numbered.
+void _check_flat_sites(WffParseTreeNode* node, WffVector* sites) {
+    if (node->type != WPTNT_NONTERMINAL) {
+        return;
+    }
+    wff_vector_append(sites, &node);
+    for (int i = 0; i < node->child_count; i++) {
+        _check_flat_sites(node->children[i], sites);
+    }
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "sat.h"
+#include "normal.h"
+#include "generate.h"
+#include "check.h"
+
+// Conjunctions a DNF may take before wff_normal_dnf gives up.
+#define CHECK_NORMAL_MAX_TERMS 256
+
+bool _check_normal_is_literal(WffParseTreeNode* node);
+bool _check_normal_is_nnf(WffParseTreeNode* node);
+bool _check_normal_is_dnf(WffParseTreeNode* node);
+size_t _check_normal_flatten(WffParseTreeNode* node, WffOperator operator, WffParseTreeNode** parts, size_t count);
+
+
+// Each normal form against the truth table of the wff and for its shape: NNF
+// has ~ only on variables, and converting it again changes nothing; DNF is
+// a disjunction of conjunctions, each with its variables in alphabetical
+// order, shortest first and none repeated. The CNF is satisfiable iff the
+// wff is, by a model that satisfies the wff.
+void check_normal(const CheckOptions* options) {
+    WffGenerator generator;
+    check_generator_init(&generator, options, "normal");
+    for (size_t i = 0; i < options->case_count; i++) {
+        char* string = check_generate(&generator, i, options->max_nodes);
+        Wff* wff = wff_create(string);
+        CheckVariables variables;
+        check_variables(wff, NULL, &variables);
+        uint64_t table = check_truth_table(wff, &variables);
+
+        Wff* nnf = wff_normal_nnf(wff);
+        if (!_check_normal_is_nnf(nnf->parse_tree->root) || check_truth_table(nnf, &variables) != table) {
+            check_fail("wff_normal_nnf", wff, nnf);
+        }
+        Wff* again = wff_normal_nnf(nnf);
+        if (strcmp(wff_get_string(again), wff_get_string(nnf)) != 0) {
+            check_fail("wff_normal_nnf of an NNF", nnf, again);
+        }
+        wff_destroy(again);
+        wff_destroy(nnf);
+
+        Wff* dnf = wff_normal_dnf(wff, CHECK_NORMAL_MAX_TERMS);
+        if (dnf != NULL) {
+            if (!_check_normal_is_dnf(dnf->parse_tree->root) || check_truth_table(dnf, &variables) != table) {
+                check_fail("wff_normal_dnf", wff, dnf);
+            }
+            wff_destroy(dnf);
+        }
+
+        // The wff's variables come first in the CNF, in order of ID.
+        WffCnf* cnf = wff_normal_cnf(wff);
+        bool* model = malloc((wff_cnf_var_count(cnf) + 1) * sizeof(bool));
+        bool satisfiable = wff_sat_solve(cnf, model);
+        bool values[WFF_VARIABLE_COUNT] = {false};
+        for (size_t k = 0; satisfiable && k < variables.count; k++) {
+            values[variables.ids[k]] = model[k + 1];
+        }
+        if (satisfiable != (table != 0) || (satisfiable && !check_evaluate(wff->parse_tree->root, values))) {
+            check_fail("wff_normal_cnf", wff, NULL);
+        }
+        free(model);
+        wff_cnf_destroy(cnf);
+
+        wff_destroy(wff);
+        free(string);
+    }
+}
+
+bool _check_normal_is_literal(WffParseTreeNode* node) {
+    if (node->child_count == 2) {
+        node = node->children[1];
+    }
+    return node->child_count == 1 && node->children[0]->token->type == WTT_PROPOSITION;
+}
+
+bool _check_normal_is_nnf(WffParseTreeNode* node) {
+    if (node->child_count == 1) {
+        return true;
+    } else if (node->child_count == 2) {
+        return _check_normal_is_literal(node);
+    }
+    WffOperator operator = node->children[2]->token->operator;
+    return (operator == WO_AND || operator == WO_OR) && _check_normal_is_nnf(node->children[1]) &&
+           _check_normal_is_nnf(node->children[3]);
+}
+
+// A constant, or conjunctions of literals over increasing variable IDs, no
+// shorter than the one before and no two the same.
+bool _check_normal_is_dnf(WffParseTreeNode* node) {
+    if (node->child_count == 1 && node->children[0]->token->type == WTT_CONSTANT) {
+        return true;
+    }
+    size_t term_count = _check_normal_flatten(node, WO_OR, NULL, 0);
+    WffParseTreeNode* terms[term_count];
+    _check_normal_flatten(node, WO_OR, terms, 0);
+    size_t last_length = 0;
+    for (size_t t = 0; t < term_count; t++) {
+        size_t length = _check_normal_flatten(terms[t], WO_AND, NULL, 0);
+        WffParseTreeNode* literals[length];
+        _check_normal_flatten(terms[t], WO_AND, literals, 0);
+        if (length < last_length) {
+            return false;
+        }
+        last_length = length;
+        size_t last_id = 0;
+        for (size_t k = 0; k < length; k++) {
+            if (!_check_normal_is_literal(literals[k])) {
+                return false;
+            }
+            WffParseTreeNode* atom = literals[k]->child_count == 2 ? literals[k]->children[1] : literals[k];
+            size_t id = atom->children[0]->token->variable->id;
+            if (k > 0 && id <= last_id) {
+                return false;
+            }
+            last_id = id;
+        }
+        // Both come from the same hash-consed tree, so equal terms are the
+        // same node.
+        for (size_t u = 0; u < t; u++) {
+            if (terms[u] == terms[t]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Writes the operands of a chain of 'operator' at 'parts', from index
+// 'count' on, unless 'parts' is NULL, and returns the new count.
+size_t _check_normal_flatten(WffParseTreeNode* node, WffOperator operator, WffParseTreeNode** parts, size_t count) {
+    if (node->child_count == 5 && node->children[2]->token->operator == operator) {
+        count = _check_normal_flatten(node->children[1], operator, parts, count);
+        return _check_normal_flatten(node->children[3], operator, parts, count);
+    }
+    if (parts != NULL) {
+        parts[count] = node;
+    }
+    return count + 1;
+}
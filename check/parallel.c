@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "eval.h"
+#include "generate.h"
+#include "check.h"
+
+// Threads tried, from one up; the sweep splits the assignments among them.
+#define CHECK_PARALLEL_MAX_THREADS 4
+// Variables of the wide wffs, enough for each thread to get many words of
+// assignments.
+#define CHECK_PARALLEL_WIDE_VARIABLES 16
+
+void _check_parallel_tautology(Wff* wff, bool expected, size_t thread_count);
+
+
+// The parallel sweep, with each number of threads, against the naive
+// evaluator, with any counterexample it gives checked. Then wide wffs, where
+// X v ~X must be valid and any counterexample given for X must falsify it.
+void check_parallel(const CheckOptions* options) {
+    WffGenerator generator;
+    check_generator_init(&generator, options, "parallel");
+    for (size_t i = 0; i < options->case_count; i++) {
+        size_t thread_count = 1 + i % CHECK_PARALLEL_MAX_THREADS;
+        char* string1 = check_generate(&generator, i, options->max_nodes);
+        char* string2 = check_generate(&generator, i + 1, options->max_nodes);
+        Wff* wff1 = wff_create(string1);
+        Wff* wff2 = wff_create(string2);
+        CheckVariables variables;
+        check_variables(wff1, NULL, &variables);
+        _check_parallel_tautology(wff1, check_truth_table(wff1, &variables) == check_all_rows(&variables), thread_count);
+
+        Wff* equivalent = check_equivalent_wff(wff1, i);
+        Wff* pairs[2] = {equivalent, wff2};
+        for (size_t k = 0; k < 2; k++) {
+            if (pairs[k] == NULL) {
+                continue;
+            }
+            check_variables(wff1, pairs[k], &variables);
+            bool expected = check_truth_table(wff1, &variables) == check_truth_table(pairs[k], &variables);
+            WffEvalAssignment assignment;
+            if (wff_eval_parallel_equivalent(wff1, pairs[k], thread_count, &assignment) != expected ||
+                (!expected && check_assignment_value(wff1, &assignment) == check_assignment_value(pairs[k], &assignment))) {
+                check_fail("wff_eval_parallel_equivalent", wff1, pairs[k]);
+            }
+        }
+        if (equivalent != NULL) {
+            wff_destroy(equivalent);
+        }
+        wff_destroy(wff2);
+        wff_destroy(wff1);
+        free(string2);
+        free(string1);
+
+        // Fewer of these, since each sweeps 2^16 assignments.
+        if (i % 16 != 0) {
+            continue;
+        }
+        generator.var_count = CHECK_PARALLEL_WIDE_VARIABLES;
+        char* string = wff_generator_string(&generator, 2 * CHECK_PARALLEL_WIDE_VARIABLES + i % options->max_nodes);
+        char* excluded_middle = malloc(2 * strlen(string) + 8);
+        sprintf(excluded_middle, "(%s v ~%s)", string, string);
+        Wff* wide = wff_create(string);
+        Wff* valid = wff_create(excluded_middle);
+        _check_parallel_tautology(valid, true, thread_count);
+        WffEvalAssignment assignment;
+        if (!wff_eval_parallel_is_tautology(wide, thread_count, &assignment) && check_assignment_value(wide, &assignment)) {
+            check_fail("wff_eval_parallel_is_tautology counterexample", wide, NULL);
+        }
+        wff_destroy(valid);
+        wff_destroy(wide);
+        free(excluded_middle);
+        free(string);
+    }
+}
+
+void _check_parallel_tautology(Wff* wff, bool expected, size_t thread_count) {
+    WffEvalAssignment assignment;
+    if (wff_eval_parallel_is_tautology(wff, thread_count, &assignment) != expected ||
+        (!expected && check_assignment_value(wff, &assignment))) {
+        check_fail("wff_eval_parallel_is_tautology", wff, NULL);
+    }
+}
@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "vector.h"
+#include "check.h"
+
+// Search and replace expressions tried on every wff: with and without
+// variables, with a variable repeated, with constants, with one that matches
+// everywhere and with a replace variable the search expression doesn't bind.
+const char* const CHECK_PATTERNS[][2] = {
+    {"(a ^ b)", "(b ^ a)"},
+    {"~~a", "a"},
+    {"(a => b)", "(~a v b)"},
+    {"(a v a)", "a"},
+    {"~T", "F"},
+    {"(a ^ T)", "a"},
+    {"(p => F)", "~p"},
+    {"a", "~~a"},
+    {"((a ^ b) v c)", "((a v c) ^ (b v c))"},
+    {"(a <=> b)", "(z ^ a)"},
+};
+#define CHECK_PATTERN_COUNT (sizeof(CHECK_PATTERNS) / sizeof(CHECK_PATTERNS[0]))
+
+
+void _check_pattern_render(CheckBuffer* buffer, WffParseTreeNode* node);
+char* _check_pattern_string(WffParseTreeNode* node);
+bool _check_pattern_same(Wff* wff1, Wff* wff2);
+void _check_pattern_expect(CheckBuffer* buffer, WffParseTreeNode* node, size_t* site, const CheckSite* target, Wff* search, Wff* replace);
+void _check_pattern_instantiate(CheckBuffer* buffer, WffParseTreeNode* template, WffParseTreeNode** bindings);
+void _check_pattern_wff(Wff* wff, const char* string, size_t i, size_t k);
+void _check_pattern_no_variables();
+
+
+// Every match, rewrite and substitution of a set of patterns against a naive
+// matcher that tries each site of the tree in turn.
+void check_pattern(const CheckOptions* options) {
+    _check_pattern_no_variables();
+
+    WffGenerator generator;
+    check_generator_init(&generator, options, "pattern");
+    for (size_t i = 0; i < options->case_count; i++) {
+        char* string = check_generate(&generator, i, options->max_nodes);
+        // The generator only writes variables, so some become constants for
+        // the patterns that have them.
+        if (i % 2 == 0) {
+            for (char* c = string; *c != '\0'; c++) {
+                *c = *c == 'r' ? 'T' : *c == 's' ? 'F' : *c;
+            }
+        }
+        Wff* wff = wff_create(string);
+        for (size_t k = 0; k < CHECK_PATTERN_COUNT; k++) {
+            _check_pattern_wff(wff, string, i, k);
+        }
+        wff_destroy(wff);
+        free(string);
+    }
+}
+
+// Pattern k on one wff.
+void _check_pattern_wff(Wff* wff, const char* string, size_t i, size_t k) {
+    WffPattern* pattern = wff_pattern_create(CHECK_PATTERNS[k][0], CHECK_PATTERNS[k][1]);
+    Wff* search = wff_create(CHECK_PATTERNS[k][0]);
+    Wff* replace = wff_create(CHECK_PATTERNS[k][1]);
+    char* before = _check_pattern_string(wff->parse_tree->root);
+
+    WffVector sites;
+    wff_vector_init(&sites, sizeof(CheckSite), NULL);
+    size_t site = 0;
+    check_pattern_sites(wff->parse_tree->root, search->parse_tree->root, &site, &sites);
+    size_t count = wff_vector_length(&sites);
+
+    // The match list has a group per site, starting with the match that has
+    // the site on it. A search expression without variables has no matches to
+    // put the site on, so its list stays empty.
+    WffMatchList* matches = wff_pattern_match(wff, pattern);
+    size_t group_count = 0;
+    bool sites_agree = true;
+    WffVectorIterator iterator = wff_match_list_iterate(matches);
+    for (WffMatch* match = wff_match_list_next(&iterator); match != NULL; match = wff_match_list_next(&iterator)) {
+        if (match->subwff_root != NULL) {
+            CheckSite* expected = wff_vector_get(&sites, group_count++);
+            sites_agree = sites_agree && expected != NULL && expected->site == match->site && expected->root == match->subwff_root;
+        }
+    }
+    wff_match_list_destroy(matches);
+    bool has_variables = search->var_count > 0;
+    if (!sites_agree || group_count != (has_variables ? count : 0)) {
+        check_fail("wff_pattern_match", wff, search);
+    }
+
+    // Every outcome of wff_pattern_rewrite, which leaves the wff as it was.
+    char* outcomes[count];
+    for (size_t j = 0; j <= count; j++) {
+        Wff* result = wff_pattern_rewrite(wff, pattern, j);
+        if (j == count) {
+            if (result != NULL) {
+                check_fail("wff_pattern_rewrite past the last match", wff, search);
+                wff_destroy(result);
+            }
+            break;
+        }
+        CheckBuffer expected = {NULL, 0, 0};
+        site = 0;
+        _check_pattern_expect(&expected, wff->parse_tree->root, &site, wff_vector_get(&sites, j), search, replace);
+        outcomes[j] = expected.data;
+        if (result == NULL) {
+            check_fail("wff_pattern_rewrite", wff, search);
+            continue;
+        }
+        char* actual = _check_pattern_string(result->parse_tree->root);
+        if (strcmp(actual, expected.data) != 0) {
+            check_fail("wff_pattern_rewrite", wff, search);
+        }
+        free(actual);
+        wff_destroy(result);
+    }
+    char* after = _check_pattern_string(wff->parse_tree->root);
+    if (strcmp(before, after) != 0) {
+        check_fail("wff_pattern_rewrite changed the wff", wff, search);
+    }
+    free(after);
+
+    // One substitution, in place, on a copy whose string and proposition count
+    // must come out as those of the outcome parsed afresh.
+    size_t index = (i + k) % (count + 1);
+    Wff* copy = wff_create(string);
+    bool substituted = wff_pattern_substitute(copy, pattern, index);
+    if (substituted != (index < count)) {
+        check_fail("wff_pattern_substitute", wff, search);
+    } else if (substituted) {
+        Wff* fresh = wff_create(outcomes[index]);
+        if (strcmp(wff_get_string(copy), wff_get_string(fresh)) != 0 || copy->var_count != fresh->var_count) {
+            check_fail("wff_pattern_substitute", wff, search);
+        }
+        wff_destroy(fresh);
+    }
+    wff_destroy(copy);
+
+    for (size_t j = 0; j < count; j++) {
+        free(outcomes[j]);
+    }
+    free(before);
+    wff_vector_finish(&sites);
+    wff_destroy(replace);
+    wff_destroy(search);
+    wff_pattern_destroy(pattern);
+}
+
+// A search expression without variables still rewrites, through each of the
+// entry points.
+void _check_pattern_no_variables() {
+    Wff* wff = wff_create("(p^~T)");
+    Wff* expected = wff_create("(p^F)");
+    if (!wff_substitute(wff, "~T", "F", 0) || !_check_pattern_same(wff, expected)) {
+        check_fail("wff_substitute of ~T", wff, expected);
+    }
+    if (wff_substitute(wff, "~T", "F", 0)) {
+        check_fail("wff_substitute of ~T once it's gone", wff, NULL);
+    }
+    wff_destroy(wff);
+
+    wff = wff_create("(~T v (q => ~T))");
+    WffPattern* pattern = wff_pattern_create("~T", "F");
+    Wff* second = wff_pattern_rewrite(wff, pattern, 1);
+    Wff* expected_second = wff_create("(~T v (q => F))");
+    if (second == NULL || !_check_pattern_same(second, expected_second)) {
+        check_fail("wff_pattern_rewrite of the second ~T", wff, expected_second);
+    }
+    if (wff_pattern_rewrite(wff, pattern, 2) != NULL) {
+        check_fail("wff_pattern_rewrite of a third ~T", wff, NULL);
+    }
+    Wff* both = wff_create("(F v (q => F))");
+    if (!wff_pattern_substitute(wff, pattern, 0) || !wff_pattern_substitute(wff, pattern, 0) ||
+        !_check_pattern_same(wff, both)) {
+        check_fail("wff_pattern_substitute of both ~T", wff, both);
+    }
+    wff_destroy(both);
+    if (second != NULL) {
+        wff_destroy(second);
+    }
+    wff_destroy(expected_second);
+    wff_pattern_destroy(pattern);
+    wff_destroy(wff);
+    wff_destroy(expected);
+}
+
+// Renders the subtree of 'node' with 'target' replaced by 'replace', its
+// variables bound as 'search' binds them there and the rest kept as they are.
+void _check_pattern_expect(CheckBuffer* buffer, WffParseTreeNode* node, size_t* site, const CheckSite* target, Wff* search, Wff* replace) {
+    if (node->type != WPTNT_NONTERMINAL) {
+        check_buffer_append(buffer, wff_token_get_string(node->token));
+        return;
+    }
+    if ((*site)++ != target->site) {
+        for (int i = 0; i < node->child_count; i++) {
+            _check_pattern_expect(buffer, node->children[i], site, target, search, replace);
+        }
+        return;
+    }
+    WffParseTreeNode* bindings[WFF_VARIABLE_COUNT] = {NULL};
+    check_pattern_match(node, search->parse_tree->root, bindings);
+    _check_pattern_instantiate(buffer, replace->parse_tree->root, bindings);
+}
+
+void _check_pattern_instantiate(CheckBuffer* buffer, WffParseTreeNode* template, WffParseTreeNode** bindings) {
+    if (template->type == WPTNT_TERMINAL) {
+        check_buffer_append(buffer, wff_token_get_string(template->token));
+        return;
+    }
+    if (template->child_count == 1 && template->children[0]->token->type == WTT_PROPOSITION) {
+        WffParseTreeNode* value = bindings[template->children[0]->token->variable->id];
+        if (value != NULL) {
+            _check_pattern_render(buffer, value);
+            return;
+        }
+    }
+    for (int i = 0; i < template->child_count; i++) {
+        _check_pattern_instantiate(buffer, template->children[i], bindings);
+    }
+}
+
+void _check_pattern_render(CheckBuffer* buffer, WffParseTreeNode* node) {
+    if (node->type != WPTNT_NONTERMINAL) {
+        check_buffer_append(buffer, wff_token_get_string(node->token));
+        return;
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        _check_pattern_render(buffer, node->children[i]);
+    }
+}
+
+// The tokens of the subtree of 'node' with nothing between them, which the
+// caller frees.
+char* _check_pattern_string(WffParseTreeNode* node) {
+    CheckBuffer buffer = {NULL, 0, 0};
+    _check_pattern_render(&buffer, node);
+    return buffer.data;
+}
+
+// Whether the two wffs have the same tokens, however they were spaced.
+bool _check_pattern_same(Wff* wff1, Wff* wff2) {
+    char* string1 = _check_pattern_string(wff1->parse_tree->root);
+    char* string2 = _check_pattern_string(wff2->parse_tree->root);
+    bool same = strcmp(string1, string2) == 0;
+    free(string2);
+    free(string1);
+    return same;
+}
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "preview.h"
+#include "generate.h"
+#include "check.h"
+
+// Edits made to each line, and to every CHECK_PREVIEW_LONG_PERIOD'th line
+// enough of them that old nodes get compacted away.
+#define CHECK_PREVIEW_EDIT_COUNT 16
+#define CHECK_PREVIEW_LONG_EDIT_COUNT 512
+#define CHECK_PREVIEW_LONG_PERIOD 32
+
+// Text typed into a line: tokens, pieces of tokens and characters that
+// aren't any.
+const char* const CHECK_PREVIEW_FRAGMENTS[] = {
+    "", "p", "q", "T", "F", "~", " ", "^", "v", "=>", "<=>", "<", "=", ">", "(", ")", "(p ^ q)", "~~", "x1", "\t",
+};
+#define CHECK_PREVIEW_FRAGMENT_COUNT (sizeof(CHECK_PREVIEW_FRAGMENTS) / sizeof(CHECK_PREVIEW_FRAGMENTS[0]))
+
+uint64_t _check_preview_random(uint64_t* state);
+char* _check_preview_apply(CheckBuffer* line, size_t* offset, size_t removed, const char* inserted);
+char* _check_preview_parse(const char* string);
+void _check_preview_compare(WffPreview* preview, const CheckBuffer* line, bool returned);
+
+
+// Random edits to a generated line, each checked against the same edit made
+// to a plain string that is then parsed from scratch: the preview must hold
+// the same text, be valid iff it parses and render as its parse tree does.
+// Besides typing fragments, some edits take the last fragment back, swap a
+// variable for a whole wff or paste over the line, so that lines are valid
+// often enough to be worth rendering.
+void check_preview(const CheckOptions* options) {
+    WffGenerator generator;
+    check_generator_init(&generator, options, "preview");
+    uint64_t state = options->seed;
+    for (size_t i = 0; i < options->case_count; i++) {
+        char* string = check_generate(&generator, i, options->max_nodes);
+        CheckBuffer line = {NULL, 0, 0};
+        check_buffer_append(&line, string);
+        WffPreview* preview = wff_preview_create(string);
+        _check_preview_compare(preview, &line, wff_preview_is_valid(preview));
+
+        size_t edit_count = i % CHECK_PREVIEW_LONG_PERIOD == 0 ? CHECK_PREVIEW_LONG_EDIT_COUNT : CHECK_PREVIEW_EDIT_COUNT;
+        // The last fragment typed, so that it can be taken back again.
+        char* undo = NULL;
+        size_t undo_offset = 0;
+        size_t undo_length = 0;
+        for (size_t k = 0; k < edit_count; k++) {
+            uint64_t choice = _check_preview_random(&state);
+            // Offsets and lengths past the end are clamped to it.
+            size_t offset = _check_preview_random(&state) % (line.length + 3);
+            size_t removed = _check_preview_random(&state) % 4;
+            char* wff = NULL;
+            const char* inserted;
+            bool typed = false;
+            if (undo != NULL && choice % 2 == 0) {
+                offset = undo_offset;
+                removed = undo_length;
+                inserted = undo;
+            } else if (choice % 8 < 3) {
+                wff = check_generate(&generator, i + k, options->max_nodes);
+                inserted = wff;
+                // A variable, if there is one from here on.
+                while (offset < line.length && _wff_variable_index(line.data[offset]) < 0) {
+                    offset++;
+                }
+                removed = 1;
+            } else if (choice % 8 == 3) {
+                wff = check_generate(&generator, i + k, options->max_nodes);
+                inserted = wff;
+                offset = 0;
+                removed = line.length;
+            } else {
+                inserted = CHECK_PREVIEW_FRAGMENTS[choice / 8 % CHECK_PREVIEW_FRAGMENT_COUNT];
+                typed = true;
+            }
+            bool returned = wff_preview_edit(preview, offset, removed, inserted);
+            char* removed_text = _check_preview_apply(&line, &offset, removed, inserted);
+            _check_preview_compare(preview, &line, returned);
+
+            free(wff);
+            free(undo);
+            undo = NULL;
+            if (typed) {
+                undo = removed_text;
+                undo_offset = offset;
+                undo_length = strlen(inserted);
+            } else {
+                free(removed_text);
+            }
+        }
+        free(undo);
+
+        // A preview created from the final text agrees with the edited one.
+        WffPreview* fresh = wff_preview_create(line.data);
+        _check_preview_compare(fresh, &line, wff_preview_is_valid(fresh));
+        wff_preview_destroy(fresh);
+
+        wff_preview_destroy(preview);
+        free(line.data);
+        free(string);
+    }
+}
+
+// splitmix64, so that the edits depend only on the seed.
+uint64_t _check_preview_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// The edit wff_preview_edit makes, clamped the same way, leaving the clamped
+// offset at 'offset'. Returns the text removed, which the caller frees.
+char* _check_preview_apply(CheckBuffer* line, size_t* offset, size_t removed, const char* inserted) {
+    if (*offset > line->length) {
+        *offset = line->length;
+    }
+    if (removed > line->length - *offset) {
+        removed = line->length - *offset;
+    }
+    char* removed_text = malloc(removed + 1);
+    memcpy(removed_text, line->data + *offset, removed);
+    removed_text[removed] = '\0';
+
+    CheckBuffer result = {NULL, 0, 0};
+    check_buffer_append(&result, "");
+    char saved = line->data[*offset];
+    line->data[*offset] = '\0';
+    check_buffer_append(&result, line->data);
+    line->data[*offset] = saved;
+    check_buffer_append(&result, inserted);
+    check_buffer_append(&result, line->data + *offset + removed);
+    free(line->data);
+    *line = result;
+    return removed_text;
+}
+
+// 'string' parsed from scratch and rendered, or NULL if it isn't a wff.
+char* _check_preview_parse(const char* string) {
+    WffArena* arena = wff_arena_create();
+    size_t var_count = 0;
+    WffParseTree* tree = _wff_parse_tree_create_from_string(string, arena, wff_node_table_create(arena), &var_count);
+    char* rendered = tree == NULL ? NULL : wff_parse_tree_get_subwff_string(tree->root);
+    wff_arena_release(arena);
+    return rendered;
+}
+
+void _check_preview_compare(WffPreview* preview, const CheckBuffer* line, bool returned) {
+    char* text = wff_preview_string(preview);
+    if (strcmp(text, line->data) != 0 || wff_preview_length(preview) != line->length) {
+        check_fail_string("wff_preview_string", line->data);
+    }
+    free(text);
+
+    char* expected = _check_preview_parse(line->data);
+    char* actual = wff_preview_render(preview);
+    bool valid = expected != NULL;
+    if (returned != valid || wff_preview_is_valid(preview) != valid) {
+        check_fail_string("wff_preview_is_valid", line->data);
+    } else if (valid && (actual == NULL || strcmp(actual, expected) != 0)) {
+        check_fail_string("wff_preview_render", line->data);
+    } else if (!valid && actual != NULL) {
+        check_fail_string("wff_preview_render of an invalid line", line->data);
+    }
+    free(actual);
+    free(expected);
+}
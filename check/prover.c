@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "proof.h"
+#include "prover.h"
+#include "generate.h"
+#include "check.h"
+
+// Largest wff drawn and most rewrites between the two sides of a goal, so
+// that every search ends well within WFF_PROVER_STATE_LIMIT.
+#define CHECK_PROVER_MAX_NODES 6
+#define CHECK_PROVER_MAX_STEPS 2
+
+// Goals that aren't conditional wffs, or aren't wffs at all.
+const char* const CHECK_PROVER_MALFORMED[] = {"p ^ q", "(p => q", "~(p => q)", "", "PROVE"};
+#define CHECK_PROVER_MALFORMED_COUNT (sizeof(CHECK_PROVER_MALFORMED) / sizeof(CHECK_PROVER_MALFORMED[0]))
+
+char* _check_prover_goal(const char* antecedent, const char* consequent);
+
+
+// Goals "X => Y" with Y a rewrite or two of X by the rule library: the
+// prover must find a proof, not necessarily that one, which wff_proof_check
+// accepts, and the same one on one thread as on two. A goal whose sides
+// aren't equivalent must be refused as such, and one that isn't a
+// conditional as malformed.
+void check_prover(const CheckOptions* options) {
+    for (size_t k = 0; k < CHECK_PROVER_MALFORMED_COUNT; k++) {
+        WffProverReport report;
+        if (wff_prover_prove(CHECK_PROVER_MALFORMED[k], check_rule_index, 1, &report) != WPRS_MALFORMED || report.proof != NULL) {
+            check_fail_string("wff_prover_prove of a malformed goal", CHECK_PROVER_MALFORMED[k]);
+        }
+        free(report.proof);
+    }
+
+    size_t max_nodes = options->max_nodes < CHECK_PROVER_MAX_NODES ? options->max_nodes : CHECK_PROVER_MAX_NODES;
+    WffGenerator generator;
+    check_generator_init(&generator, options, "prover");
+    for (size_t i = 0; i < options->case_count; i++) {
+        char* string = check_generate(&generator, i, max_nodes);
+        Wff* wff = wff_create(string);
+        Wff* consequent = wff_create(string);
+        for (size_t s = 0; s < 1 + i % CHECK_PROVER_MAX_STEPS; s++) {
+            Wff* next = check_equivalent_wff(consequent, i + s);
+            if (next == NULL) {
+                break;
+            }
+            wff_destroy(consequent);
+            consequent = next;
+        }
+        char* consequent_string = wff_parse_tree_get_subwff_string(consequent->parse_tree->root);
+        char* goal = _check_prover_goal(string, consequent_string);
+
+        WffProverReport reports[2];
+        for (size_t t = 0; t < 2; t++) {
+            if (wff_prover_prove(goal, check_rule_index, t + 1, &reports[t]) != WPRS_FOUND) {
+                check_fail_string("wff_prover_prove", goal);
+                continue;
+            }
+            WffProofReport proof_report;
+            if (wff_proof_check(reports[t].proof, check_rule_index, &proof_report) != WPS_VALID ||
+                proof_report.line_count != reports[t].step_count + 1) {
+                check_fail_string("wff_prover_prove gave a proof wff_proof_check rejects", reports[t].proof);
+            }
+        }
+        if (reports[0].proof != NULL && reports[1].proof != NULL && strcmp(reports[0].proof, reports[1].proof) != 0) {
+            check_fail_string("wff_prover_prove on two threads", goal);
+        }
+        free(reports[1].proof);
+        free(reports[0].proof);
+
+        // Another wff is the other side, unless it happens to be equivalent.
+        char* other_string = check_generate(&generator, i + 1, max_nodes);
+        Wff* other = wff_create(other_string);
+        CheckVariables variables;
+        check_variables(wff, other, &variables);
+        if (check_truth_table(wff, &variables) != check_truth_table(other, &variables)) {
+            char* other_goal = _check_prover_goal(string, other_string);
+            WffProverReport report;
+            if (wff_prover_prove(other_goal, check_rule_index, 1, &report) != WPRS_INEQUIVALENT || report.proof != NULL) {
+                check_fail_string("wff_prover_prove of an inequivalent goal", other_goal);
+            }
+            free(report.proof);
+            free(other_goal);
+        }
+        wff_destroy(other);
+        free(other_string);
+
+        free(goal);
+        free(consequent_string);
+        wff_destroy(consequent);
+        wff_destroy(wff);
+        free(string);
+    }
+}
+
+// "(antecedent) => (consequent)", which the caller frees.
+char* _check_prover_goal(const char* antecedent, const char* consequent) {
+    CheckBuffer goal = {NULL, 0, 0};
+    check_buffer_append(&goal, "(");
+    check_buffer_append(&goal, antecedent);
+    check_buffer_append(&goal, " => ");
+    check_buffer_append(&goal, consequent);
+    check_buffer_append(&goal, ")");
+    return goal.data;
+}
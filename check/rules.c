@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "rules.h"
+#include "rules_internal.h"
+#include "vector.h"
+#include "generate.h"
+#include "check.h"
+
+// Largest wff drawn, since every outcome of each is tried.
+#define CHECK_RULES_MAX_NODES 10
+
+typedef struct CheckOutcome CheckOutcome;
+
+// One way the rule index rewrites a wff: the rule, the site it applies at and
+// the whole wff afterwards.
+struct CheckOutcome {
+    const WffRule* rule;
+    size_t site;
+    char* result;
+};
+
+char* _check_rules_generate(WffGenerator* generator, const CheckOptions* options, size_t i);
+void _check_rules_outcomes(Wff* wff, WffVector* outcomes);
+void _check_rules_outcomes_finish(WffVector* outcomes);
+bool _check_rules_is_first(WffVector* outcomes, size_t i);
+void _check_rules_verify(Wff* wff, WffVector* outcomes, const char* result_string);
+void _check_rules_infer(Wff* wff, WffVector* outcomes, const char* result_string);
+
+
+// wff_rule_verify against every outcome of wff_rule_index_match: for each
+// distinct result and each rule, it must find the rule iff some outcome of
+// the rule gives the result, and report the first site where one does. A
+// result unrelated to the wff is tried as well.
+void check_verify(const CheckOptions* options) {
+    WffGenerator generator;
+    check_generator_init(&generator, options, "verify");
+    for (size_t i = 0; i < options->case_count; i++) {
+        char* string = _check_rules_generate(&generator, options, i);
+        Wff* wff = wff_create(string);
+        WffVector outcomes;
+        _check_rules_outcomes(wff, &outcomes);
+        for (size_t j = 0; j < wff_vector_length(&outcomes); j++) {
+            if (_check_rules_is_first(&outcomes, j)) {
+                _check_rules_verify(wff, &outcomes, ((CheckOutcome*) wff_vector_get(&outcomes, j))->result);
+            }
+        }
+        char* other = _check_rules_generate(&generator, options, i + 1);
+        _check_rules_verify(wff, &outcomes, other);
+        free(other);
+        _check_rules_outcomes_finish(&outcomes);
+        wff_destroy(wff);
+        free(string);
+    }
+}
+
+// Every rule against the result, parsed afresh as a proof line would be.
+void _check_rules_verify(Wff* wff, WffVector* outcomes, const char* result_string) {
+    Wff* result = wff_create(result_string);
+    char* canonical = wff_parse_tree_get_subwff_string(result->parse_tree->root);
+    for (size_t r = 0; r < WFF_RULE_COUNT; r++) {
+        const WffRule* rule = &WFF_RULES[r];
+        bool expected = false;
+        size_t expected_site = 0;
+        WffVectorIterator iterator = wff_vector_iterate(outcomes);
+        for (CheckOutcome* outcome = wff_vector_iterator_next(&iterator); outcome != NULL; outcome = wff_vector_iterator_next(&iterator)) {
+            if (outcome->rule == rule && strcmp(outcome->result, canonical) == 0 && (!expected || outcome->site < expected_site)) {
+                expected = true;
+                expected_site = outcome->site;
+            }
+        }
+        size_t site;
+        bool found = wff_rule_verify(check_rule_index, wff, rule, result, &site);
+        if (found != expected || (found && site != expected_site)) {
+            check_fail(rule->name, wff, result);
+        }
+    }
+    free(canonical);
+    wff_destroy(result);
+}
+
+// wff_rule_infer against every outcome of wff_rule_index_match: for each
+// distinct result, it must give exactly the distinct (rule, site) pairs whose
+// outcome that is, in order of site, and nothing for an unrelated result
+// unless that happens to be an outcome too.
+void check_infer(const CheckOptions* options) {
+    WffGenerator generator;
+    check_generator_init(&generator, options, "infer");
+    for (size_t i = 0; i < options->case_count; i++) {
+        char* string = _check_rules_generate(&generator, options, i);
+        Wff* wff = wff_create(string);
+        WffVector outcomes;
+        _check_rules_outcomes(wff, &outcomes);
+        for (size_t j = 0; j < wff_vector_length(&outcomes); j++) {
+            if (_check_rules_is_first(&outcomes, j)) {
+                _check_rules_infer(wff, &outcomes, ((CheckOutcome*) wff_vector_get(&outcomes, j))->result);
+            }
+        }
+        char* other = _check_rules_generate(&generator, options, i + 1);
+        _check_rules_infer(wff, &outcomes, other);
+        free(other);
+        _check_rules_outcomes_finish(&outcomes);
+        wff_destroy(wff);
+        free(string);
+    }
+}
+
+void _check_rules_infer(Wff* wff, WffVector* outcomes, const char* result_string) {
+    Wff* result = wff_create(result_string);
+    char* canonical = wff_parse_tree_get_subwff_string(result->parse_tree->root);
+
+    // Distinct (rule, site) pairs that give this result.
+    size_t expected = 0;
+    for (size_t j = 0; j < wff_vector_length(outcomes); j++) {
+        CheckOutcome* outcome = wff_vector_get(outcomes, j);
+        bool repeat = strcmp(outcome->result, canonical) != 0;
+        for (size_t k = 0; k < j && !repeat; k++) {
+            CheckOutcome* earlier = wff_vector_get(outcomes, k);
+            repeat = earlier->rule == outcome->rule && earlier->site == outcome->site && strcmp(earlier->result, canonical) == 0;
+        }
+        expected += !repeat;
+    }
+
+    WffRuleMatchList* inferred = wff_rule_infer(check_rule_index, wff, result);
+    bool valid = wff_rule_match_list_length(inferred) == expected;
+    size_t last_site = 0;
+    WffVectorIterator iterator = wff_rule_match_list_iterate(inferred);
+    for (WffRuleMatch* match = wff_rule_match_list_next(&iterator); match != NULL && valid; match = wff_rule_match_list_next(&iterator)) {
+        bool found = false;
+        WffVectorIterator outcome_iterator = wff_vector_iterate(outcomes);
+        for (CheckOutcome* outcome = wff_vector_iterator_next(&outcome_iterator); outcome != NULL && !found; outcome = wff_vector_iterator_next(&outcome_iterator)) {
+            found = outcome->rule == wff_rule_match_get_rule(match) && outcome->site == match->site && strcmp(outcome->result, canonical) == 0;
+        }
+        valid = found && match->site >= last_site;
+        last_site = match->site;
+    }
+    if (!valid) {
+        check_fail("wff_rule_infer", wff, result);
+    }
+    check_match_list_destroy(inferred);
+    free(canonical);
+    wff_destroy(result);
+}
+
+char* _check_rules_generate(WffGenerator* generator, const CheckOptions* options, size_t i) {
+    return check_generate(generator, i, options->max_nodes < CHECK_RULES_MAX_NODES ? options->max_nodes : CHECK_RULES_MAX_NODES);
+}
+
+// Every outcome of the rule index on 'wff', in the order it gives them, with
+// the results written as wff_parse_tree_get_subwff_string writes them.
+void _check_rules_outcomes(Wff* wff, WffVector* outcomes) {
+    wff_vector_init(outcomes, sizeof(CheckOutcome), NULL);
+    WffRuleMatchList* matches = wff_rule_index_match(check_rule_index, wff);
+    WffVectorIterator iterator = wff_rule_match_list_iterate(matches);
+    for (WffRuleMatch* match = wff_rule_match_list_next(&iterator); match != NULL; match = wff_rule_match_list_next(&iterator)) {
+        Wff* result = wff_rule_match_rewrite(wff, match);
+        CheckOutcome outcome = {wff_rule_match_get_rule(match), match->site, wff_parse_tree_get_subwff_string(result->parse_tree->root)};
+        wff_vector_append(outcomes, &outcome);
+        wff_destroy(result);
+    }
+    check_match_list_destroy(matches);
+}
+
+void _check_rules_outcomes_finish(WffVector* outcomes) {
+    WffVectorIterator iterator = wff_vector_iterate(outcomes);
+    for (CheckOutcome* outcome = wff_vector_iterator_next(&iterator); outcome != NULL; outcome = wff_vector_iterator_next(&iterator)) {
+        free(outcome->result);
+    }
+    wff_vector_finish(outcomes);
+}
+
+// Whether no outcome before the i'th has the same result.
+bool _check_rules_is_first(WffVector* outcomes, size_t i) {
+    const char* result = ((CheckOutcome*) wff_vector_get(outcomes, i))->result;
+    for (size_t j = 0; j < i; j++) {
+        if (strcmp(((CheckOutcome*) wff_vector_get(outcomes, j))->result, result) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "sat.h"
+#include "generate.h"
+#include "generate_internal.h"
+#include "check.h"
+
+// Variables of the random CNFs, so that every assignment can be tried.
+#define CHECK_SAT_MAX_VARIABLES 10
+
+bool _check_sat_clauses_hold(const int* literals, const size_t* lengths, size_t clause_count, const bool* model);
+
+
+// wff_sat_solve on random CNFs against trying every assignment, then
+// satisfiability, validity and equivalence of wffs against their truth
+// tables, with the models and counterexamples given checked too.
+void check_sat(const CheckOptions* options) {
+    WffGenerator generator;
+    check_generator_init(&generator, options, "sat");
+    for (size_t i = 0; i < options->case_count; i++) {
+        size_t var_count = 1 + i % CHECK_SAT_MAX_VARIABLES;
+        size_t clause_count = 1 + _wff_generator_below(&generator, 5 * var_count);
+        int literals[clause_count * 3];
+        size_t lengths[clause_count];
+        WffCnf* cnf = wff_cnf_create();
+        for (size_t v = 0; v < var_count; v++) {
+            wff_cnf_new_var(cnf);
+        }
+        for (size_t c = 0; c < clause_count; c++) {
+            lengths[c] = 1 + _wff_generator_below(&generator, 3);
+            int* clause = &literals[c * 3];
+            for (size_t k = 0; k < lengths[c]; k++) {
+                int var = 1 + _wff_generator_below(&generator, var_count);
+                clause[k] = _wff_generator_below(&generator, 2) ? var : -var;
+            }
+            wff_cnf_add_clause(cnf, clause, lengths[c]);
+        }
+        bool satisfiable = false;
+        bool model[var_count + 1];
+        for (uint64_t row = 0; row < (1ULL << var_count) && !satisfiable; row++) {
+            for (size_t v = 0; v < var_count; v++) {
+                model[v + 1] = (row >> v) & 1;
+            }
+            satisfiable = _check_sat_clauses_hold(literals, lengths, clause_count, model);
+        }
+        bool solved = wff_sat_solve(cnf, model);
+        if (solved != satisfiable || (solved && !_check_sat_clauses_hold(literals, lengths, clause_count, model))) {
+            char description[64];
+            snprintf(description, sizeof(description), "CNF %zu of %zu variables", i, var_count);
+            check_fail_string("wff_sat_solve", description);
+        }
+        wff_cnf_destroy(cnf);
+
+        char* string1 = check_generate(&generator, i, options->max_nodes);
+        char* string2 = check_generate(&generator, i + 1, options->max_nodes);
+        Wff* wff1 = wff_create(string1);
+        Wff* wff2 = wff_create(string2);
+        CheckVariables variables;
+        check_variables(wff1, NULL, &variables);
+        uint64_t table = check_truth_table(wff1, &variables);
+        bool tautology = table == check_all_rows(&variables);
+        bool contradiction = table == 0;
+
+        WffEvalAssignment assignment;
+        if (wff_sat_is_satisfiable(wff1, &assignment) == contradiction ||
+            (!contradiction && !check_assignment_value(wff1, &assignment))) {
+            check_fail("wff_sat_is_satisfiable", wff1, NULL);
+        }
+        if (wff_sat_is_valid(wff1, &assignment) != tautology || (!tautology && check_assignment_value(wff1, &assignment))) {
+            check_fail("wff_sat_is_valid", wff1, NULL);
+        }
+
+        // One pair that is equivalent by construction and one that mostly
+        // isn't.
+        Wff* equivalent = check_equivalent_wff(wff1, i);
+        Wff* pairs[2] = {equivalent, wff2};
+        for (size_t k = 0; k < 2; k++) {
+            if (pairs[k] == NULL) {
+                continue;
+            }
+            check_variables(wff1, pairs[k], &variables);
+            bool expected = check_truth_table(wff1, &variables) == check_truth_table(pairs[k], &variables);
+            if (wff_sat_equivalent(wff1, pairs[k], &assignment) != expected ||
+                (!expected && check_assignment_value(wff1, &assignment) == check_assignment_value(pairs[k], &assignment))) {
+                check_fail("wff_sat_equivalent", wff1, pairs[k]);
+            }
+        }
+        if (equivalent != NULL) {
+            wff_destroy(equivalent);
+        }
+        wff_destroy(wff2);
+        wff_destroy(wff1);
+        free(string2);
+        free(string1);
+    }
+}
+
+bool _check_sat_clauses_hold(const int* literals, const size_t* lengths, size_t clause_count, const bool* model) {
+    for (size_t c = 0; c < clause_count; c++) {
+        bool holds = false;
+        for (size_t k = 0; k < lengths[c] && !holds; k++) {
+            int literal = literals[c * 3 + k];
+            holds = literal > 0 ? model[literal] : !model[-literal];
+        }
+        if (!holds) {
+            return false;
+        }
+    }
+    return true;
+}
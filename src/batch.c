@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "rules.h"
+#include "proof.h"
+#include "batch.h"
+#include "batch_internal.h"
+#include "threads.h"
+
+
+/* === WffBatch === */
+
+int wff_batch_main(int argc, char** argv) {
+    size_t thread_count = 0;
+    int first = wff_threads_parse_option(argc, argv, &thread_count);
+    if (first < 0) {
+        return 1;
+    }
+    if (first == argc) {
+        fprintf(stderr, "Usage: main --check [-j threads] <file or directory>...\n");
+        return 1;
+    }
+
+    WffBatch batch;
+    batch.paths = NULL;
+    batch.path_count = 0;
+    size_t capacity = 0;
+    for (int i = first; i < argc; i++) {
+        if (!_wff_batch_collect(argv[i], &batch.paths, &batch.path_count, &capacity)) {
+            fprintf(stderr, "ERROR: Can't read %s\n", argv[i]);
+            for (size_t k = 0; k < batch.path_count; k++) {
+                free(batch.paths[k]);
+            }
+            free(batch.paths);
+            return 1;
+        }
+    }
+
+    thread_count = wff_threads_resolve(thread_count);
+    // No point in more threads than proofs.
+    if (thread_count > batch.path_count) {
+        thread_count = batch.path_count > 0 ? batch.path_count : 1;
+    }
+
+    batch.reports = malloc(batch.path_count * sizeof(WffProofReport));
+    batch.index = wff_rule_index_create(WFF_RULES, WFF_RULE_COUNT);
+    batch.thread_count = thread_count;
+    batch.queues = malloc(thread_count * sizeof(WffBatchQueue));
+    for (size_t i = 0; i < thread_count; i++) {
+        WffBatchQueue* queue = &batch.queues[i];
+        queue->items = malloc((batch.path_count / thread_count + 1) * sizeof(size_t));
+        queue->head = 0;
+        queue->tail = 0;
+        pthread_mutex_init(&queue->lock, NULL);
+    }
+    for (size_t i = 0; i < batch.path_count; i++) {
+        WffBatchQueue* queue = &batch.queues[i % thread_count];
+        queue->items[queue->tail++] = i;
+    }
+
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_t threads[thread_count];
+    WffBatchWorker workers[thread_count];
+    for (size_t i = 0; i < thread_count; i++) {
+        workers[i].batch = &batch;
+        workers[i].id = i;
+    }
+    for (size_t i = 1; i < thread_count; i++) {
+        pthread_create(&threads[i], NULL, _wff_batch_worker, &workers[i]);
+    }
+    // The calling thread does its share too.
+    _wff_batch_worker(&workers[0]);
+    for (size_t i = 1; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    size_t counts[WPS_UNREADABLE + 1] = {0};
+    for (size_t i = 0; i < batch.path_count; i++) {
+        _wff_batch_print_report(batch.paths[i], &batch.reports[i]);
+        counts[batch.reports[i].status]++;
+    }
+    fflush(stdout);
+    fprintf(stderr, "Checked %zu proofs in %.3f s (%.0f proofs/s) with %zu threads: ", batch.path_count, seconds,
+            seconds > 0 ? batch.path_count / seconds : 0.0, thread_count);
+    for (WffProofStatus status = WPS_VALID; status <= WPS_UNREADABLE; status++) {
+        fprintf(stderr, "%zu %s%s", counts[status], wff_proof_status_string(status), status < WPS_UNREADABLE ? ", " : "\n");
+    }
+
+    for (size_t i = 0; i < thread_count; i++) {
+        free(batch.queues[i].items);
+        pthread_mutex_destroy(&batch.queues[i].lock);
+    }
+    free(batch.queues);
+    wff_rule_index_destroy(batch.index);
+    free(batch.reports);
+    for (size_t i = 0; i < batch.path_count; i++) {
+        free(batch.paths[i]);
+    }
+    free(batch.paths);
+    return counts[WPS_VALID] == batch.path_count ? 0 : 1;
+}
+
+// Adds 'path' to the list, or, if it is a directory, the regular files in it
+// (not hidden, not in subdirectories) sorted by name.
+bool _wff_batch_collect(const char* path, char*** paths, size_t* count, size_t* capacity) {
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        return false;
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        _wff_batch_add_path(strdup(path), paths, count, capacity);
+        return true;
+    }
+
+    DIR* directory = opendir(path);
+    if (directory == NULL) {
+        return false;
+    }
+    size_t first = *count;
+    for (struct dirent* entry = readdir(directory); entry != NULL; entry = readdir(directory)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        size_t length = strlen(path) + strlen(entry->d_name) + 2;
+        char* file = malloc(length);
+        snprintf(file, length, "%s/%s", path, entry->d_name);
+        if (stat(file, &info) != 0 || !S_ISREG(info.st_mode)) {
+            free(file);
+            continue;
+        }
+        _wff_batch_add_path(file, paths, count, capacity);
+    }
+    closedir(directory);
+    qsort(*paths + first, *count - first, sizeof(char*), _wff_batch_compare_paths);
+    return true;
+}
+
+void _wff_batch_add_path(char* path, char*** paths, size_t* count, size_t* capacity) {
+    if (*count == *capacity) {
+        *capacity = *capacity == 0 ? 64 : *capacity * 2;
+        *paths = realloc(*paths, *capacity * sizeof(char*));
+    }
+    (*paths)[(*count)++] = path;
+}
+
+int _wff_batch_compare_paths(const void* a, const void* b) {
+    return strcmp(*(char* const*) a, *(char* const*) b);
+}
+
+// Takes the next file for thread 'id': the last of its own, or else the first
+// of another thread's. Returns false once there are none left anywhere.
+bool _wff_batch_take(WffBatch* batch, size_t id, size_t* item) {
+    for (size_t k = 0; k < batch->thread_count; k++) {
+        size_t victim = (id + k) % batch->thread_count;
+        WffBatchQueue* queue = &batch->queues[victim];
+        pthread_mutex_lock(&queue->lock);
+        bool found = queue->head < queue->tail;
+        if (found) {
+            *item = victim == id ? queue->items[--queue->tail] : queue->items[queue->head++];
+        }
+        pthread_mutex_unlock(&queue->lock);
+        if (found) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void* _wff_batch_worker(void* arg) {
+    WffBatchWorker* worker = arg;
+    size_t item;
+    while (_wff_batch_take(worker->batch, worker->id, &item)) {
+        _wff_batch_check_file(worker->batch, item);
+    }
+    return NULL;
+}
+
+void _wff_batch_check_file(WffBatch* batch, size_t item) {
+    WffProofReport* report = &batch->reports[item];
+    char* text = _wff_batch_read_file(batch->paths[item]);
+    if (text == NULL) {
+        report->status = WPS_UNREADABLE;
+        report->line_count = 0;
+        report->line = 0;
+        snprintf(report->message, sizeof(report->message), "can't read file");
+        return;
+    }
+    wff_proof_check(text, batch->index, report);
+    free(text);
+}
+
+// Returns the contents of the file as a string, or NULL if it can't be read.
+char* _wff_batch_read_file(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    size_t capacity = 4096;
+    size_t length = 0;
+    char* text = malloc(capacity);
+    size_t read;
+    while ((read = fread(text + length, 1, capacity - length - 1, file)) > 0) {
+        length += read;
+        if (capacity - length == 1) {
+            capacity *= 2;
+            text = realloc(text, capacity);
+        }
+    }
+    bool failed = ferror(file);
+    fclose(file);
+    if (failed) {
+        free(text);
+        return NULL;
+    }
+    text[length] = '\0';
+    return text;
+}
+
+// One line of JSON per proof, e.g.
+// {"file":"a.txt","status":"invalid","lines":3,"line":3,"message":"..."}
+// where "line" and "message" are left out for valid proofs.
+void _wff_batch_print_report(const char* path, const WffProofReport* report) {
+    printf("{\"file\":");
+    _wff_batch_print_json_string(path);
+    printf(",\"status\":\"%s\",\"lines\":%zu", wff_proof_status_string(report->status), report->line_count);
+    if (report->status != WPS_VALID) {
+        if (report->line > 0) {
+            printf(",\"line\":%zu", report->line);
+        }
+        printf(",\"message\":");
+        _wff_batch_print_json_string(report->message);
+    }
+    printf("}\n");
+}
+
+void _wff_batch_print_json_string(const char* string) {
+    putchar('"');
+    for (const unsigned char* c = (const unsigned char*) string; *c != '\0'; c++) {
+        switch (*c) {
+            case '"':
+                printf("\\\"");
+                break;
+            case '\\':
+                printf("\\\\");
+                break;
+            case '\n':
+                printf("\\n");
+                break;
+            case '\t':
+                printf("\\t");
+                break;
+            default:
+                if (*c < 0x20) {
+                    printf("\\u%04x", *c);
+                } else {
+                    putchar(*c);
+                }
+        }
+    }
+    putchar('"');
+}
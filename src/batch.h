@@ -0,0 +1,17 @@
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "proof.h"
+
+
+// Checks every proof named on the command line, "[-j threads] <file or
+// directory>...", where a directory stands for the files in it. Prints one
+// JSON report per proof to stdout, in the order given, and the throughput to
+// stderr. Returns the exit status: 0 if every proof is valid, 1 if any isn't
+// or the command line is wrong.
+int wff_batch_main(int argc, char** argv);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef BATCH_INTERNAL_H_
+#define BATCH_INTERNAL_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "rules.h"
+#include "proof.h"
+#include "batch.h"
+
+typedef struct WffBatch WffBatch;
+typedef struct WffBatchQueue WffBatchQueue;
+typedef struct WffBatchWorker WffBatchWorker;
+
+
+/* === WffBatch === */
+// Proof files are dealt out round robin to one queue per thread before any
+// thread starts. A thread works from the back of its own queue and, once that
+// runs dry, steals from the front of the others', so a few slow proofs don't
+// leave the rest of the threads idle. Nothing is queued after the start, so a
+// thread that finds every queue empty is done.
+//
+// Every thread shares the rule index, which verification only reads, and
+// writes its reports into the slots of the files it took.
+struct WffBatch {
+    char** paths;
+    size_t path_count;
+    WffProofReport* reports;
+    WffRuleIndex* index;
+    WffBatchQueue* queues;
+    size_t thread_count;
+};
+
+// File indices in [head, tail) are still to be checked.
+struct WffBatchQueue {
+    size_t* items;
+    size_t head;
+    size_t tail;
+    pthread_mutex_t lock;
+};
+
+struct WffBatchWorker {
+    WffBatch* batch;
+    size_t id;
+};
+
+bool _wff_batch_collect(const char* path, char*** paths, size_t* count, size_t* capacity);
+void _wff_batch_add_path(char* path, char*** paths, size_t* count, size_t* capacity);
+int _wff_batch_compare_paths(const void* a, const void* b);
+bool _wff_batch_take(WffBatch* batch, size_t id, size_t* item);
+void* _wff_batch_worker(void* arg);
+void _wff_batch_check_file(WffBatch* batch, size_t item);
+char* _wff_batch_read_file(const char* path);
+void _wff_batch_print_report(const char* path, const WffProofReport* report);
+void _wff_batch_print_json_string(const char* string);
+
+#endif
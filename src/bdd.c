@@ -0,0 +1,398 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "bdd.h"
+#include "bdd_internal.h"
+
+// Nodes per allocation block.
+#define WFF_BDD_BLOCK_NODES 1024
+// Initial buckets per unique table; they double when a table fills.
+#define WFF_BDD_SUBTABLE_MIN_CAPACITY 16
+// Entries in the ITE cache (a power of two).
+#define WFF_BDD_CACHE_SIZE 16384
+// Nodes allowed before the first garbage collection; after each one, the
+// allowance is twice the nodes left alive.
+#define WFF_BDD_GC_MIN_THRESHOLD 65536
+
+
+/* === Wff === */
+
+WffBdd* wff_bdd_create(WffBddManager* manager, Wff* wff) {
+    return wff_bdd_from_parse_tree(manager, wff->parse_tree);
+}
+
+bool wff_bdd_equivalent(WffBddManager* manager, Wff* wff1, Wff* wff2) {
+    WffBdd* bdd1 = wff_bdd_create(manager, wff1);
+    WffBdd* bdd2 = wff_bdd_create(manager, wff2);
+    bool equivalent = bdd1 == bdd2;
+    wff_bdd_deref(bdd1);
+    wff_bdd_deref(bdd2);
+    return equivalent;
+}
+
+
+/* === WffBdd === */
+
+WffBdd* wff_bdd_from_parse_tree(WffBddManager* manager, WffParseTree* parse_tree) {
+    _wff_bdd_manager_maybe_gc(manager);
+    WffBddBuilder builder;
+    _wff_bdd_builder_init(&builder, manager, parse_tree->nodes->count);
+    WffBdd* result = _wff_bdd_build(&builder, parse_tree->root);
+    _wff_bdd_builder_finish(&builder);
+    wff_bdd_ref(result);
+    return result;
+}
+
+WffBdd* wff_bdd_constant(WffBddManager* manager, bool value) {
+    WffBdd* result = value ? manager->one : manager->zero;
+    wff_bdd_ref(result);
+    return result;
+}
+
+// If 'f' then 'g' else 'h'.
+WffBdd* wff_bdd_ite(WffBddManager* manager, WffBdd* f, WffBdd* g, WffBdd* h) {
+    _wff_bdd_manager_maybe_gc(manager);
+    WffBdd* result = _wff_bdd_ite(manager, f, g, h);
+    wff_bdd_ref(result);
+    return result;
+}
+
+WffBdd* wff_bdd_not(WffBddManager* manager, WffBdd* f) {
+    return wff_bdd_ite(manager, f, manager->zero, manager->one);
+}
+
+void wff_bdd_ref(WffBdd* bdd) {
+    bdd->refs++;
+}
+
+void wff_bdd_deref(WffBdd* bdd) {
+    bdd->refs--;
+}
+
+// Number of nodes reachable from 'bdd', terminals included.
+size_t wff_bdd_size(WffBdd* bdd) {
+    size_t size = _wff_bdd_size(bdd, true);
+    _wff_bdd_size(bdd, false);
+    return size;
+}
+
+// Sets the mark of every node reachable from 'bdd' to 'mark' and returns how
+// many didn't have it yet.
+size_t _wff_bdd_size(WffBdd* bdd, bool mark) {
+    if (bdd->mark == mark) {
+        return 0;
+    }
+    bdd->mark = mark;
+    if (bdd->level == WFF_BDD_TERMINAL_LEVEL) {
+        return 1;
+    }
+    return 1 + _wff_bdd_size(bdd->low, mark) + _wff_bdd_size(bdd->high, mark);
+}
+
+// If 'f' then 'g' else 'h', by Shannon expansion on the topmost variable of
+// the three. The result isn't referenced.
+WffBdd* _wff_bdd_ite(WffBddManager* manager, WffBdd* f, WffBdd* g, WffBdd* h) {
+    if (f == manager->one) {
+        return g;
+    } else if (f == manager->zero) {
+        return h;
+    } else if (g == h) {
+        return g;
+    } else if (g == manager->one && h == manager->zero) {
+        return f;
+    }
+
+    WffBddCacheEntry* entry = &manager->cache[_wff_bdd_hash(f, g, h) & manager->cache_mask];
+    if (entry->f == f && entry->g == g && entry->h == h) {
+        return entry->result;
+    }
+
+    uint32_t level = f->level;
+    if (g->level < level) {
+        level = g->level;
+    }
+    if (h->level < level) {
+        level = h->level;
+    }
+    WffBdd* high = _wff_bdd_ite(manager,
+        f->level == level ? f->high : f,
+        g->level == level ? g->high : g,
+        h->level == level ? h->high : h);
+    WffBdd* low = _wff_bdd_ite(manager,
+        f->level == level ? f->low : f,
+        g->level == level ? g->low : g,
+        h->level == level ? h->low : h);
+    WffBdd* result = _wff_bdd_node(manager, level, low, high);
+
+    // The recursion may have overwritten the slot, but it is still this one.
+    entry->f = f;
+    entry->g = g;
+    entry->h = h;
+    entry->result = result;
+    return result;
+}
+
+// Returns the unique node with the given level and children, creating it if
+// needed. The result isn't referenced.
+WffBdd* _wff_bdd_node(WffBddManager* manager, uint32_t level, WffBdd* low, WffBdd* high) {
+    if (low == high) {
+        return low;
+    }
+    WffBddSubtable* subtable = &manager->subtables[level];
+    size_t i = _wff_bdd_hash(low, high, NULL) & subtable->mask;
+    for (WffBdd* node = subtable->buckets[i]; node != NULL; node = node->next) {
+        if (node->low == low && node->high == high) {
+            return node;
+        }
+    }
+
+    WffBdd* node = _wff_bdd_manager_alloc(manager);
+    node->level = level;
+    node->refs = 0;
+    node->low = low;
+    node->high = high;
+    node->mark = false;
+    low->refs++;
+    high->refs++;
+    node->next = subtable->buckets[i];
+    subtable->buckets[i] = node;
+    subtable->count++;
+    if (subtable->count > subtable->mask) {
+        _wff_bdd_subtable_grow(subtable);
+    }
+    return node;
+}
+
+// The diagram of the variable with ID 'id', placing it if it has no level
+// yet. The result isn't referenced.
+WffBdd* _wff_bdd_variable(WffBddManager* manager, size_t id) {
+    int level = _wff_bdd_manager_place(manager, id);
+    return _wff_bdd_node(manager, level, manager->zero, manager->one);
+}
+
+
+/* === WffBddManager === */
+
+WffBddManager* wff_bdd_manager_create(const char* order) {
+    WffBddManager* manager = malloc(sizeof(WffBddManager));
+    for (size_t i = 0; i < WFF_VARIABLE_COUNT; i++) {
+        manager->levels[i] = -1;
+    }
+    manager->level_count = 0;
+    if (order != NULL) {
+        for (const char* c = order; *c != '\0'; c++) {
+            int id = _wff_variable_index(*c);
+            if (id < 0 || manager->levels[id] >= 0) {
+                free(manager);
+                return NULL;
+            }
+            _wff_bdd_manager_place(manager, id);
+        }
+    }
+
+    manager->subtables = malloc(WFF_VARIABLE_COUNT * sizeof(WffBddSubtable));
+    for (size_t i = 0; i < WFF_VARIABLE_COUNT; i++) {
+        manager->subtables[i].buckets = calloc(WFF_BDD_SUBTABLE_MIN_CAPACITY, sizeof(WffBdd*));
+        manager->subtables[i].mask = WFF_BDD_SUBTABLE_MIN_CAPACITY - 1;
+        manager->subtables[i].count = 0;
+    }
+    manager->cache = calloc(WFF_BDD_CACHE_SIZE, sizeof(WffBddCacheEntry));
+    manager->cache_mask = WFF_BDD_CACHE_SIZE - 1;
+    manager->blocks = NULL;
+    manager->free_list = NULL;
+    manager->node_count = 0;
+    manager->gc_threshold = WFF_BDD_GC_MIN_THRESHOLD;
+
+    // The terminals aren't counted or kept in a unique table, so they are
+    // never collected.
+    manager->zero = malloc(sizeof(WffBdd));
+    manager->one = malloc(sizeof(WffBdd));
+    WffBdd* terminals[2] = {manager->zero, manager->one};
+    for (int i = 0; i < 2; i++) {
+        terminals[i]->level = WFF_BDD_TERMINAL_LEVEL;
+        terminals[i]->refs = 1;
+        terminals[i]->low = NULL;
+        terminals[i]->high = NULL;
+        terminals[i]->next = NULL;
+        terminals[i]->mark = false;
+    }
+    return manager;
+}
+
+void wff_bdd_manager_destroy(WffBddManager* manager) {
+    WffBddBlock* block = manager->blocks;
+    while (block != NULL) {
+        WffBddBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    for (size_t i = 0; i < WFF_VARIABLE_COUNT; i++) {
+        free(manager->subtables[i].buckets);
+    }
+    free(manager->subtables);
+    free(manager->cache);
+    free(manager->zero);
+    free(manager->one);
+    free(manager);
+}
+
+// Frees every dead node. Going from the top level down, freeing a node
+// releases its children before their own level is swept.
+void wff_bdd_manager_gc(WffBddManager* manager) {
+    for (size_t level = 0; level < manager->level_count; level++) {
+        WffBddSubtable* subtable = &manager->subtables[level];
+        for (size_t i = 0; i <= subtable->mask; i++) {
+            WffBdd** link = &subtable->buckets[i];
+            while (*link != NULL) {
+                WffBdd* node = *link;
+                if (node->refs > 0) {
+                    link = &node->next;
+                    continue;
+                }
+                *link = node->next;
+                node->low->refs--;
+                node->high->refs--;
+                node->next = manager->free_list;
+                manager->free_list = node;
+                manager->node_count--;
+                subtable->count--;
+            }
+        }
+    }
+    memset(manager->cache, 0, (manager->cache_mask + 1) * sizeof(WffBddCacheEntry));
+    manager->gc_threshold = 2 * manager->node_count;
+    if (manager->gc_threshold < WFF_BDD_GC_MIN_THRESHOLD) {
+        manager->gc_threshold = WFF_BDD_GC_MIN_THRESHOLD;
+    }
+}
+
+// Live and dead nodes, not counting the terminals.
+size_t wff_bdd_manager_node_count(const WffBddManager* manager) {
+    return manager->node_count;
+}
+
+WffBdd* _wff_bdd_manager_alloc(WffBddManager* manager) {
+    if (manager->free_list == NULL) {
+        WffBddBlock* block = malloc(sizeof(WffBddBlock) + WFF_BDD_BLOCK_NODES * sizeof(WffBdd));
+        block->next = manager->blocks;
+        manager->blocks = block;
+        for (size_t i = 0; i < WFF_BDD_BLOCK_NODES; i++) {
+            block->nodes[i].next = manager->free_list;
+            manager->free_list = &block->nodes[i];
+        }
+    }
+    WffBdd* node = manager->free_list;
+    manager->free_list = node->next;
+    manager->node_count++;
+    return node;
+}
+
+// Collects garbage if enough nodes have been made since the last time. Only
+// called on entry to a public operation, when every node still needed is
+// referenced.
+void _wff_bdd_manager_maybe_gc(WffBddManager* manager) {
+    if (manager->node_count >= manager->gc_threshold) {
+        wff_bdd_manager_gc(manager);
+    }
+}
+
+// Returns the level of the variable with ID 'id', giving it the level below
+// all others if it has none. Diagrams already built only use higher levels,
+// so they stay ordered.
+int _wff_bdd_manager_place(WffBddManager* manager, size_t id) {
+    if (manager->levels[id] < 0) {
+        manager->levels[id] = manager->level_count;
+        manager->level_count++;
+    }
+    return manager->levels[id];
+}
+
+void _wff_bdd_subtable_grow(WffBddSubtable* subtable) {
+    size_t capacity = 2 * (subtable->mask + 1);
+    WffBdd** buckets = calloc(capacity, sizeof(WffBdd*));
+    for (size_t i = 0; i <= subtable->mask; i++) {
+        WffBdd* node = subtable->buckets[i];
+        while (node != NULL) {
+            WffBdd* next = node->next;
+            size_t j = _wff_bdd_hash(node->low, node->high, NULL) & (capacity - 1);
+            node->next = buckets[j];
+            buckets[j] = node;
+            node = next;
+        }
+    }
+    free(subtable->buckets);
+    subtable->buckets = buckets;
+    subtable->mask = capacity - 1;
+}
+
+uint64_t _wff_bdd_hash(const void* a, const void* b, const void* c) {
+    uint64_t hash = (uintptr_t) a * 0x9E3779B97F4A7C15ULL;
+    hash ^= (uintptr_t) b * 0xC2B2AE3D27D4EB4FULL;
+    hash ^= (uintptr_t) c * 0x165667B19E3779F9ULL;
+    return hash ^ (hash >> 29);
+}
+
+
+/* === WffBddBuilder === */
+
+// 'node_count' is about how many distinct nodes will be built.
+void _wff_bdd_builder_init(WffBddBuilder* builder, WffBddManager* manager, size_t node_count) {
+    builder->manager = manager;
+    wff_node_map_init(&builder->results, sizeof(WffBdd*), node_count);
+}
+
+void _wff_bdd_builder_finish(WffBddBuilder* builder) {
+    wff_node_map_finish(&builder->results);
+}
+
+// Returns the diagram of the subwff rooted at 'node', unreferenced.
+WffBdd* _wff_bdd_build(WffBddBuilder* builder, WffParseTreeNode* node) {
+    WffBdd** built = wff_node_map_get(&builder->results, node);
+    if (built != NULL) {
+        return *built;
+    }
+
+    WffBddManager* manager = builder->manager;
+    WffBdd* result;
+    if (node->child_count == 1) {
+        WffToken* token = node->children[0]->token;
+        if (token->type == WTT_CONSTANT) {
+            result = token->value ? manager->one : manager->zero;
+        } else {
+            result = _wff_bdd_variable(manager, token->variable->id);
+        }
+    } else if (node->child_count == 2) {
+        WffBdd* operand = _wff_bdd_build(builder, node->children[1]);
+        result = _wff_bdd_ite(manager, operand, manager->zero, manager->one);
+    } else {
+        WffBdd* lhs = _wff_bdd_build(builder, node->children[1]);
+        WffBdd* rhs = _wff_bdd_build(builder, node->children[3]);
+        switch (node->children[2]->token->operator) {
+            case WO_AND:
+                result = _wff_bdd_ite(manager, lhs, rhs, manager->zero);
+                break;
+            case WO_OR:
+                result = _wff_bdd_ite(manager, lhs, manager->one, rhs);
+                break;
+            case WO_COND:
+                result = _wff_bdd_ite(manager, lhs, rhs, manager->one);
+                break;
+            case WO_BICOND: {
+                WffBdd* not_rhs = _wff_bdd_ite(manager, rhs, manager->zero, manager->one);
+                result = _wff_bdd_ite(manager, lhs, rhs, not_rhs);
+                break;
+            }
+            default:
+                printf("ERROR: Unhandled case\n");
+                abort();
+        }
+    }
+
+    *(WffBdd**) wff_node_map_put(&builder->results, node) = result;
+    return result;
+}
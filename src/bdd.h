@@ -0,0 +1,37 @@
+#ifndef BDD_H_
+#define BDD_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "logic.h"
+
+
+typedef struct WffBdd WffBdd;
+typedef struct WffBddManager WffBddManager;
+
+
+// 'order' lists variables from the top of the diagrams down (e.g. "pqr");
+// variables it leaves out are placed below, in order of first appearance.
+// Pass NULL to order every variable by first appearance. Returns NULL if
+// 'order' isn't a list of distinct variables.
+WffBddManager* wff_bdd_manager_create(const char* order);
+void wff_bdd_manager_destroy(WffBddManager* manager);
+void wff_bdd_manager_gc(WffBddManager* manager);
+size_t wff_bdd_manager_node_count(const WffBddManager* manager);
+
+// Diagrams are canonical: two wffs built by the same manager are equivalent
+// iff they get the same pointer. Every function returning a diagram returns a
+// reference the caller must release with wff_bdd_deref.
+WffBdd* wff_bdd_create(WffBddManager* manager, Wff* wff);
+WffBdd* wff_bdd_from_parse_tree(WffBddManager* manager, WffParseTree* parse_tree);
+WffBdd* wff_bdd_constant(WffBddManager* manager, bool value);
+WffBdd* wff_bdd_ite(WffBddManager* manager, WffBdd* f, WffBdd* g, WffBdd* h);
+WffBdd* wff_bdd_not(WffBddManager* manager, WffBdd* f);
+void wff_bdd_ref(WffBdd* bdd);
+void wff_bdd_deref(WffBdd* bdd);
+size_t wff_bdd_size(WffBdd* bdd);
+
+bool wff_bdd_equivalent(WffBddManager* manager, Wff* wff1, Wff* wff2);
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef BDD_INTERNAL_H_
+#define BDD_INTERNAL_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic_internal.h"
+#include "bdd.h"
+
+typedef struct WffBddSubtable WffBddSubtable;
+typedef struct WffBddCacheEntry WffBddCacheEntry;
+typedef struct WffBddBlock WffBddBlock;
+typedef struct WffBddBuilder WffBddBuilder;
+
+// Level of the two terminal nodes, below every variable.
+#define WFF_BDD_TERMINAL_LEVEL UINT32_MAX
+
+
+/* === WffBdd === */
+// A node of a reduced ordered binary decision diagram: the function that is
+// 'high' where the variable at 'level' is true and 'low' where it is false.
+//
+// 'refs' counts references from callers and from parent nodes. A node whose
+// count drops to zero is dead but stays in the unique table, and can come
+// back to life if it is built again, until the next garbage collection frees
+// it.
+struct WffBdd {
+    uint32_t level;
+    uint32_t refs;
+    WffBdd* low;
+    WffBdd* high;
+    // Next node in the same unique table bucket, or in the free list.
+    WffBdd* next;
+    bool mark;
+};
+
+WffBdd* _wff_bdd_ite(WffBddManager* manager, WffBdd* f, WffBdd* g, WffBdd* h);
+WffBdd* _wff_bdd_node(WffBddManager* manager, uint32_t level, WffBdd* low, WffBdd* high);
+WffBdd* _wff_bdd_variable(WffBddManager* manager, size_t id);
+size_t _wff_bdd_size(WffBdd* bdd, bool mark);
+
+
+/* === WffBddManager === */
+// Owns every node, and keeps them reduced and unique: no node has equal
+// children, and no two nodes have the same level and children. Each level
+// has its own unique table, so garbage collection can sweep from the top
+// level down and free a dead parent before deciding about its children.
+//
+// Results of ITE are remembered in a lossy cache, each new result overwriting
+// whatever shared its slot, so repeated subformulas, even across different
+// wffs, are only combined once. The cache is cleared when nodes are freed.
+struct WffBddManager {
+    WffBdd* zero;
+    WffBdd* one;
+    // Level of each variable ID, or -1 if it hasn't been placed yet.
+    int levels[WFF_VARIABLE_COUNT];
+    size_t level_count;
+    WffBddSubtable* subtables;
+
+    WffBddCacheEntry* cache;
+    size_t cache_mask;
+
+    // Nodes are allocated in blocks so that they never move.
+    WffBddBlock* blocks;
+    WffBdd* free_list;
+    size_t node_count;
+    // Node count past which the next top level operation collects garbage.
+    size_t gc_threshold;
+};
+
+struct WffBddSubtable {
+    WffBdd** buckets;
+    size_t mask;
+    size_t count;
+};
+
+struct WffBddCacheEntry {
+    WffBdd* f;
+    WffBdd* g;
+    WffBdd* h;
+    WffBdd* result;
+};
+
+struct WffBddBlock {
+    WffBddBlock* next;
+    WffBdd nodes[];
+};
+
+WffBdd* _wff_bdd_manager_alloc(WffBddManager* manager);
+void _wff_bdd_manager_maybe_gc(WffBddManager* manager);
+int _wff_bdd_manager_place(WffBddManager* manager, size_t id);
+void _wff_bdd_subtable_grow(WffBddSubtable* subtable);
+uint64_t _wff_bdd_hash(const void* a, const void* b, const void* c);
+
+
+/* === WffBddBuilder === */
+// Builds the diagram of a parse tree. The diagram of each node already built
+// is kept in a node map, so subwffs shared within a hash-consed tree are built
+// once.
+struct WffBddBuilder {
+    WffBddManager* manager;
+    WffNodeMap results;
+};
+
+void _wff_bdd_builder_init(WffBddBuilder* builder, WffBddManager* manager, size_t node_count);
+void _wff_bdd_builder_finish(WffBddBuilder* builder);
+WffBdd* _wff_bdd_build(WffBddBuilder* builder, WffParseTreeNode* node);
+
+#endif
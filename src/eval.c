@@ -0,0 +1,362 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "eval.h"
+#include "eval_internal.h"
+#include "threads.h"
+
+// Initial instruction capacity of a program; it doubles as code is emitted.
+#define WFF_EVAL_PROGRAM_MIN_CAPACITY 64
+
+// Values of the first six variables across the 64 assignments of a word.
+const uint64_t WFF_EVAL_PATTERNS[6] = {
+    0xAAAAAAAAAAAAAAAAULL,
+    0xCCCCCCCCCCCCCCCCULL,
+    0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL,
+    0xFFFF0000FFFF0000ULL,
+    0xFFFFFFFF00000000ULL,
+};
+
+
+/* === Wff === */
+
+WffEvalVerdict wff_eval_classify(Wff* wff) {
+    uint32_t root;
+    WffEvalProgram* program = _wff_eval_program_validity(wff, NULL, &root);
+    uint64_t word_count = _wff_eval_program_word_count(program);
+    uint64_t assignment;
+    WffEvalVerdict verdict = WEV_CONTINGENT;
+    if (!_wff_eval_program_search(program, root, false, 0, word_count, &assignment)) {
+        verdict = WEV_TAUTOLOGY;
+    } else if (!_wff_eval_program_search(program, root, true, 0, word_count, &assignment)) {
+        verdict = WEV_CONTRADICTION;
+    }
+    _wff_eval_program_destroy(program);
+    return verdict;
+}
+
+bool wff_eval_is_tautology(Wff* wff) {
+    return wff_eval_classify(wff) == WEV_TAUTOLOGY;
+}
+
+bool wff_eval_is_contradiction(Wff* wff) {
+    return wff_eval_classify(wff) == WEV_CONTRADICTION;
+}
+
+// Whether the two wffs have the same truth value under every assignment to
+// the variables of either.
+bool wff_eval_equivalent(Wff* wff1, Wff* wff2) {
+    uint32_t root;
+    WffEvalProgram* program = _wff_eval_program_validity(wff1, wff2, &root);
+    uint64_t assignment;
+    bool found = _wff_eval_program_search(program, root, false, 0, _wff_eval_program_word_count(program), &assignment);
+    _wff_eval_program_destroy(program);
+    return !found;
+}
+
+bool wff_eval_parallel_is_tautology(Wff* wff, size_t thread_count, WffEvalAssignment* counterexample) {
+    return wff_eval_parallel_equivalent(wff, NULL, thread_count, counterexample);
+}
+
+// 'wff2' may be NULL, in which case this checks that 'wff1' is a tautology.
+bool wff_eval_parallel_equivalent(Wff* wff1, Wff* wff2, size_t thread_count, WffEvalAssignment* counterexample) {
+    uint32_t root;
+    WffEvalProgram* program = _wff_eval_program_validity(wff1, wff2, &root);
+    uint64_t assignment;
+    bool found = _wff_eval_sweep(program, root, thread_count, &assignment);
+    if (found && counterexample != NULL) {
+        _wff_eval_program_assignment(program, assignment, counterexample);
+    }
+    _wff_eval_program_destroy(program);
+    return !found;
+}
+
+
+/* === WffEvalProgram === */
+
+WffEvalProgram* _wff_eval_program_create() {
+    WffEvalProgram* program = malloc(sizeof(WffEvalProgram));
+    program->capacity = WFF_EVAL_PROGRAM_MIN_CAPACITY;
+    program->length = 0;
+    program->code = malloc(program->capacity * sizeof(WffEvalInstruction));
+    program->var_count = 0;
+    return program;
+}
+
+void _wff_eval_program_destroy(WffEvalProgram* program) {
+    free(program->code);
+    free(program);
+}
+
+// Appends an instruction and returns the register it writes.
+uint32_t _wff_eval_program_emit(WffEvalProgram* program, WffEvalOp op, uint32_t lhs, uint32_t rhs) {
+    if (program->length == program->capacity) {
+        program->capacity *= 2;
+        program->code = realloc(program->code, program->capacity * sizeof(WffEvalInstruction));
+    }
+    WffEvalInstruction* instruction = &program->code[program->length];
+    instruction->op = op;
+    instruction->lhs = lhs;
+    instruction->rhs = rhs;
+    program->length++;
+    return program->length - 1;
+}
+
+// Number of words it takes to cover every assignment. With six variables or
+// fewer one word does, as its lanes just repeat the same assignments.
+uint64_t _wff_eval_program_word_count(const WffEvalProgram* program) {
+    return program->var_count <= 6 ? 1 : (uint64_t) 1 << (program->var_count - 6);
+}
+
+// Evaluates words first_word to first_word + word_count - 1 (at most
+// WFF_EVAL_WORDS of them) into 'registers', which holds WFF_EVAL_WORDS words
+// per instruction.
+void _wff_eval_program_run(const WffEvalProgram* program, uint64_t first_word, size_t word_count, uint64_t* registers) {
+    for (size_t i = 0; i < program->length; i++) {
+        const WffEvalInstruction* instruction = &program->code[i];
+        uint64_t* out = registers + i * WFF_EVAL_WORDS;
+        const uint64_t* lhs = registers + (size_t) instruction->lhs * WFF_EVAL_WORDS;
+        const uint64_t* rhs = registers + (size_t) instruction->rhs * WFF_EVAL_WORDS;
+        switch (instruction->op) {
+            case WEI_VARIABLE: {
+                size_t slot = instruction->lhs;
+                for (size_t w = 0; w < word_count; w++) {
+                    out[w] = slot < 6 ? WFF_EVAL_PATTERNS[slot] : (uint64_t) 0 - (((first_word + w) >> (slot - 6)) & 1);
+                }
+                break;
+            }
+            case WEI_CONSTANT:
+                for (size_t w = 0; w < word_count; w++) {
+                    out[w] = (uint64_t) 0 - instruction->lhs;
+                }
+                break;
+            case WEI_NOT:
+                for (size_t w = 0; w < word_count; w++) {
+                    out[w] = ~lhs[w];
+                }
+                break;
+            case WEI_AND:
+                for (size_t w = 0; w < word_count; w++) {
+                    out[w] = lhs[w] & rhs[w];
+                }
+                break;
+            case WEI_OR:
+                for (size_t w = 0; w < word_count; w++) {
+                    out[w] = lhs[w] | rhs[w];
+                }
+                break;
+            case WEI_COND:
+                for (size_t w = 0; w < word_count; w++) {
+                    out[w] = ~lhs[w] | rhs[w];
+                }
+                break;
+            case WEI_BICOND:
+                for (size_t w = 0; w < word_count; w++) {
+                    out[w] = ~(lhs[w] ^ rhs[w]);
+                }
+                break;
+        }
+    }
+}
+
+// Looks through words begin to end - 1 for an assignment under which 'root'
+// has the given value. If there is one, the first is written to 'assignment'.
+bool _wff_eval_program_search(const WffEvalProgram* program, uint32_t root, bool value, uint64_t begin, uint64_t end, uint64_t* assignment) {
+    uint64_t* registers = malloc(program->length * WFF_EVAL_WORDS * sizeof(uint64_t));
+    bool found = _wff_eval_program_search_range(program, root, value, begin, end, registers, NULL, assignment);
+    free(registers);
+    return found;
+}
+
+// Same as _wff_eval_program_search, but with the caller's scratch registers.
+// Gives up early, returning false, once 'cancel' (if given) is set.
+bool _wff_eval_program_search_range(const WffEvalProgram* program, uint32_t root, bool value, uint64_t begin, uint64_t end, uint64_t* registers, atomic_bool* cancel, uint64_t* assignment) {
+    bool found = false;
+    for (uint64_t word = begin; word < end && !found; word += WFF_EVAL_WORDS) {
+        if (cancel != NULL && atomic_load_explicit(cancel, memory_order_relaxed)) {
+            return false;
+        }
+        size_t word_count = end - word < WFF_EVAL_WORDS ? end - word : WFF_EVAL_WORDS;
+        _wff_eval_program_run(program, word, word_count, registers);
+        const uint64_t* result = registers + (size_t) root * WFF_EVAL_WORDS;
+        for (size_t w = 0; w < word_count; w++) {
+            uint64_t hits = value ? result[w] : ~result[w];
+            if (hits != 0) {
+                *assignment = (word + w) * 64 + __builtin_ctzll(hits);
+                found = true;
+                break;
+            }
+        }
+    }
+
+    // With fewer than six variables, the high bits of a lane number don't
+    // belong to any variable.
+    if (found && program->var_count < 6) {
+        *assignment &= ((uint64_t) 1 << program->var_count) - 1;
+    }
+    return found;
+}
+
+// Compiles 'wff1', or '(wff1 <=> wff2)' if 'wff2' is given, and sets *root to
+// the register that is true under every assignment iff that wff is valid.
+WffEvalProgram* _wff_eval_program_validity(Wff* wff1, Wff* wff2, uint32_t* root) {
+    WffEvalProgram* program = _wff_eval_program_create();
+    WffEvalCompiler compiler;
+    size_t node_count = wff1->parse_tree->nodes->count + (wff2 == NULL ? 0 : wff2->parse_tree->nodes->count);
+    _wff_eval_compiler_init(&compiler, program, node_count);
+    *root = _wff_eval_compile(&compiler, wff1->parse_tree->root);
+    if (wff2 != NULL) {
+        uint32_t root2 = _wff_eval_compile(&compiler, wff2->parse_tree->root);
+        *root = _wff_eval_program_emit(program, WEI_BICOND, *root, root2);
+    }
+    _wff_eval_compiler_finish(&compiler);
+    return program;
+}
+
+void _wff_eval_program_assignment(const WffEvalProgram* program, uint64_t assignment, WffEvalAssignment* out) {
+    out->var_count = program->var_count;
+    for (size_t i = 0; i < program->var_count; i++) {
+        out->names[i] = WFF_VARIABLES[program->var_ids[i]].string[0];
+        out->values[i] = (assignment >> i) & 1;
+    }
+}
+
+
+/* === WffEvalSweep === */
+
+// Looks for an assignment under which 'root' is false using 'thread_count'
+// threads (0 for one per processor).
+bool _wff_eval_sweep(const WffEvalProgram* program, uint32_t root, size_t thread_count, uint64_t* assignment) {
+    WffEvalSweep sweep;
+    sweep.program = program;
+    sweep.root = root;
+    sweep.word_count = _wff_eval_program_word_count(program);
+    atomic_init(&sweep.next_chunk, 0);
+    atomic_init(&sweep.found, false);
+    pthread_mutex_init(&sweep.lock, NULL);
+
+    thread_count = wff_threads_resolve(thread_count);
+    // No point in more threads than chunks.
+    uint64_t chunk_count = (sweep.word_count + WFF_EVAL_CHUNK_WORDS - 1) / WFF_EVAL_CHUNK_WORDS;
+    if (thread_count > chunk_count) {
+        thread_count = chunk_count;
+    }
+
+    pthread_t threads[thread_count];
+    for (size_t i = 1; i < thread_count; i++) {
+        pthread_create(&threads[i], NULL, _wff_eval_sweep_worker, &sweep);
+    }
+    // The calling thread does its share too.
+    _wff_eval_sweep_worker(&sweep);
+    for (size_t i = 1; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&sweep.lock);
+
+    bool found = atomic_load(&sweep.found);
+    if (found) {
+        *assignment = sweep.assignment;
+    }
+    return found;
+}
+
+void* _wff_eval_sweep_worker(void* arg) {
+    WffEvalSweep* sweep = arg;
+    uint64_t* registers = malloc(sweep->program->length * WFF_EVAL_WORDS * sizeof(uint64_t));
+    while (!atomic_load_explicit(&sweep->found, memory_order_relaxed)) {
+        uint64_t begin = atomic_fetch_add(&sweep->next_chunk, 1) * WFF_EVAL_CHUNK_WORDS;
+        if (begin >= sweep->word_count) {
+            break;
+        }
+        uint64_t end = sweep->word_count - begin < WFF_EVAL_CHUNK_WORDS ? sweep->word_count : begin + WFF_EVAL_CHUNK_WORDS;
+        uint64_t assignment;
+        if (_wff_eval_program_search_range(sweep->program, sweep->root, false, begin, end, registers, &sweep->found, &assignment)) {
+            // Only the first thread to find one reports it.
+            pthread_mutex_lock(&sweep->lock);
+            if (!atomic_load(&sweep->found)) {
+                sweep->assignment = assignment;
+                atomic_store(&sweep->found, true);
+            }
+            pthread_mutex_unlock(&sweep->lock);
+        }
+    }
+    free(registers);
+    return NULL;
+}
+
+
+/* === WffEvalCompiler === */
+
+// 'node_count' is about how many distinct nodes will be compiled.
+void _wff_eval_compiler_init(WffEvalCompiler* compiler, WffEvalProgram* program, size_t node_count) {
+    compiler->program = program;
+    wff_node_map_init(&compiler->registers, sizeof(uint32_t), node_count);
+    for (size_t i = 0; i < WFF_VARIABLE_COUNT; i++) {
+        compiler->var_slots[i] = -1;
+    }
+}
+
+void _wff_eval_compiler_finish(WffEvalCompiler* compiler) {
+    wff_node_map_finish(&compiler->registers);
+}
+
+// Returns the register holding the value of the subwff rooted at 'node'.
+uint32_t _wff_eval_compile(WffEvalCompiler* compiler, WffParseTreeNode* node) {
+    uint32_t* compiled = wff_node_map_get(&compiler->registers, node);
+    if (compiled != NULL) {
+        return *compiled;
+    }
+
+    WffEvalProgram* program = compiler->program;
+    uint32_t result;
+    if (node->child_count == 1) {
+        WffToken* token = node->children[0]->token;
+        if (token->type == WTT_CONSTANT) {
+            result = _wff_eval_program_emit(program, WEI_CONSTANT, token->value, 0);
+        } else {
+            size_t id = token->variable->id;
+            if (compiler->var_slots[id] < 0) {
+                compiler->var_slots[id] = program->var_count;
+                program->var_ids[program->var_count] = id;
+                program->var_count++;
+            }
+            result = _wff_eval_program_emit(program, WEI_VARIABLE, compiler->var_slots[id], 0);
+        }
+    } else if (node->child_count == 2) {
+        uint32_t operand = _wff_eval_compile(compiler, node->children[1]);
+        result = _wff_eval_program_emit(program, WEI_NOT, operand, 0);
+    } else {
+        uint32_t lhs = _wff_eval_compile(compiler, node->children[1]);
+        uint32_t rhs = _wff_eval_compile(compiler, node->children[3]);
+        WffEvalOp op;
+        switch (node->children[2]->token->operator) {
+            case WO_AND:
+                op = WEI_AND;
+                break;
+            case WO_OR:
+                op = WEI_OR;
+                break;
+            case WO_COND:
+                op = WEI_COND;
+                break;
+            case WO_BICOND:
+                op = WEI_BICOND;
+                break;
+            default:
+                printf("ERROR: Unhandled case\n");
+                abort();
+        }
+        result = _wff_eval_program_emit(program, op, lhs, rhs);
+    }
+
+    *(uint32_t*) wff_node_map_put(&compiler->registers, node) = result;
+    return result;
+}
@@ -0,0 +1,39 @@
+#ifndef EVAL_H_
+#define EVAL_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "logic.h"
+
+
+typedef struct WffEvalAssignment WffEvalAssignment;
+
+typedef enum {
+    WEV_CONTINGENT,
+    WEV_TAUTOLOGY,
+    WEV_CONTRADICTION
+} WffEvalVerdict;
+
+// Truth values for the variables of a wff: the i-th variable is the letter
+// names[i] and has the value values[i]. There is room for every variable a
+// wff can have.
+struct WffEvalAssignment {
+    size_t var_count;
+    char names[52];
+    bool values[52];
+};
+
+
+WffEvalVerdict wff_eval_classify(Wff* wff);
+bool wff_eval_is_tautology(Wff* wff);
+bool wff_eval_is_contradiction(Wff* wff);
+bool wff_eval_equivalent(Wff* wff1, Wff* wff2);
+
+// Same checks, with the assignments split among 'thread_count' threads (0 for
+// one per processor). If the answer is no and 'counterexample' isn't NULL, an
+// assignment that shows it is written there.
+bool wff_eval_parallel_is_tautology(Wff* wff, size_t thread_count, WffEvalAssignment* counterexample);
+bool wff_eval_parallel_equivalent(Wff* wff1, Wff* wff2, size_t thread_count, WffEvalAssignment* counterexample);
+
+#endif
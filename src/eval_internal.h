@@ -0,0 +1,106 @@
+#ifndef EVAL_INTERNAL_H_
+#define EVAL_INTERNAL_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "logic_internal.h"
+#include "eval.h"
+
+typedef struct WffEvalProgram WffEvalProgram;
+typedef struct WffEvalInstruction WffEvalInstruction;
+typedef struct WffEvalCompiler WffEvalCompiler;
+typedef struct WffEvalSweep WffEvalSweep;
+
+// Words each instruction works on at a time. Every bit of a word is one truth
+// assignment, so this is 512 assignments per step: one AVX-512 register or
+// two AVX2 ones, if the compiler vectorizes the loops over it.
+#define WFF_EVAL_WORDS 8
+// Words a thread of a parallel sweep claims at a time. A chunk covers every
+// assignment of the low variables for one assignment of the rest, so claiming
+// chunk c fixes the high variables to the bits of c.
+#define WFF_EVAL_CHUNK_WORDS 1024
+
+typedef enum {
+    WEI_VARIABLE,
+    WEI_CONSTANT,
+    WEI_NOT,
+    WEI_AND,
+    WEI_OR,
+    WEI_COND,
+    WEI_BICOND
+} WffEvalOp;
+
+
+/* === WffEvalProgram === */
+// A wff (or several) compiled to straight-line code over bit vectors, one
+// instruction per distinct subwff, operands first. Instruction i writes
+// register i.
+//
+// Assignments are numbered so that bit k of the number is the value of the
+// k-th variable; word w covers assignments 64w to 64w + 63. The first six
+// variables therefore vary within a word and the rest are constant across it.
+struct WffEvalProgram {
+    WffEvalInstruction* code;
+    size_t length;
+    size_t capacity;
+    // ID of the variable in each slot, in order of first appearance.
+    size_t var_count;
+    size_t var_ids[WFF_VARIABLE_COUNT];
+};
+
+struct WffEvalInstruction {
+    WffEvalOp op;
+    // Operand registers; for a variable 'lhs' is its slot, and for a constant
+    // it is the constant's value.
+    uint32_t lhs;
+    uint32_t rhs;
+};
+
+WffEvalProgram* _wff_eval_program_create();
+void _wff_eval_program_destroy(WffEvalProgram* program);
+uint32_t _wff_eval_program_emit(WffEvalProgram* program, WffEvalOp op, uint32_t lhs, uint32_t rhs);
+uint64_t _wff_eval_program_word_count(const WffEvalProgram* program);
+void _wff_eval_program_run(const WffEvalProgram* program, uint64_t first_word, size_t word_count, uint64_t* registers);
+bool _wff_eval_program_search(const WffEvalProgram* program, uint32_t root, bool value, uint64_t begin, uint64_t end, uint64_t* assignment);
+bool _wff_eval_program_search_range(const WffEvalProgram* program, uint32_t root, bool value, uint64_t begin, uint64_t end, uint64_t* registers, atomic_bool* cancel, uint64_t* assignment);
+WffEvalProgram* _wff_eval_program_validity(Wff* wff1, Wff* wff2, uint32_t* root);
+void _wff_eval_program_assignment(const WffEvalProgram* program, uint64_t assignment, WffEvalAssignment* out);
+
+
+/* === WffEvalSweep === */
+// A search for an assignment under which 'root' is false, shared by the
+// threads of a parallel sweep. Threads claim chunks in order until the
+// chunks run out or one of them finds an assignment, which stops the rest.
+struct WffEvalSweep {
+    const WffEvalProgram* program;
+    uint32_t root;
+    uint64_t word_count;
+    atomic_uint_fast64_t next_chunk;
+    atomic_bool found;
+    pthread_mutex_t lock;
+    uint64_t assignment;
+};
+
+bool _wff_eval_sweep(const WffEvalProgram* program, uint32_t root, size_t thread_count, uint64_t* assignment);
+void* _wff_eval_sweep_worker(void* arg);
+
+
+/* === WffEvalCompiler === */
+// Compiles parse trees into a program. The register of each node already
+// compiled is kept in a node map, so subwffs shared within a hash-consed tree
+// are computed once.
+struct WffEvalCompiler {
+    WffEvalProgram* program;
+    WffNodeMap registers;
+    int var_slots[WFF_VARIABLE_COUNT];
+};
+
+void _wff_eval_compiler_init(WffEvalCompiler* compiler, WffEvalProgram* program, size_t node_count);
+void _wff_eval_compiler_finish(WffEvalCompiler* compiler);
+uint32_t _wff_eval_compile(WffEvalCompiler* compiler, WffParseTreeNode* node);
+
+#endif
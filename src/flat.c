@@ -0,0 +1,380 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "flat.h"
+#include "flat_internal.h"
+
+// Initial node capacity of a flat tree; it doubles as nodes are pushed.
+#define WFF_FLAT_TREE_MIN_CAPACITY 64
+// Marks a pattern variable that hasn't been bound yet.
+#define WFF_FLAT_UNBOUND SIZE_MAX
+
+
+/* === WffFlatTree === */
+
+// Parses 'wff_string' straight into a flat tree. Returns NULL if it isn't a
+// valid wff.
+WffFlatTree* wff_flat_tree_create(const char* wff_string) {
+    WffFlatTree* tree = _wff_flat_tree_create(WFF_FLAT_TREE_MIN_CAPACITY);
+    const char* cursor = wff_string;
+    if (!_wff_flat_tree_parse(tree, &cursor) || _wff_lex(&cursor) != NULL || *cursor != '\0') {
+        wff_flat_tree_destroy(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+// Flattens a parse tree. Shared subtrees of a hash-consed tree are written out
+// once per occurrence.
+WffFlatTree* wff_flat_tree_from_parse_tree(WffParseTree* parse_tree) {
+    WffFlatTree* tree = _wff_flat_tree_create(WFF_FLAT_TREE_MIN_CAPACITY);
+    _wff_flat_tree_from_parse_tree(tree, parse_tree->root);
+    return tree;
+}
+
+void wff_flat_tree_destroy(WffFlatTree* tree) {
+    free(tree->nodes);
+    free(tree);
+}
+
+size_t wff_flat_tree_length(const WffFlatTree* tree) {
+    return tree->length;
+}
+
+// Writes the index of every variable occurrence to 'indices', which must have
+// room for wff_flat_tree_length(tree) entries, and returns how many there are.
+size_t wff_flat_tree_find_vars(const WffFlatTree* tree, size_t* indices) {
+    size_t count = 0;
+    for (size_t i = 0; i < tree->length; i++) {
+        if (tree->nodes[i].symbol == WFS_VARIABLE) {
+            indices[count] = i;
+            count++;
+        }
+    }
+    return count;
+}
+
+bool wff_flat_tree_subtree_equals(const WffFlatTree* tree1, size_t index1, const WffFlatTree* tree2, size_t index2) {
+    const WffFlatNode* nodes1 = tree1->nodes + index1;
+    const WffFlatNode* nodes2 = tree2->nodes + index2;
+    if (nodes1->size != nodes2->size) {
+        return false;
+    }
+    // Equal preorder sequences with equal sizes are equal trees.
+    for (size_t i = 0; i < nodes1->size; i++) {
+        if (nodes1[i].symbol != nodes2[i].symbol || nodes1[i].value != nodes2[i].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Writes every site at which 'pattern' matches to 'sites', which must have
+// room for wff_flat_tree_length(tree) entries, and returns how many there are.
+// Variables of the pattern match any subwff, the same one wherever they repeat.
+size_t wff_flat_tree_match(const WffFlatTree* tree, const WffFlatTree* pattern, size_t* sites) {
+    size_t bindings[WFF_VARIABLE_COUNT];
+    for (size_t i = 0; i < WFF_VARIABLE_COUNT; i++) {
+        bindings[i] = WFF_FLAT_UNBOUND;
+    }
+    size_t count = 0;
+    for (size_t site = 0; site < tree->length; site++) {
+        if (_wff_flat_tree_match_at(tree, site, pattern, bindings)) {
+            sites[count] = site;
+            count++;
+        }
+        _wff_flat_tree_clear_bindings(pattern, bindings);
+    }
+    return count;
+}
+
+// Returns a new tree with the subwff at 'site' rewritten from 'search' to
+// 'replace', or NULL if 'search' doesn't match there. Variables of 'replace'
+// that aren't in 'search' are kept as is.
+WffFlatTree* wff_flat_tree_substitute(const WffFlatTree* tree, size_t site, const WffFlatTree* search, const WffFlatTree* replace) {
+    size_t bindings[WFF_VARIABLE_COUNT];
+    for (size_t i = 0; i < WFF_VARIABLE_COUNT; i++) {
+        bindings[i] = WFF_FLAT_UNBOUND;
+    }
+    if (site >= tree->length || !_wff_flat_tree_match_at(tree, site, search, bindings)) {
+        return NULL;
+    }
+
+    size_t old_size = tree->nodes[site].size;
+    WffFlatTree* result = _wff_flat_tree_create(tree->length);
+    _wff_flat_tree_append_range(result, tree, 0, site);
+    size_t index = 0;
+    _wff_flat_tree_instantiate(result, tree, replace, &index, bindings);
+    size_t new_size = result->length - site;
+    _wff_flat_tree_append_range(result, tree, site + old_size, tree->length - site - old_size);
+
+    // Only the ancestors of the site change size. Operands that come before
+    // the site are untouched, so their sizes can still be used to skip them.
+    size_t i = 0;
+    while (i != site) {
+        result->nodes[i].size = result->nodes[i].size - old_size + new_size;
+        size_t child = i + 1;
+        while (child + result->nodes[child].size <= site) {
+            child += result->nodes[child].size;
+        }
+        i = child;
+    }
+    return result;
+}
+
+// Renders the subwff at 'index' into a new string in the same format as
+// wff_parse_tree_get_subwff_string. The caller frees it.
+char* wff_flat_tree_get_subwff_string(const WffFlatTree* tree, size_t index) {
+    // Each node prints the same text wherever it is, so the length is just a
+    // sum over the subtree.
+    size_t length = 0;
+    for (size_t i = index; i < index + tree->nodes[index].size; i++) {
+        WffFlatSymbol symbol = tree->nodes[i].symbol;
+        if (symbol == WFS_VARIABLE || symbol == WFS_CONSTANT) {
+            // Variable names and constants are a single character.
+            length += 1;
+        } else {
+            length += strlen(_wff_flat_symbol_string(symbol));
+        }
+        if (_wff_flat_symbol_arity(symbol) == 2) {
+            length += strlen(STR_LPAREN) + strlen(STR_RPAREN);
+        }
+    }
+    char* string = malloc((length + 1) * sizeof(char));
+    char* end = _wff_flat_tree_render(tree, index, string);
+    *end = '\0';
+    return string;
+}
+
+WffFlatTree* _wff_flat_tree_create(size_t capacity) {
+    WffFlatTree* tree = malloc(sizeof(WffFlatTree));
+    tree->capacity = capacity < WFF_FLAT_TREE_MIN_CAPACITY ? WFF_FLAT_TREE_MIN_CAPACITY : capacity;
+    tree->length = 0;
+    tree->nodes = malloc(tree->capacity * sizeof(WffFlatNode));
+    return tree;
+}
+
+// Appends a node with a size of 1. The returned pointer is only valid until
+// the next push.
+WffFlatNode* _wff_flat_tree_push(WffFlatTree* tree, WffFlatSymbol symbol, uint8_t value) {
+    if (tree->length == tree->capacity) {
+        tree->capacity *= 2;
+        tree->nodes = realloc(tree->nodes, tree->capacity * sizeof(WffFlatNode));
+    }
+    WffFlatNode* node = &tree->nodes[tree->length];
+    node->symbol = symbol;
+    node->value = value;
+    node->size = 1;
+    tree->length++;
+    return node;
+}
+
+// Same grammar as _wff_parse, but appends nodes in preorder instead of
+// building them bottom-up.
+bool _wff_flat_tree_parse(WffFlatTree* tree, const char** cursor) {
+    size_t index = tree->length;
+    WffToken* next = _wff_lex(cursor);
+    if (next == NULL) {
+        return false;
+    } else if (next->type == WTT_PROPOSITION) {
+        _wff_flat_tree_push(tree, WFS_VARIABLE, next->variable->id);
+    } else if (next->type == WTT_CONSTANT) {
+        _wff_flat_tree_push(tree, WFS_CONSTANT, next->value);
+    } else if (next->type == WTT_OPERATOR && next->operator == WO_NOT) {
+        _wff_flat_tree_push(tree, WFS_NOT, 0);
+        if (!_wff_flat_tree_parse(tree, cursor)) {
+            return false;
+        }
+    } else if (next->type == WTT_LPAREN) {
+        // The operator comes after the first operand, so the symbol is filled
+        // in once it is known.
+        _wff_flat_tree_push(tree, WFS_AND, 0);
+        if (!_wff_flat_tree_parse(tree, cursor)) {
+            return false;
+        }
+        next = _wff_lex(cursor);
+        if (next == NULL || next->type != WTT_OPERATOR || next->operator == WO_NOT) {
+            return false;
+        }
+        tree->nodes[index].symbol = _wff_flat_symbol_from_operator(next->operator);
+        if (!_wff_flat_tree_parse(tree, cursor)) {
+            return false;
+        }
+        next = _wff_lex(cursor);
+        if (next == NULL || next->type != WTT_RPAREN) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    tree->nodes[index].size = tree->length - index;
+    return true;
+}
+
+void _wff_flat_tree_from_parse_tree(WffFlatTree* tree, WffParseTreeNode* node) {
+    size_t index = tree->length;
+    if (node->type == WPTNT_SEARCHVAR) {
+        _wff_flat_tree_push(tree, WFS_VARIABLE, node->token->variable->id);
+    } else if (node->child_count == 1) {
+        WffToken* token = node->children[0]->token;
+        if (token->type == WTT_CONSTANT) {
+            _wff_flat_tree_push(tree, WFS_CONSTANT, token->value);
+        } else {
+            _wff_flat_tree_push(tree, WFS_VARIABLE, token->variable->id);
+        }
+    } else if (node->child_count == 2) {
+        _wff_flat_tree_push(tree, WFS_NOT, 0);
+        _wff_flat_tree_from_parse_tree(tree, node->children[1]);
+    } else {
+        _wff_flat_tree_push(tree, _wff_flat_symbol_from_operator(node->children[2]->token->operator), 0);
+        _wff_flat_tree_from_parse_tree(tree, node->children[1]);
+        _wff_flat_tree_from_parse_tree(tree, node->children[3]);
+    }
+    tree->nodes[index].size = tree->length - index;
+}
+
+// Walks the pattern and the subwff at 'site' side by side in preorder. A
+// pattern variable swallows the whole operand it lines up with, which is
+// bound in 'bindings' (indexed by variable ID) to the operand's index.
+bool _wff_flat_tree_match_at(const WffFlatTree* tree, size_t site, const WffFlatTree* pattern, size_t* bindings) {
+    size_t i = site;
+    for (size_t j = 0; j < pattern->length; j++) {
+        const WffFlatNode* pattern_node = &pattern->nodes[j];
+        const WffFlatNode* node = &tree->nodes[i];
+        if (pattern_node->symbol == WFS_VARIABLE) {
+            size_t* binding = &bindings[pattern_node->value];
+            if (*binding == WFF_FLAT_UNBOUND) {
+                *binding = i;
+            } else if (!wff_flat_tree_subtree_equals(tree, *binding, tree, i)) {
+                return false;
+            }
+            i += node->size;
+        } else if (node->symbol == pattern_node->symbol && node->value == pattern_node->value) {
+            i++;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void _wff_flat_tree_clear_bindings(const WffFlatTree* pattern, size_t* bindings) {
+    for (size_t j = 0; j < pattern->length; j++) {
+        if (pattern->nodes[j].symbol == WFS_VARIABLE) {
+            bindings[pattern->nodes[j].value] = WFF_FLAT_UNBOUND;
+        }
+    }
+}
+
+// Appends the template subtree at *index, copying in the subwff of 'source'
+// bound to each variable, and moves *index past it.
+void _wff_flat_tree_instantiate(WffFlatTree* out, const WffFlatTree* source, const WffFlatTree* template, size_t* index, const size_t* bindings) {
+    const WffFlatNode template_node = template->nodes[*index];
+    (*index)++;
+    if (template_node.symbol == WFS_VARIABLE && bindings[template_node.value] != WFF_FLAT_UNBOUND) {
+        size_t start = bindings[template_node.value];
+        _wff_flat_tree_append_range(out, source, start, source->nodes[start].size);
+        return;
+    }
+
+    size_t start = out->length;
+    _wff_flat_tree_push(out, template_node.symbol, template_node.value);
+    for (int i = 0; i < _wff_flat_symbol_arity(template_node.symbol); i++) {
+        _wff_flat_tree_instantiate(out, source, template, index, bindings);
+    }
+    out->nodes[start].size = out->length - start;
+}
+
+void _wff_flat_tree_append_range(WffFlatTree* out, const WffFlatTree* source, size_t start, size_t count) {
+    if (out->length + count > out->capacity) {
+        while (out->length + count > out->capacity) {
+            out->capacity *= 2;
+        }
+        out->nodes = realloc(out->nodes, out->capacity * sizeof(WffFlatNode));
+    }
+    memcpy(out->nodes + out->length, source->nodes + start, count * sizeof(WffFlatNode));
+    out->length += count;
+}
+
+// Writes the subwff at 'index' to 'out' and returns the end of what was
+// written (not NUL-terminated).
+char* _wff_flat_tree_render(const WffFlatTree* tree, size_t index, char* out) {
+    const WffFlatNode* node = &tree->nodes[index];
+    const char* string;
+    switch (node->symbol) {
+        case WFS_VARIABLE:
+            string = WFF_VARIABLES[node->value].string;
+            break;
+        case WFS_CONSTANT:
+            string = node->value ? STR_TRUE : STR_FALSE;
+            break;
+        case WFS_NOT:
+            out = stpcpy(out, STR_NOT);
+            return _wff_flat_tree_render(tree, index + 1, out);
+        default: {
+            size_t rhs = index + 1 + tree->nodes[index + 1].size;
+            out = stpcpy(out, STR_LPAREN);
+            out = _wff_flat_tree_render(tree, index + 1, out);
+            out = stpcpy(out, _wff_flat_symbol_string(node->symbol));
+            out = _wff_flat_tree_render(tree, rhs, out);
+            return stpcpy(out, STR_RPAREN);
+        }
+    }
+    return stpcpy(out, string);
+}
+
+
+/* === WffFlatSymbol === */
+
+WffFlatSymbol _wff_flat_symbol_from_operator(WffOperator operator) {
+    switch (operator) {
+        case WO_NOT:
+            return WFS_NOT;
+        case WO_AND:
+            return WFS_AND;
+        case WO_OR:
+            return WFS_OR;
+        case WO_COND:
+            return WFS_COND;
+        case WO_BICOND:
+            return WFS_BICOND;
+    }
+    printf("ERROR: Case not handled\n");
+    abort();
+}
+
+int _wff_flat_symbol_arity(WffFlatSymbol symbol) {
+    switch (symbol) {
+        case WFS_VARIABLE:
+        case WFS_CONSTANT:
+            return 0;
+        case WFS_NOT:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+// Operators only: variables and constants depend on the node's value.
+const char* _wff_flat_symbol_string(WffFlatSymbol symbol) {
+    switch (symbol) {
+        case WFS_NOT:
+            return STR_NOT;
+        case WFS_AND:
+            return STR_AND;
+        case WFS_OR:
+            return STR_OR;
+        case WFS_COND:
+            return STR_COND;
+        case WFS_BICOND:
+            return STR_BICOND;
+        default:
+            printf("ERROR: Case not handled\n");
+            abort();
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef FLAT_H_
+#define FLAT_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "logic.h"
+
+
+typedef struct WffFlatTree WffFlatTree;
+
+
+WffFlatTree* wff_flat_tree_create(const char* wff_string);
+WffFlatTree* wff_flat_tree_from_parse_tree(WffParseTree* parse_tree);
+void wff_flat_tree_destroy(WffFlatTree* tree);
+size_t wff_flat_tree_length(const WffFlatTree* tree);
+
+size_t wff_flat_tree_find_vars(const WffFlatTree* tree, size_t* indices);
+bool wff_flat_tree_subtree_equals(const WffFlatTree* tree1, size_t index1, const WffFlatTree* tree2, size_t index2);
+size_t wff_flat_tree_match(const WffFlatTree* tree, const WffFlatTree* pattern, size_t* sites);
+WffFlatTree* wff_flat_tree_substitute(const WffFlatTree* tree, size_t site, const WffFlatTree* search, const WffFlatTree* replace);
+char* wff_flat_tree_get_subwff_string(const WffFlatTree* tree, size_t index);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef FLAT_INTERNAL_H_
+#define FLAT_INTERNAL_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic_internal.h"
+#include "flat.h"
+
+typedef struct WffFlatNode WffFlatNode;
+
+typedef enum {
+    WFS_VARIABLE,
+    WFS_CONSTANT,
+    WFS_NOT,
+    WFS_AND,
+    WFS_OR,
+    WFS_COND,
+    WFS_BICOND
+} WffFlatSymbol;
+
+
+/* === WffFlatTree === */
+// A wff stored as one array of nodes in preorder, for formulas too large to
+// traverse comfortably through pointers. Only nonterminals get a node (the
+// parentheses and operator tokens are implied by the symbol), so a node's
+// index is also its site as counted by _wff_match_traversal. Operands follow
+// their operator directly, and each node records the size of its subtree so
+// that a whole operand can be skipped in one step.
+struct WffFlatTree {
+    WffFlatNode* nodes;
+    size_t length;
+    size_t capacity;
+};
+
+struct WffFlatNode {
+    // A WffFlatSymbol, kept small so that more nodes fit in a cache line.
+    uint8_t symbol;
+    // Variable ID or constant value; 0 for operators.
+    uint8_t value;
+    // Number of nodes in this subtree, including this one.
+    uint32_t size;
+};
+
+WffFlatTree* _wff_flat_tree_create(size_t capacity);
+WffFlatNode* _wff_flat_tree_push(WffFlatTree* tree, WffFlatSymbol symbol, uint8_t value);
+bool _wff_flat_tree_parse(WffFlatTree* tree, const char** cursor);
+void _wff_flat_tree_from_parse_tree(WffFlatTree* tree, WffParseTreeNode* node);
+bool _wff_flat_tree_match_at(const WffFlatTree* tree, size_t site, const WffFlatTree* pattern, size_t* bindings);
+void _wff_flat_tree_clear_bindings(const WffFlatTree* pattern, size_t* bindings);
+void _wff_flat_tree_instantiate(WffFlatTree* out, const WffFlatTree* source, const WffFlatTree* template, size_t* index, const size_t* bindings);
+void _wff_flat_tree_append_range(WffFlatTree* out, const WffFlatTree* source, size_t start, size_t count);
+char* _wff_flat_tree_render(const WffFlatTree* tree, size_t index, char* out);
+WffFlatSymbol _wff_flat_symbol_from_operator(WffOperator operator);
+int _wff_flat_symbol_arity(WffFlatSymbol symbol);
+const char* _wff_flat_symbol_string(WffFlatSymbol symbol);
+
+#endif
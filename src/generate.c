@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "generate.h"
+#include "generate_internal.h"
+
+// In the order they're used as var_count grows.
+const char* const WFF_GENERATOR_LETTERS = "pqrsabcdefghijklmnotuwxyzABCDEGHIJKLMNOPQRSUVWXYZ";
+
+
+/* === WffGenerator === */
+
+void wff_generator_init(WffGenerator* generator, uint64_t seed) {
+    generator->state = seed;
+    generator->var_count = 8;
+    generator->max_depth = 100;
+    // ~ ^ v => <=>
+    unsigned weights[WFF_GENERATOR_OPERATOR_COUNT] = {1, 2, 2, 1, 1};
+    memcpy(generator->weights, weights, sizeof(weights));
+}
+
+char* wff_generator_string(WffGenerator* generator, size_t node_count) {
+    // Each binary operator, the most costly node, takes "(", " <=> " and ")".
+    char* string = malloc((node_count * 7 + 1) * sizeof(char));
+    char* end = _wff_generator_write(generator, string, node_count > 0 ? node_count : 1, 0);
+    *end = '\0';
+    return string;
+}
+
+// splitmix64, which is fine with any seed, 0 included.
+uint64_t _wff_generator_next(WffGenerator* generator) {
+    uint64_t z = (generator->state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+// A number from 0 to bound - 1; bound is small enough that the bias from the
+// modulo doesn't matter.
+size_t _wff_generator_below(WffGenerator* generator, size_t bound) {
+    return _wff_generator_next(generator) % bound;
+}
+
+// Picks an operator for a subwff of 'node_count' nodes, or returns -1 if none
+// fits: a binary operator needs at least three.
+int _wff_generator_operator(WffGenerator* generator, size_t node_count) {
+    int last = node_count >= 3 ? WO_BICOND : WO_NOT;
+    size_t total = 0;
+    for (int op = WO_NOT; op <= last; op++) {
+        total += generator->weights[op];
+    }
+    if (total == 0) {
+        return -1;
+    }
+    size_t pick = _wff_generator_below(generator, total);
+    int op = WO_NOT;
+    while (pick >= generator->weights[op]) {
+        pick -= generator->weights[op];
+        op++;
+    }
+    return op;
+}
+
+// Writes a subwff of up to 'node_count' nodes at 'out' and returns the end of
+// it. A binary operator splits what's left between its operands at random, so
+// the wffs come out about as deep as a random binary search tree.
+char* _wff_generator_write(WffGenerator* generator, char* out, size_t node_count, size_t depth) {
+    int op = node_count > 1 && depth < generator->max_depth ? _wff_generator_operator(generator, node_count) : -1;
+    if (op < 0) {
+        size_t var_count = generator->var_count;
+        if (var_count < 1) {
+            var_count = 1;
+        } else if (var_count > WFF_GENERATOR_MAX_VARIABLES) {
+            var_count = WFF_GENERATOR_MAX_VARIABLES;
+        }
+        *out++ = WFF_GENERATOR_LETTERS[_wff_generator_below(generator, var_count)];
+        return out;
+    }
+
+    const char* op_string = wff_token_get_string(&(WffToken){.type = WTT_OPERATOR, .operator = op});
+    if (op == WO_NOT) {
+        out = stpcpy(out, op_string);
+        return _wff_generator_write(generator, out, node_count - 1, depth + 1);
+    }
+    size_t left = 1 + _wff_generator_below(generator, node_count - 2);
+    *out++ = '(';
+    out = _wff_generator_write(generator, out, left, depth + 1);
+    *out++ = ' ';
+    out = stpcpy(out, op_string);
+    *out++ = ' ';
+    out = _wff_generator_write(generator, out, node_count - 1 - left, depth + 1);
+    *out++ = ')';
+    return out;
+}
@@ -0,0 +1,37 @@
+#ifndef GENERATE_H_
+#define GENERATE_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "logic.h"
+
+
+typedef struct WffGenerator WffGenerator;
+
+// Operators a generator picks from, weighted in the order ~, ^, v, =>, <=>.
+#define WFF_GENERATOR_OPERATOR_COUNT 5
+// Letters that can be variables: all but v, T and F, which are taken.
+#define WFF_GENERATOR_MAX_VARIABLES 49
+
+
+// Makes random wffs from a seed, the same ones for the same seed and settings
+// on any machine. The settings can be changed between wffs.
+struct WffGenerator {
+    uint64_t state;
+    // Variables drawn from, starting with p, q, r and s.
+    size_t var_count;
+    // Operators nested deeper than this are replaced with a variable.
+    size_t max_depth;
+    // Relative odds of each operator; all zero gives single variables.
+    unsigned weights[WFF_GENERATOR_OPERATOR_COUNT];
+};
+
+
+void wff_generator_init(WffGenerator* generator, uint64_t seed);
+// A random wff of 'node_count' variables and operators, or fewer if
+// max_depth cuts it short or there's no operator to fit the last few. The
+// caller frees it.
+char* wff_generator_string(WffGenerator* generator, size_t node_count);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef GENERATE_INTERNAL_H_
+#define GENERATE_INTERNAL_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "logic_internal.h"
+#include "generate.h"
+
+
+/* === WffGenerator === */
+uint64_t _wff_generator_next(WffGenerator* generator);
+size_t _wff_generator_below(WffGenerator* generator, size_t bound);
+int _wff_generator_operator(WffGenerator* generator, size_t node_count);
+char* _wff_generator_write(WffGenerator* generator, char* out, size_t node_count, size_t depth);
+
+#endif
@@ -2,9 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "logic.h"
 #include "logic_internal.h"
+#include "stats_internal.h"
 
 const char* const STR_NOT = "~";
 const char* const STR_AND = "^";
@@ -13,6 +15,66 @@ const char* const STR_COND = "=>";
 const char* const STR_BICOND = "<=>";
 const char* const STR_LPAREN = "(";
 const char* const STR_RPAREN = ")";
+const char* const STR_TRUE = "T";
+const char* const STR_FALSE = "F";
+
+// Every token a wff can contain. Lexing hands out pointers to these instead of
+// allocating tokens, so tokens are shared by every token list and parse tree
+// and never freed. This table is also the symbol table for variables: a
+// variable's ID is its index in it.
+WffTokenVariable WFF_VARIABLES[WFF_VARIABLE_COUNT] = {
+    {0, "a"}, {1, "b"}, {2, "c"}, {3, "d"}, {4, "e"}, {5, "f"}, {6, "g"}, {7, "h"},
+    {8, "i"}, {9, "j"}, {10, "k"}, {11, "l"}, {12, "m"}, {13, "n"}, {14, "o"}, {15, "p"},
+    {16, "q"}, {17, "r"}, {18, "s"}, {19, "t"}, {20, "u"}, {21, "v"}, {22, "w"}, {23, "x"},
+    {24, "y"}, {25, "z"}, {26, "A"}, {27, "B"}, {28, "C"}, {29, "D"}, {30, "E"}, {31, "F"},
+    {32, "G"}, {33, "H"}, {34, "I"}, {35, "J"}, {36, "K"}, {37, "L"}, {38, "M"}, {39, "N"},
+    {40, "O"}, {41, "P"}, {42, "Q"}, {43, "R"}, {44, "S"}, {45, "T"}, {46, "U"}, {47, "V"},
+    {48, "W"}, {49, "X"}, {50, "Y"}, {51, "Z"},
+};
+
+#define WFF_VARIABLE_TOKEN(i) {.type = WTT_PROPOSITION, .variable = &WFF_VARIABLES[i]}
+WffToken WFF_VARIABLE_TOKENS[WFF_VARIABLE_COUNT] = {
+    WFF_VARIABLE_TOKEN(0), WFF_VARIABLE_TOKEN(1), WFF_VARIABLE_TOKEN(2), WFF_VARIABLE_TOKEN(3),
+    WFF_VARIABLE_TOKEN(4), WFF_VARIABLE_TOKEN(5), WFF_VARIABLE_TOKEN(6), WFF_VARIABLE_TOKEN(7),
+    WFF_VARIABLE_TOKEN(8), WFF_VARIABLE_TOKEN(9), WFF_VARIABLE_TOKEN(10), WFF_VARIABLE_TOKEN(11),
+    WFF_VARIABLE_TOKEN(12), WFF_VARIABLE_TOKEN(13), WFF_VARIABLE_TOKEN(14), WFF_VARIABLE_TOKEN(15),
+    WFF_VARIABLE_TOKEN(16), WFF_VARIABLE_TOKEN(17), WFF_VARIABLE_TOKEN(18), WFF_VARIABLE_TOKEN(19),
+    WFF_VARIABLE_TOKEN(20), WFF_VARIABLE_TOKEN(21), WFF_VARIABLE_TOKEN(22), WFF_VARIABLE_TOKEN(23),
+    WFF_VARIABLE_TOKEN(24), WFF_VARIABLE_TOKEN(25), WFF_VARIABLE_TOKEN(26), WFF_VARIABLE_TOKEN(27),
+    WFF_VARIABLE_TOKEN(28), WFF_VARIABLE_TOKEN(29), WFF_VARIABLE_TOKEN(30), WFF_VARIABLE_TOKEN(31),
+    WFF_VARIABLE_TOKEN(32), WFF_VARIABLE_TOKEN(33), WFF_VARIABLE_TOKEN(34), WFF_VARIABLE_TOKEN(35),
+    WFF_VARIABLE_TOKEN(36), WFF_VARIABLE_TOKEN(37), WFF_VARIABLE_TOKEN(38), WFF_VARIABLE_TOKEN(39),
+    WFF_VARIABLE_TOKEN(40), WFF_VARIABLE_TOKEN(41), WFF_VARIABLE_TOKEN(42), WFF_VARIABLE_TOKEN(43),
+    WFF_VARIABLE_TOKEN(44), WFF_VARIABLE_TOKEN(45), WFF_VARIABLE_TOKEN(46), WFF_VARIABLE_TOKEN(47),
+    WFF_VARIABLE_TOKEN(48), WFF_VARIABLE_TOKEN(49), WFF_VARIABLE_TOKEN(50), WFF_VARIABLE_TOKEN(51),
+};
+#undef WFF_VARIABLE_TOKEN
+
+// Indexed by WffOperator.
+WffToken WFF_OPERATOR_TOKENS[] = {
+    {.type = WTT_OPERATOR, .operator = WO_NOT},
+    {.type = WTT_OPERATOR, .operator = WO_AND},
+    {.type = WTT_OPERATOR, .operator = WO_OR},
+    {.type = WTT_OPERATOR, .operator = WO_COND},
+    {.type = WTT_OPERATOR, .operator = WO_BICOND},
+};
+
+// Indexed by the constant's value.
+WffToken WFF_CONSTANT_TOKENS[] = {
+    {.type = WTT_CONSTANT, .value = false},
+    {.type = WTT_CONSTANT, .value = true},
+};
+
+WffToken WFF_LPAREN_TOKEN = {.type = WTT_LPAREN};
+WffToken WFF_RPAREN_TOKEN = {.type = WTT_RPAREN};
+WffToken WFF_NONE_TOKEN = {.type = WTT_NONE};
+
+// Size of the first block an arena allocates; later blocks double in size up
+// to WFF_ARENA_MAX_BLOCK_SIZE.
+#define WFF_ARENA_MIN_BLOCK_SIZE 2048
+#define WFF_ARENA_MAX_BLOCK_SIZE 65536
+// Initial slot count of a node table (must be a power of two).
+#define WFF_NODE_TABLE_MIN_CAPACITY 64
 
 
 void test() {
@@ -34,8 +96,14 @@ void test() {
     //printf("wff_compare: %d\n", wff_parse_tree_subtree_equals(wff->parse_tree->root, wff->parse_tree->root));
 
     
-    WffList* subwffs = wff_subwffs(wff);
-    wff_list_print_unique(subwffs);
+    WffParseTreeNodeList* subwffs = wff_unique_subwffs(wff);
+    char* subwff_buffer = malloc((wff->parse_tree->root->length + 1) * sizeof(char));
+    WffVectorIterator subwff_iterator = wff_parse_tree_node_list_iterate(subwffs);
+    for (WffParseTreeNode* subwff = wff_parse_tree_node_list_next(&subwff_iterator); subwff != NULL; subwff = wff_parse_tree_node_list_next(&subwff_iterator)) {
+        printf("%s\n", wff_parse_tree_render(subwff, subwff_buffer));
+    }
+    free(subwff_buffer);
+    wff_parse_tree_node_list_destroy(subwffs);
     
 
     printf("\n\nWFF TREE:\n");
@@ -45,12 +113,16 @@ void test() {
     printf("Searching in wff '%s' for pattern '%s': %ld\n", wff->string, search, wff_match_list_length(result));
 
     printf("\nFOUND:\n");
-    wff_match_list_reset_current(result);
-    WffMatch* match = wff_match_list_next(result);
+    WffVectorIterator match_iterator = wff_match_list_iterate(result);
+    WffMatch* match = wff_match_list_next(&match_iterator);
     int i = 0;
     while (match != NULL) {
-        printf("%s: %s\n", wff_parse_tree_get_subwff_string(match->pattern_var_node), wff_parse_tree_get_subwff_string(match->wff_node));
-        match = wff_match_list_next(result);
+        char* var_string = wff_parse_tree_get_subwff_string(match->pattern_var_node);
+        char* subwff_string = wff_parse_tree_get_subwff_string(match->wff_node);
+        printf("%s: %s\n", var_string, subwff_string);
+        free(var_string);
+        free(subwff_string);
+        match = wff_match_list_next(&match_iterator);
         i++;
         if (i == 1) {
             printf("\n");
@@ -58,127 +130,126 @@ void test() {
         }
     }
     
-    printf("BEFORE: %s\n", wff_parse_tree_get_subwff_string(wff->parse_tree->root));
+    char* before = wff_parse_tree_get_subwff_string(wff->parse_tree->root);
+    printf("BEFORE: %s\n", before);
+    free(before);
     wff_substitute(wff, search, replace, 0);
-    printf("AFTER: %s\n", wff_parse_tree_get_subwff_string(wff->parse_tree->root));
+    char* after = wff_parse_tree_get_subwff_string(wff->parse_tree->root);
+    printf("AFTER: %s\n", after);
+    free(after);
+
+    printf("\nNODES: %zu unique\n", wff->parse_tree->nodes->count);
+    printf("ARENA: %zu allocations in %zu blocks (%zu bytes)\n", wff->arena->allocation_count, wff->arena->block_count, wff->arena->bytes_allocated);
+
+    wff_destroy(wff);
 }
 
 
 /* === Wff === */
 
 Wff* wff_create(const char* wff_string) {
-    Wff* wff = malloc(sizeof(Wff));
-    wff->string = wff_string;
+    WffArena* arena = wff_arena_create();
+    Wff* wff = wff_arena_alloc(arena, sizeof(Wff));
+    wff->arena = arena;
+    wff->string = wff_arena_strdup(arena, wff_string);
 
-    WffTokenList* token_list = wff_tokenize(wff->string);
-    size_t var_count = 0;
-    wff_token_list_reset_current(token_list);
-    for (WffToken* token = wff_token_list_next(token_list); token != NULL; token = wff_token_list_next(token_list)) {
-        if (token->type == WTT_PROPOSITION) {
-            var_count++;
-        }
-    }
-    wff->var_count = var_count;
+    wff->var_count = 0;
     //wff->token_array = token_array;
     //wff->token_count = token_count;
 
-    wff->parse_tree = wff_parse_tree_create(token_list);
+    // Parsed straight from the string: no token list is built.
+    wff->parse_tree = _wff_parse_tree_create_from_string(wff->string, arena, wff_node_table_create(arena), &wff->var_count);
     if (wff->parse_tree == NULL) {
         printf("ERROR: Invalid wff '%s'\n", wff->string);
         exit(1);
     }
 
-    wff->wff_tree = wff_tree_create(wff->parse_tree);
+
+    wff->wff_tree = wff_tree_create(wff->parse_tree, arena);
 
     return wff;
 }
 
-// TODO
 void wff_destroy(Wff* wff) {
-    return;
+    wff_arena_release(wff->arena);
 }
 
-WffTokenList* wff_tokenize(const char* wff_string) {
-    WffTokenList* list = wff_token_list_create(); 
+// The string, which is made from the parse tree if it has changed since the
+// wff was created.
+const char* wff_get_string(Wff* wff) {
+    if (wff->string == NULL) {
+        char* string = wff_arena_alloc(wff->arena, (wff->parse_tree->root->length + 1) * sizeof(char));
+        wff->string = wff_parse_tree_render(wff->parse_tree->root, string);
+    }
+    return wff->string;
+}
 
-    for (const char* c = wff_string; *c != '\0'; c++) {
-        WffToken token = {.type = WTT_NONE};
-        switch (*c) {
-            case ' ': break;
-            case '~':
-                token.type = WTT_OPERATOR;
-                token.operator = WO_NOT;
-                break;
-            case 'v': 
-                token.type = WTT_OPERATOR;
-                token.operator = WO_OR;
-                break;
-            case '^':
-                token.type = WTT_OPERATOR;
-                token.operator = WO_AND;
-                break;
-            case '=':
-                token.type = WTT_OPERATOR;
-                token.operator = WO_COND;
-                c += 1;
-                break;
-            case '<':
-                token.type = WTT_OPERATOR;
-                token.operator = WO_BICOND;
-                c += 2;
-                break;
-            case '(':
-                token.type = WTT_LPAREN;
-                break;
-            case ')':
-                token.type = WTT_RPAREN;
-                break;
-            default: {
-                if (('a' <= *c && *c <= 'z') || ('A' <= *c && *c <= 'Z')) {
-                    token.type = WTT_PROPOSITION;
-                    char* variable_string = calloc(2, sizeof(char));
-                    variable_string[0] = *c;
-                    token.variable = wff_token_variable_create(variable_string);
-                } else {
-                    printf("ERROR: Unexpected token: %c\n", *c);
-                    exit(1);   
-                }
-            }
-        } // switch
-        
-        // If a token was created, append it to the list.
-        if (token.type != WTT_NONE) {
-            WffToken* new_token = malloc(sizeof(WffToken));
-            memcpy(new_token, &token, sizeof(WffToken));
-            wff_token_list_append(list, new_token);
-        }
+WffTree* wff_get_tree(Wff* wff) {
+    if (wff->wff_tree == NULL) {
+        wff->wff_tree = wff_tree_create(wff->parse_tree, wff->arena);
+    }
+    return wff->wff_tree;
+}
+
+WffTokenList* wff_tokenize(const char* wff_string, WffArena* arena) {
+    WFF_STATS_BEGIN(WSTP_TOKENIZE);
+    WffTokenList* list = wff_token_list_create(arena);
+
+    const char* c = wff_string;
+    for (WffToken* token = _wff_lex(&c); token != NULL; token = _wff_lex(&c)) {
+        wff_token_list_append(list, token);
     }
+    if (*c != '\0') {
+        printf("ERROR: Unexpected token: %c\n", *c);
+        exit(1);   
+    }
+    WFF_STATS_END(WSTP_TOKENIZE);
     return list;
 }
 
 WffList* wff_subwffs(Wff* wff) {
+    WFF_STATS_BEGIN(WSTP_SUBWFFS);
     WffList* wff_list = wff_list_create(); 
-    _wff_subwffs(wff_list, wff->parse_tree->root);
-    
+    // Every subwff is rendered into the same scratch buffer, which is big
+    // enough for the whole wff; wff_create keeps its own copy.
+    char* buffer = malloc((wff->parse_tree->root->length + 1) * sizeof(char));
+    _wff_subwffs(wff_list, wff->parse_tree->root, buffer);
+    free(buffer);
+    WFF_STATS_END(WSTP_SUBWFFS);
     return wff_list;
 }
 
-const char* _wff_subwffs(WffList* list, WffParseTreeNode* node) {
+void _wff_subwffs(WffList* list, WffParseTreeNode* node, char* buffer) {
     if (node->type == WPTNT_TERMINAL) {
-        return wff_token_get_string(node->token);
-    } else {
-        char* str = malloc(1);
-        *str = '\0';
-        size_t str_size = 1;
-        for (int i = 0; i < node->child_count; i++) {
-            const char* substr = _wff_subwffs(list, node->children[i]);
-            str_size += strlen(substr);
-            str = realloc(str, str_size);
-            strcat(str, substr);
-        }
-        wff_list_append(list, wff_create(str));
-        return str;
+        return;
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        _wff_subwffs(list, node->children[i], buffer);
+    }
+    wff_list_append(list, wff_create(wff_parse_tree_render(node, buffer)));
+}
+
+// Returns the root of each distinct subwff once, operands before the wffs
+// that contain them, without rendering or reparsing anything. Distinct
+// subwffs of a hash-consed tree are distinct nodes, so a set of the nodes
+// already seen is all it takes to skip repeats.
+WffParseTreeNodeList* wff_unique_subwffs(Wff* wff) {
+    WffParseTreeNodeList* list = wff_parse_tree_node_list_create();
+    WffNodeMap seen;
+    wff_node_map_init(&seen, 0, wff->parse_tree->nodes->count);
+    _wff_unique_subwffs(wff->parse_tree->root, &seen, list);
+    wff_node_map_finish(&seen);
+    return list;
+}
+
+void _wff_unique_subwffs(WffParseTreeNode* node, WffNodeMap* seen, WffParseTreeNodeList* list) {
+    if (node->type != WPTNT_NONTERMINAL || !wff_node_map_add(seen, node)) {
+        return;
     }
+    for (int j = 0; j < node->child_count; j++) {
+        _wff_unique_subwffs(node->children[j], seen, list);
+    }
+    wff_parse_tree_node_list_append(list, node);
 }
 
 WffParseTreeNodeList* wff_find_vars(Wff* wff) {
@@ -201,31 +272,46 @@ void _wff_find_vars(WffParseTreeNode* node, WffParseTreeNodeList* list) {
 }
 
 WffMatchList* wff_match(Wff* wff, const char* wff_pattern_string) {
-    Wff* pattern = wff_create(wff_pattern_string);
-    _wff_parse_tree_set_searchvars(pattern->parse_tree->root);
-
-    WffMatchList* token_matches = wff_match_list_create();
-    _wff_match_traversal(wff->parse_tree->root, pattern->parse_tree, token_matches);
+    WffPattern* pattern = wff_pattern_create(wff_pattern_string, NULL);
+    WffMatchList* token_matches = wff_pattern_match(wff, pattern);
+    token_matches->pattern = pattern;
     return token_matches;
 }
 
-void _wff_match_traversal(WffParseTreeNode* wff_parse_node_root, WffParseTree* pattern_tree, WffMatchList* list) {
+// 'bindings' is scratch space indexed by variable ID, all NULL on entry and
+// on return.
+void _wff_match_traversal(WffParseTreeNode* wff_parse_node_root, const WffParseTree* pattern_tree, WffMatchList* list, size_t* site, WffParseTreeNode** bindings) {
     if (wff_parse_node_root->type == WPTNT_NONTERMINAL) {
-        WffMatchList* temp_list = wff_match_list_create();
-        bool result = _wff_match(wff_parse_node_root, pattern_tree->root, temp_list);
-        if (result) {
-            wff_match_list_reset_current(temp_list);
-            wff_match_list_next(temp_list)->subwff_root = wff_parse_node_root;
-            wff_match_list_merge(list, temp_list);
+        // The matches of this site are appended straight to the list, and
+        // taken off again if the site doesn't match after all.
+        size_t first = wff_match_list_length(list);
+        WFF_STATS_ADD(match_attempts, 1);
+        bool result = _wff_match(wff_parse_node_root, pattern_tree->root, list, bindings);
+        // Every binding made has a match in the list, so clearing those is
+        // enough to reset the scratch space.
+        for (size_t i = first; i < wff_match_list_length(list); i++) {
+            bindings[wff_match_list_get(list, i)->pattern_var_node->token->variable->id] = NULL;
         }
+        // A pattern without variables (e.g. '~T') leaves nothing to record the
+        // site on, so such matches can't be reported in this format.
+        if (result && wff_match_list_length(list) > first) {
+            WffMatch* match = wff_match_list_get(list, first);
+            match->subwff_root = wff_parse_node_root;
+            match->site = *site;
+        } else {
+            wff_vector_truncate(&list->matches, first);
+        }
+        (*site)++;
         //wff_match_list_append(list, wff_parse_node_root);
         for (int i = 0; i < wff_parse_node_root->child_count; i++) {
-            _wff_match_traversal(wff_parse_node_root->children[i], pattern_tree, list);
+            _wff_match_traversal(wff_parse_node_root->children[i], pattern_tree, list, site, bindings);
         }
     }
 }
 
-bool _wff_match(WffParseTreeNode* wff_parse_node, WffParseTreeNode* pattern_parse_node, WffMatchList* list) {
+// Binds each search var to the subwff it matches in 'bindings', indexed by
+// variable ID, and appends a match for it to 'list' unless that is NULL.
+bool _wff_match(WffParseTreeNode* wff_parse_node, WffParseTreeNode* pattern_parse_node, WffMatchList* list, WffParseTreeNode** bindings) {
     if (wff_parse_node->type == WPTNT_TERMINAL && pattern_parse_node->type == WPTNT_TERMINAL ) {
         // Modified token equality check: whenever we see a proposition in the
         // pattern, we'll match it against any valid wff or subwff (including
@@ -243,6 +329,9 @@ bool _wff_match(WffParseTreeNode* wff_parse_node, WffParseTreeNode* pattern_pars
             case WTT_OPERATOR:
                 return wff_token->operator == pattern_token->operator;
                 break;
+            case WTT_CONSTANT:
+                return wff_token->value == pattern_token->value;
+                break;
             default:
                 printf("ERROR: Unhandled token type\n");
                 exit(1);
@@ -259,7 +348,7 @@ bool _wff_match(WffParseTreeNode* wff_parse_node, WffParseTreeNode* pattern_pars
             if (wff_parse_node->child_count == pattern_parse_node->child_count) {
                 bool isEqual = true;
                 for (int i = 0; i < wff_parse_node->child_count; i++) {
-                    isEqual = isEqual && _wff_match(wff_parse_node->children[i], pattern_parse_node->children[i], list);
+                    isEqual = isEqual && _wff_match(wff_parse_node->children[i], pattern_parse_node->children[i], list, bindings);
                 }
                 return isEqual;
             } else {
@@ -267,18 +356,16 @@ bool _wff_match(WffParseTreeNode* wff_parse_node, WffParseTreeNode* pattern_pars
             }
         } else if (pattern_parse_node->type == WPTNT_SEARCHVAR) {
             // Implement behaviour for same variable appearing in search string 
-            // more than once.
-            wff_match_list_reset_current(list);
-            WffMatch* previous_match = wff_match_list_next(list);
-            while (previous_match != NULL) {
-                if (wff_token_variable_equals(previous_match->pattern_var_node->token->variable, pattern_parse_node->token->variable)) {
-                    if (!wff_parse_tree_subtree_equals(previous_match->wff_node, wff_parse_node)) {
-                        return false;
-                    }
-                }
-                previous_match = wff_match_list_next(list);
+            // more than once. Both subwffs come from the same hash-consed tree,
+            // so they are structurally equal iff they are the same node.
+            size_t id = pattern_parse_node->token->variable->id;
+            if (bindings[id] != NULL && bindings[id] != wff_parse_node) {
+                return false;
+            }
+            bindings[id] = wff_parse_node;
+            if (list != NULL) {
+                wff_match_list_append(list, &(WffMatch) {.wff_node = wff_parse_node, .pattern_var_node = pattern_parse_node});
             }
-            wff_match_list_append(list, wff_match_create(wff_parse_node, pattern_parse_node));
             return true;
 
             /*bool isEqual = true;
@@ -293,71 +380,498 @@ bool _wff_match(WffParseTreeNode* wff_parse_node, WffParseTreeNode* pattern_pars
 }
 
 bool wff_substitute(Wff* wff, const char* search, const char* replace, size_t index) {
-    WffMatchList* candidates = wff_match(wff, search);
-    if (wff_match_list_length(candidates) == 0) {
-        return false;
+    WffPattern* pattern = wff_pattern_create(search, replace);
+    bool result = wff_pattern_substitute(wff, pattern, index);
+    wff_pattern_destroy(pattern);
+    return result;
+}
+
+Wff* wff_rewrite(Wff* wff, const char* search, const char* replace, size_t index) {
+    WffPattern* pattern = wff_pattern_create(search, replace);
+    Wff* result = wff_pattern_rewrite(wff, pattern, index);
+    wff_pattern_destroy(pattern);
+    return result;
+}
+
+// Builds the template in 'table', replacing each variable with the subwff
+// bound to its ID in 'bindings'. The template may come from any tree; the
+// result only uses nodes from 'table'.
+WffParseTreeNode* _wff_instantiate(WffNodeTable* table, WffParseTreeNode* template_node, WffParseTreeNode** bindings) {
+    if (template_node->type == WPTNT_TERMINAL) {
+        return _wff_parse_tree_node_create(table, template_node);
     }
-    Wff* search_wff = wff_create(search);
-    WffMatch* chosen_matches[search_wff->var_count];
-    WffMatch* match = wff_match_list_get(candidates, search_wff->var_count * index, true);
-    for (size_t i = 0; i < search_wff->var_count; i++) {
-        chosen_matches[i] = match;
-        match = wff_match_list_next(candidates);
+    if (template_node->child_count == 1 && template_node->children[0]->token->type == WTT_PROPOSITION) {
+        WffParseTreeNode* value = bindings[template_node->children[0]->token->variable->id];
+        if (value != NULL) {
+            return value;
+        }
+        // Variables that don't appear in the search expression are kept as is.
     }
 
-    Wff* replace_wff = wff_create(replace);
+    WffParseTreeNode node = {.type = WPTNT_NONTERMINAL, .child_count = template_node->child_count};
+    for (int i = 0; i < template_node->child_count; i++) {
+        node.children[i] = _wff_instantiate(table, template_node->children[i], bindings);
+    }
+    return _wff_parse_tree_node_create(table, &node);
+}
 
-    //printf("Mid: %s\n", wff_parse_tree_node_print(wff->parse_tree->root));
-    
-    // Replace the terminals in the replace expression with the subwffs found in
-    // the original expression.
-    WffParseTreeNodeList* variable_nodes = wff_find_vars(replace_wff);
-    wff_parse_tree_node_list_reset_current(variable_nodes);
-    WffParseTreeNode* var_node = wff_parse_tree_node_list_next(variable_nodes);
-    while (var_node != NULL) {
-        for (size_t i = 0; i < search_wff->var_count; i++) {
-            if (wff_token_variable_equals(var_node->token->variable, chosen_matches[i]->pattern_var_node->token->variable)) {
-                var_node->child_count = chosen_matches[i]->wff_node->child_count;
-                for (int j = 0; j < chosen_matches[i]->wff_node->child_count; j++) {
-                    var_node->children[j] = chosen_matches[i]->wff_node->children[j];
-                }
-                var_node->type = WPTNT_NONTERMINAL;
-                break;
-            }
+WffParseTreeNode* _wff_replace_site(WffNodeTable* table, WffParseTreeNode* node, size_t* ordinal, size_t site, WffParseTreeNode* replacement) {
+    // Count nonterminals in the same preorder as _wff_match_traversal.
+    if (node->type != WPTNT_NONTERMINAL) {
+        return node;
+    }
+    if (*ordinal == site) {
+        (*ordinal)++;
+        return replacement;
+    }
+    (*ordinal)++;
+
+    WffParseTreeNode copy = {.type = WPTNT_NONTERMINAL, .child_count = node->child_count};
+    bool changed = false;
+    for (int i = 0; i < node->child_count; i++) {
+        if (*ordinal > site || *ordinal + node->children[i]->site_count <= site) {
+            // The site isn't in this child, so it is kept and skipped whole.
+            copy.children[i] = node->children[i];
+            *ordinal += node->children[i]->site_count;
+        } else {
+            copy.children[i] = _wff_replace_site(table, node->children[i], ordinal, site, replacement);
+            changed = changed || copy.children[i] != node->children[i];
+        }
+    }
+    return changed ? _wff_parse_tree_node_create(table, &copy) : node;
+}
+
+// Makes 'root' the tree of 'wff', whose string and wff tree are made again
+// when next asked for.
+void _wff_set_root(Wff* wff, WffParseTreeNode* root, size_t var_count) {
+    wff->parse_tree->root = root;
+    wff->var_count = var_count;
+    wff->string = NULL;
+    wff->wff_tree = NULL;
+}
+
+// Returns a new wff with the tree rooted at 'root', which must have been built
+// in the node table of 'wff'. The two share that table and arena, so the new
+// wff only costs what was built for it: the path from the root down to the
+// rewritten site and whatever the rewrite instantiated.
+Wff* _wff_create_version(Wff* wff, WffParseTreeNode* root, size_t var_count) {
+    wff_arena_retain(wff->arena);
+    Wff* version = wff_arena_alloc(wff->arena, sizeof(Wff));
+    version->arena = wff->arena;
+    version->parse_tree = wff_arena_alloc(wff->arena, sizeof(WffParseTree));
+    *version->parse_tree = *wff->parse_tree;
+    _wff_set_root(version, root, var_count);
+    return version;
+}
+
+size_t _wff_count_propositions(WffParseTreeNode* node) {
+    if (node->type != WPTNT_NONTERMINAL) {
+        return node->token->type == WTT_PROPOSITION;
+    }
+    size_t count = 0;
+    for (int i = 0; i < node->child_count; i++) {
+        count += _wff_count_propositions(node->children[i]);
+    }
+    return count;
+}
+
+
+/* === WffPattern === */
+
+WffPattern* wff_pattern_create(const char* search, const char* replace) {
+    WffArena* arena = wff_arena_create();
+    WffPattern* pattern = wff_arena_alloc(arena, sizeof(WffPattern));
+    pattern->arena = arena;
+
+    // Search vars are made by rewriting nodes in place, so the replace
+    // expression gets a node table of its own.
+    pattern->var_count = 0;
+    pattern->search = _wff_parse_tree_create_from_string(search, arena, wff_node_table_create(arena), &pattern->var_count);
+    if (pattern->search == NULL) {
+        printf("ERROR: Invalid wff '%s'\n", search);
+        exit(1);
+    }
+    pattern->replace = NULL;
+    if (replace != NULL) {
+        WffParseTree* replace_tree = _wff_parse_tree_create_from_string(replace, arena, wff_node_table_create(arena), NULL);
+        if (replace_tree == NULL) {
+            printf("ERROR: Invalid wff '%s'\n", replace);
+            exit(1);
         }
-        var_node = wff_parse_tree_node_list_next(variable_nodes);
+        pattern->replace = replace_tree->root;
+    }
+
+    _wff_parse_tree_set_searchvars(pattern->search->root);
+    return pattern;
+}
+
+void wff_pattern_destroy(WffPattern* pattern) {
+    wff_arena_destroy(pattern->arena);
+}
+
+WffMatchList* wff_pattern_match(Wff* wff, const WffPattern* pattern) {
+    WFF_STATS_BEGIN(WSTP_MATCH);
+    WffMatchList* token_matches = wff_match_list_create();
+    size_t site = 0;
+    WffParseTreeNode* bindings[WFF_VARIABLE_COUNT] = {NULL};
+    _wff_match_traversal(wff->parse_tree->root, pattern->search, token_matches, &site, bindings);
+    WFF_STATS_END(WSTP_MATCH);
+    return token_matches;
+}
+
+bool wff_pattern_substitute(Wff* wff, const WffPattern* pattern, size_t index) {
+    WFF_STATS_BEGIN(WSTP_SUBSTITUTE);
+    size_t var_count;
+    WffParseTreeNode* root = _wff_pattern_rewrite_root(wff, pattern, index, &var_count);
+    if (root != NULL) {
+        _wff_set_root(wff, root, var_count);
+    }
+    WFF_STATS_END(WSTP_SUBSTITUTE);
+    return root != NULL;
+}
+
+// Like wff_pattern_substitute, but leaves 'wff' as it is and returns the
+// result as a new wff that shares every subwff off the rewritten path with
+// it, or NULL if there is no such match. Either can be destroyed first.
+Wff* wff_pattern_rewrite(Wff* wff, const WffPattern* pattern, size_t index) {
+    WFF_STATS_BEGIN(WSTP_SUBSTITUTE);
+    size_t var_count;
+    WffParseTreeNode* root = _wff_pattern_rewrite_root(wff, pattern, index, &var_count);
+    Wff* result = root == NULL ? NULL : _wff_create_version(wff, root, var_count);
+    WFF_STATS_END(WSTP_SUBSTITUTE);
+    return result;
+}
+
+// Returns the root of 'wff' after substituting its index'th match, leaving
+// the wff itself alone, or NULL if there is no such match. The new
+// proposition count goes in *var_count.
+WffParseTreeNode* _wff_pattern_rewrite_root(Wff* wff, const WffPattern* pattern, size_t index, size_t* var_count) {
+    if (pattern->replace == NULL) {
+        return NULL;
+    }
+    // Only the sites up to the index'th match are tried.
+    WffOutcomeCursor* cursor = wff_outcome_cursor_create(wff, pattern);
+    WffParseTreeNode* root = NULL;
+    if (wff_outcome_cursor_seek(cursor, index)) {
+        WffOutcome* outcome = _wff_outcome_cursor_build(cursor);
+        root = outcome->root;
+        *var_count = outcome->var_count;
+    }
+    wff_outcome_cursor_destroy(cursor);
+    return root;
+}
+
+
+/* === WffOutcomeCursor === */
+
+// The wff must not change while the cursor is in use.
+WffOutcomeCursor* wff_outcome_cursor_create(Wff* wff, const WffPattern* pattern) {
+    WffOutcomeCursor* cursor = malloc(sizeof(WffOutcomeCursor));
+    cursor->wff = wff;
+    cursor->pattern = pattern;
+    cursor->var_count = 0;
+    bool seen[WFF_VARIABLE_COUNT] = {false};
+    _wff_outcome_cursor_find_vars(cursor, pattern->search->root, seen);
+
+    cursor->stack_capacity = 16;
+    cursor->stack = malloc(cursor->stack_capacity * sizeof(WffParseTreeNode*));
+    cursor->stack_length = 0;
+    if (wff->parse_tree->root->type == WPTNT_NONTERMINAL) {
+        cursor->stack[cursor->stack_length++] = wff->parse_tree->root;
     }
+    cursor->next_site = 0;
+    memset(cursor->bindings, 0, sizeof(cursor->bindings));
+
+    cursor->arena = wff_arena_create();
+    cursor->outcome_capacity = 16;
+    cursor->outcomes = malloc(cursor->outcome_capacity * sizeof(WffOutcome));
+    cursor->outcome_count = 0;
+    cursor->current = WFF_OUTCOME_NONE;
+    return cursor;
+}
+
+void wff_outcome_cursor_destroy(WffOutcomeCursor* cursor) {
+    wff_arena_destroy(cursor->arena);
+    free(cursor->outcomes);
+    free(cursor->stack);
+    free(cursor);
+}
 
-    // Replace the desired section in the wff with the replace expression nodes.
-    WffParseTreeNode* parent = chosen_matches[0]->subwff_root; 
-    parent->child_count = replace_wff->parse_tree->root->child_count;
-    for (int i = 0; i < replace_wff->parse_tree->root->child_count; i++) {
-        parent->children[i] = replace_wff->parse_tree->root->children[i];
+// Moves to the next outcome, or back to the first after the last one.
+// Returns false if there are no outcomes at all.
+bool wff_outcome_cursor_next(WffOutcomeCursor* cursor) {
+    size_t next = cursor->current == WFF_OUTCOME_NONE ? 0 : cursor->current + 1;
+    if (!wff_outcome_cursor_seek(cursor, next) && !wff_outcome_cursor_seek(cursor, 0)) {
+        return false;
     }
-    //make_nonterminal(replace_wff->parse_tree->root);
+    return true;
+}
 
+// Moves to the previous outcome, or around to the last one from the first,
+// which the first time means finding all the rest.
+bool wff_outcome_cursor_prev(WffOutcomeCursor* cursor) {
+    if (cursor->current != WFF_OUTCOME_NONE && cursor->current > 0) {
+        cursor->current--;
+        return true;
+    }
+    while (_wff_outcome_cursor_advance(cursor)) {
+    }
+    if (cursor->outcome_count == 0) {
+        return false;
+    }
+    cursor->current = cursor->outcome_count - 1;
     return true;
 }
 
+// Moves to the outcome at 'index', counting in order of site. Returns false,
+// and stays put, if there are not that many.
+bool wff_outcome_cursor_seek(WffOutcomeCursor* cursor, size_t index) {
+    while (cursor->outcome_count <= index) {
+        if (!_wff_outcome_cursor_advance(cursor)) {
+            return false;
+        }
+    }
+    cursor->current = index;
+    return true;
+}
+
+// Number of outcomes found so far, which is all of them once the cursor has
+// wrapped around.
+size_t wff_outcome_cursor_count(WffOutcomeCursor* cursor) {
+    return cursor->outcome_count;
+}
+
+size_t wff_outcome_cursor_index(WffOutcomeCursor* cursor) {
+    return cursor->current;
+}
+
+size_t wff_outcome_cursor_site(WffOutcomeCursor* cursor) {
+    if (cursor->current == WFF_OUTCOME_NONE) {
+        return WFF_OUTCOME_NONE;
+    }
+    return cursor->outcomes[cursor->current].site;
+}
+
+// Returns what the current outcome binds 'variable' of the search expression
+// to, which the caller frees, or NULL if the search expression doesn't have
+// that variable or there is no current outcome.
+char* wff_outcome_cursor_binding(WffOutcomeCursor* cursor, const char* variable) {
+    if (cursor->current == WFF_OUTCOME_NONE) {
+        return NULL;
+    }
+    WffOutcome* outcome = &cursor->outcomes[cursor->current];
+    int id = _wff_variable_index(variable[0]);
+    for (size_t k = 0; k < cursor->var_count; k++) {
+        if ((int) cursor->var_ids[k] == id) {
+            return wff_parse_tree_get_subwff_string(outcome->bindings[k]);
+        }
+    }
+    return NULL;
+}
+
+// Returns the whole wff as the current outcome would leave it, which the
+// caller frees, or NULL if the pattern has no replace expression or there is
+// no current outcome.
+char* wff_outcome_cursor_string(WffOutcomeCursor* cursor) {
+    WffOutcome* outcome = _wff_outcome_cursor_build(cursor);
+    return outcome == NULL ? NULL : wff_parse_tree_get_subwff_string(outcome->root);
+}
+
+// Returns the current outcome as a new version of the wff (see
+// wff_pattern_rewrite), or NULL if the pattern has no replace expression or
+// there is no current outcome.
+Wff* wff_outcome_cursor_rewrite(WffOutcomeCursor* cursor) {
+    WffOutcome* outcome = _wff_outcome_cursor_build(cursor);
+    return outcome == NULL ? NULL : _wff_create_version(cursor->wff, outcome->root, outcome->var_count);
+}
+
+void _wff_outcome_cursor_find_vars(WffOutcomeCursor* cursor, WffParseTreeNode* node, bool* seen) {
+    if (node->type == WPTNT_SEARCHVAR) {
+        size_t id = node->token->variable->id;
+        if (!seen[id]) {
+            seen[id] = true;
+            cursor->var_ids[cursor->var_count++] = id;
+        }
+    } else if (node->type == WPTNT_NONTERMINAL) {
+        for (int i = 0; i < node->child_count; i++) {
+            _wff_outcome_cursor_find_vars(cursor, node->children[i], seen);
+        }
+    }
+}
+
+// Walks on to the next site where the search expression matches and records
+// the outcome there. Returns false once every site has been tried.
+bool _wff_outcome_cursor_advance(WffOutcomeCursor* cursor) {
+    while (cursor->stack_length > 0) {
+        // Sites are numbered in the same preorder as _wff_match_traversal.
+        WffParseTreeNode* node = cursor->stack[--cursor->stack_length];
+        size_t site = cursor->next_site++;
+        for (int i = node->child_count - 1; i >= 0; i--) {
+            if (node->children[i]->type != WPTNT_NONTERMINAL) {
+                continue;
+            }
+            if (cursor->stack_length == cursor->stack_capacity) {
+                cursor->stack_capacity *= 2;
+                cursor->stack = realloc(cursor->stack, cursor->stack_capacity * sizeof(WffParseTreeNode*));
+            }
+            cursor->stack[cursor->stack_length++] = node->children[i];
+        }
+
+        WFF_STATS_ADD(match_attempts, 1);
+        bool matched = _wff_match(node, cursor->pattern->search->root, NULL, cursor->bindings);
+        if (matched) {
+            if (cursor->outcome_count == cursor->outcome_capacity) {
+                cursor->outcome_capacity *= 2;
+                cursor->outcomes = realloc(cursor->outcomes, cursor->outcome_capacity * sizeof(WffOutcome));
+            }
+            WffOutcome* outcome = &cursor->outcomes[cursor->outcome_count++];
+            outcome->site = site;
+            outcome->subwff_root = node;
+            outcome->bindings = wff_arena_alloc(cursor->arena, cursor->var_count * sizeof(WffParseTreeNode*));
+            outcome->root = NULL;
+            outcome->var_count = 0;
+            for (size_t k = 0; k < cursor->var_count; k++) {
+                outcome->bindings[k] = cursor->bindings[cursor->var_ids[k]];
+            }
+        }
+        // A failed match may have bound some variables before it failed.
+        for (size_t k = 0; k < cursor->var_count; k++) {
+            cursor->bindings[cursor->var_ids[k]] = NULL;
+        }
+        if (matched) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Builds the tree of the current outcome the first time it is needed, in the
+// wff's node table. Returns NULL if the pattern has no replace expression or
+// there is no current outcome.
+WffOutcome* _wff_outcome_cursor_build(WffOutcomeCursor* cursor) {
+    if (cursor->pattern->replace == NULL || cursor->current == WFF_OUTCOME_NONE) {
+        return NULL;
+    }
+    WffOutcome* outcome = &cursor->outcomes[cursor->current];
+    if (outcome->root == NULL) {
+        WFF_STATS_ADD(substitutions, 1);
+        Wff* wff = cursor->wff;
+        for (size_t k = 0; k < cursor->var_count; k++) {
+            cursor->bindings[cursor->var_ids[k]] = outcome->bindings[k];
+        }
+        WffParseTreeNode* replacement = _wff_instantiate(wff->parse_tree->nodes, cursor->pattern->replace, cursor->bindings);
+        for (size_t k = 0; k < cursor->var_count; k++) {
+            cursor->bindings[cursor->var_ids[k]] = NULL;
+        }
+        size_t ordinal = 0;
+        outcome->root = _wff_replace_site(wff->parse_tree->nodes, wff->parse_tree->root, &ordinal, outcome->site, replacement);
+        outcome->var_count = wff->var_count - _wff_count_propositions(outcome->subwff_root) + _wff_count_propositions(replacement);
+    }
+    return outcome;
+}
+
 
 /* === WffToken === */
 
-void wff_token_destroy(WffToken* token) {
-    if (token->type == WTT_PROPOSITION) {
-        wff_token_variable_destroy(token->variable);
+// Returns the shared token equal to 'token'.
+WffToken* wff_token_canonical(const WffToken* token) {
+    switch (token->type) {
+        case WTT_OPERATOR:
+            return &WFF_OPERATOR_TOKENS[token->operator];
+        case WTT_PROPOSITION:
+            return &WFF_VARIABLE_TOKENS[token->variable->id];
+        case WTT_CONSTANT:
+            return &WFF_CONSTANT_TOKENS[token->value];
+        case WTT_LPAREN:
+            return &WFF_LPAREN_TOKEN;
+        case WTT_RPAREN:
+            return &WFF_RPAREN_TOKEN;
+        case WTT_NONE:
+            return &WFF_NONE_TOKEN;
     }
-    free(token);
+    printf("ERROR: Case not handled\n");
+    abort();
 }
 
-WffToken* wff_token_copy(WffToken* token) {
-    WffToken* copy = malloc(sizeof(WffToken*));
+// Reads the token at *cursor, skipping any spaces before it, and moves the
+// cursor past it. Returns NULL at the end of the string or at a character that
+// doesn't start a token, with the cursor left on that character.
+WffToken* _wff_lex(const char** cursor) {
+    const char* c = *cursor;
+    while (*c == ' ') {
+        c++;
+    }
+    *cursor = c;
+
+    WffToken* token;
+    switch (*c) {
+        case '~':
+            token = &WFF_OPERATOR_TOKENS[WO_NOT];
+            break;
+        case 'v':
+            token = &WFF_OPERATOR_TOKENS[WO_OR];
+            break;
+        case '^':
+            token = &WFF_OPERATOR_TOKENS[WO_AND];
+            break;
+        case '=':
+            if (c[1] != '>') {
+                return NULL;
+            }
+            token = &WFF_OPERATOR_TOKENS[WO_COND];
+            c += 1;
+            break;
+        case '<':
+            if (c[1] != '=' || c[2] != '>') {
+                return NULL;
+            }
+            token = &WFF_OPERATOR_TOKENS[WO_BICOND];
+            c += 2;
+            break;
+        case '(':
+            token = &WFF_LPAREN_TOKEN;
+            break;
+        case ')':
+            token = &WFF_RPAREN_TOKEN;
+            break;
+        case 'T':
+        case 'F':
+            token = &WFF_CONSTANT_TOKENS[*c == 'T'];
+            break;
+        default: {
+            int index = _wff_variable_index(*c);
+            if (index < 0) {
+                return NULL;
+            }
+            token = &WFF_VARIABLE_TOKENS[index];
+        }
+    } // switch
+    WFF_STATS_ADD(tokens_lexed, 1);
+    *cursor = c + 1;
+    return token;
+}
+
+int _wff_variable_index(char c) {
+    if ('a' <= c && c <= 'z') {
+        return c - 'a';
+    } else if ('A' <= c && c <= 'Z') {
+        return 26 + (c - 'A');
+    }
+    return -1;
+}
+
+WffToken* wff_token_copy(WffToken* token, WffArena* arena) {
+    WffToken* copy = wff_arena_alloc(arena, sizeof(WffToken));
     copy->type = token->type;
     switch (token->type) {
         case WTT_OPERATOR:
             copy->operator = token->operator;
             break;
         case WTT_PROPOSITION:
-            copy->variable = wff_token_variable_copy(token->variable);
+            copy->variable = wff_token_variable_copy(token->variable, arena);
+            break;
+        case WTT_CONSTANT:
+            copy->value = token->value;
             break;
         case WTT_LPAREN:
         case WTT_RPAREN:
@@ -380,6 +894,9 @@ bool wff_token_equal(WffToken* token1, WffToken* token2) {
         case WTT_OPERATOR:
             return token1->operator == token2->operator;
             break;
+        case WTT_CONSTANT:
+            return token1->value == token2->value;
+            break;
         case WTT_PROPOSITION:
             return wff_token_variable_equals(token1->variable, token2->variable);
             break;
@@ -405,6 +922,8 @@ const char* wff_token_get_string(WffToken* token) {
             }
         case WTT_PROPOSITION:
             return wff_token_variable_get_string(token->variable);
+        case WTT_CONSTANT:
+            return token->value ? STR_TRUE : STR_FALSE;
         case WTT_LPAREN:
             return STR_LPAREN;
         case WTT_RPAREN:
@@ -418,27 +937,29 @@ const char* wff_token_get_string(WffToken* token) {
 
 /* === WffTokenVariable === */
 
-WffTokenVariable* wff_token_variable_create(const char* variable_string) {
-    WffTokenVariable* variable = malloc(sizeof(WffTokenVariable));
+WffTokenVariable* wff_token_variable_create(const char* variable_string, WffArena* arena) {
+    int index = _wff_variable_index(variable_string[0]);
+    if (index < 0 || variable_string[1] != '\0') {
+        printf("ERROR: Invalid variable '%s'\n", variable_string);
+        exit(1);
+    }
+    WffTokenVariable* variable = wff_arena_alloc(arena, sizeof(WffTokenVariable));
+    variable->id = index;
     variable->string = variable_string;
     return variable;
 }
 
-void wff_token_variable_destroy(WffTokenVariable* variable) {
-    free((char*) variable->string);
-    free(variable);
-}
-
-WffTokenVariable* wff_token_variable_copy(WffTokenVariable* variable) {
-    WffTokenVariable* copy = malloc(sizeof(WffTokenVariable));
-    char* string = malloc((strlen(variable->string) + 1) * sizeof(char));
+WffTokenVariable* wff_token_variable_copy(WffTokenVariable* variable, WffArena* arena) {
+    WffTokenVariable* copy = wff_arena_alloc(arena, sizeof(WffTokenVariable));
+    copy->id = variable->id;
+    char* string = wff_arena_alloc(arena, (strlen(variable->string) + 1) * sizeof(char));
     strcpy(string, variable->string);
     copy->string = string;
     return copy;
 }
 
 bool wff_token_variable_equals(WffTokenVariable* variable1, WffTokenVariable* variable2) {
-    return strcmp(variable1->string, variable2->string) == 0;
+    return variable1->id == variable2->id;
 }
 
 const char* wff_token_variable_get_string(WffTokenVariable* variable) {
@@ -446,25 +967,72 @@ const char* wff_token_variable_get_string(WffTokenVariable* variable) {
 }
 
 
+/* === WffTokenReader === */
+
+WffToken* _wff_token_reader_next(WffTokenReader* reader) {
+    WffToken* token;
+    if (reader->list != NULL) {
+        token = wff_token_list_next(&reader->tokens);
+    } else if (reader->next != NULL) {
+        token = reader->next(reader->source);
+    } else {
+        token = _wff_lex(&reader->cursor);
+    }
+    if (token != NULL && token->type == WTT_PROPOSITION) {
+        reader->var_count++;
+    }
+    return token;
+}
+
+// Whether every token has been read. A string is only done if lexing stopped
+// at its end rather than at an unexpected character.
+bool _wff_token_reader_done(WffTokenReader* reader) {
+    return _wff_token_reader_next(reader) == NULL && (reader->list != NULL || reader->next != NULL || *reader->cursor == '\0');
+}
+
+
 /* === WffParseTree === */
 
-WffParseTree* wff_parse_tree_create(WffTokenList* token_list) {
-    WffParseTreeNode* root = malloc(sizeof(WffParseTreeNode));
-    wff_token_list_reset_current(token_list);
+WffParseTree* wff_parse_tree_create(WffTokenList* token_list, WffArena* arena) {
+    WffNodeTable* nodes = arena == NULL ? NULL : wff_node_table_create(arena);
+    WffTokenReader reader = {.list = token_list, .tokens = wff_token_list_iterate(token_list)};
+    return _wff_parse_tree_create(&reader, arena, nodes);
+}
 
-    bool valid = _wff_parse(token_list, root);
+// Parses 'string' in a single pass and adds the number of propositions in it
+// to *var_count, if given.
+WffParseTree* _wff_parse_tree_create_from_string(const char* string, WffArena* arena, WffNodeTable* nodes, size_t* var_count) {
+    WffTokenReader reader = {.cursor = string};
+    WffParseTree* tree = _wff_parse_tree_create(&reader, arena, nodes);
+    if (var_count != NULL) {
+        *var_count += reader.var_count;
+    }
+    return tree;
+}
+
+WffParseTree* _wff_parse_tree_create(WffTokenReader* reader, WffArena* arena, WffNodeTable* nodes) {
+    WFF_STATS_BEGIN(WSTP_PARSE);
+    WffParseTreeNode* root = _wff_parse(reader, nodes);
     // Ensure that the tokens parsed were valid and ALL tokens were parsed.
-    if (valid && wff_token_list_next(token_list) == NULL) {
-        WffParseTree* tree = malloc(sizeof(WffParseTree));
+    // Partially built nodes are reclaimed when the arena is destroyed.
+    WffParseTree* tree = NULL;
+    if (root != NULL && _wff_token_reader_done(reader)) {
+        tree = wff_arena_alloc(arena, sizeof(WffParseTree));
+        tree->arena = arena;
+        tree->nodes = nodes;
         tree->root = root;
-        return tree;
-    } else {
-        // FREE NODES
-        return NULL;
     }
+    WFF_STATS_END(WSTP_PARSE);
+    return tree;
 }
 
+// Tokens are canonical and not owned by the tree. Only trees built without an
+// arena need (or can) be destroyed this way.
 void wff_parse_tree_destroy(WffParseTree* tree) {
+    if (tree->arena != NULL) {
+        // Owned by the arena.
+        return;
+    }
     _wff_parse_tree_destroy(tree->root);
     free(tree);
 }
@@ -478,7 +1046,6 @@ void _wff_parse_tree_destroy(WffParseTreeNode* node) {
         // Allow fallthrough
         case WPTNT_SEARCHVAR:
         case WPTNT_TERMINAL:
-            wff_token_destroy(node->token);
             free(node);
             break;
         default:
@@ -487,67 +1054,83 @@ void _wff_parse_tree_destroy(WffParseTreeNode* node) {
     }
 }
 
-bool _wff_parse(WffTokenList* token_list, WffParseTreeNode* node) {
+WffParseTreeNode* _wff_parse(WffTokenReader* reader, WffNodeTable* nodes) {
     //int savedIndex = *index; 
-    WffToken* next = wff_token_copy(wff_token_list_next(token_list));
-    if (next->type == WTT_PROPOSITION) {
-        node->type = WPTNT_NONTERMINAL;
-        node->child_count = 1;
-        WffParseTreeNode* newNode = malloc(sizeof(WffParseTreeNode));
-        newNode->type = WPTNT_TERMINAL;
-        newNode->token = next;
-        node->children[0] = newNode;
-        return true;
+    WffParseTreeNode node = {.type = WPTNT_NONTERMINAL};
+    WffToken* next = _wff_token_reader_next(reader);
+    if (next == NULL) {
+        return NULL;
+    } else if (next->type == WTT_PROPOSITION || next->type == WTT_CONSTANT) {
+        node.child_count = 1;
+        node.children[0] = _wff_parse_tree_node_create(nodes, &(WffParseTreeNode) {.type = WPTNT_TERMINAL, .token = next});
     } else if (next->type == WTT_OPERATOR && next->operator == WO_NOT) {
-        node->type = WPTNT_NONTERMINAL;
-        node->child_count = 2;
+        node.child_count = 2;
         // First child
-        WffParseTreeNode* newNode = malloc(sizeof(WffParseTreeNode));
-        newNode->type = WPTNT_TERMINAL;
-        newNode->token = next;
-        node->children[0] = newNode;
+        node.children[0] = _wff_parse_tree_node_create(nodes, &(WffParseTreeNode) {.type = WPTNT_TERMINAL, .token = next});
         // Second child
-        newNode = malloc(sizeof(WffParseTreeNode));
-        _wff_parse(token_list, newNode);
-        node->children[1] = newNode;
-        return true;
+        node.children[1] = _wff_parse(reader, nodes);
+        if (node.children[1] == NULL) {
+            return NULL;
+        }
     } else if (next->type == WTT_LPAREN) {
-        node->type = WPTNT_NONTERMINAL;
-        node->child_count = 5;
+        node.child_count = 5;
         // First child
-        WffParseTreeNode* newNode = malloc(sizeof(WffParseTreeNode));
-        newNode->type = WPTNT_TERMINAL;
-        newNode->token = next;
-        node->children[0] = newNode;
+        node.children[0] = _wff_parse_tree_node_create(nodes, &(WffParseTreeNode) {.type = WPTNT_TERMINAL, .token = next});
         // Second child
-        newNode = malloc(sizeof(WffParseTreeNode));
-        _wff_parse(token_list, newNode);
-        node->children[1] = newNode;
+        node.children[1] = _wff_parse(reader, nodes);
+        if (node.children[1] == NULL) {
+            return NULL;
+        }
         // Third child
-        next = wff_token_list_next(token_list);
-        if (next->type != WTT_OPERATOR || (next->type == WTT_OPERATOR && next->operator != WO_AND && next->operator != WO_OR && next->operator != WO_COND && next->operator != WO_BICOND)) {
-            return false;
+        next = _wff_token_reader_next(reader);
+        if (next == NULL || next->type != WTT_OPERATOR || (next->type == WTT_OPERATOR && next->operator != WO_AND && next->operator != WO_OR && next->operator != WO_COND && next->operator != WO_BICOND)) {
+            return NULL;
         }
-        newNode = malloc(sizeof(WffParseTreeNode));
-        newNode->type = WPTNT_TERMINAL;
-        newNode->token = next;
-        node->children[2] = newNode;
+        node.children[2] = _wff_parse_tree_node_create(nodes, &(WffParseTreeNode) {.type = WPTNT_TERMINAL, .token = next});
         // Fourth child
-        newNode = malloc(sizeof(WffParseTreeNode));
-        _wff_parse(token_list, newNode);
-        node->children[3] = newNode;
+        node.children[3] = _wff_parse(reader, nodes);
+        if (node.children[3] == NULL) {
+            return NULL;
+        }
         // Fifth child
-        next = wff_token_list_next(token_list);
-        if (next->type != WTT_RPAREN) {
-            return false;
+        next = _wff_token_reader_next(reader);
+        if (next == NULL || next->type != WTT_RPAREN) {
+            return NULL;
         }
-        newNode = malloc(sizeof(WffParseTreeNode));
-        newNode->type = WPTNT_TERMINAL;
-        newNode->token = next;
-        node->children[4] = newNode;
-        return true;
+        node.children[4] = _wff_parse_tree_node_create(nodes, &(WffParseTreeNode) {.type = WPTNT_TERMINAL, .token = next});
+    } else {
+        return NULL;
     }
-    return false;
+    return _wff_parse_tree_node_create(nodes, &node);
+}
+
+// Returns the shared copy of 'node' from the table, or a fresh malloc'd copy
+// if there is no table. Either way the copy's hash is filled in and a
+// terminal's token is swapped for the canonical one; children must already
+// have their hashes.
+WffParseTreeNode* _wff_parse_tree_node_create(WffNodeTable* nodes, const WffParseTreeNode* node) {
+    WffParseTreeNode hashed = *node;
+    if (hashed.type == WPTNT_TERMINAL) {
+        hashed.token = wff_token_canonical(node->token);
+        hashed.length = strlen(wff_token_get_string(hashed.token));
+        hashed.site_count = 0;
+    } else {
+        hashed.length = 0;
+        hashed.site_count = 1;
+        for (int i = 0; i < hashed.child_count; i++) {
+            hashed.length += hashed.children[i]->length;
+            hashed.site_count += hashed.children[i]->site_count;
+        }
+    }
+    hashed.hash = _wff_parse_tree_node_hash(node);
+    if (nodes != NULL) {
+        return wff_node_table_intern(nodes, &hashed);
+    }
+    WFF_STATS_ADD(nodes_allocated, 1);
+    WFF_STATS_ADD(bytes_allocated, sizeof(WffParseTreeNode));
+    WffParseTreeNode* copy = malloc(sizeof(WffParseTreeNode));
+    memcpy(copy, &hashed, sizeof(WffParseTreeNode));
+    return copy;
 }
 
 void wff_parse_tree_print(WffParseTree* tree) {
@@ -574,20 +1157,33 @@ void _wff_parse_tree_print(WffParseTreeNode* node, int level) {
     }
 }
 
-const char* wff_parse_tree_get_subwff_string(WffParseTreeNode* node) {
+// Returns the subwff as a new string, which the caller frees.
+char* wff_parse_tree_get_subwff_string(WffParseTreeNode* node) {
+    char* string = malloc((node->length + 1) * sizeof(char));
+    return wff_parse_tree_render(node, string);
+}
+
+// Writes the subwff to 'buffer', which must have room for node->length + 1
+// characters, and returns 'buffer'.
+char* wff_parse_tree_render(WffParseTreeNode* node, char* buffer) {
+    WFF_STATS_BEGIN(WSTP_RENDER);
+    char* end = _wff_parse_tree_render(node, buffer);
+    *end = '\0';
+    WFF_STATS_END(WSTP_RENDER);
+    return buffer;
+}
+
+// Writes the subwff to 'out' without a terminator and returns the end of what
+// was written.
+char* _wff_parse_tree_render(WffParseTreeNode* node, char* out) {
     if (node->type == WPTNT_TERMINAL || node->type == WPTNT_SEARCHVAR) {
-        return wff_token_get_string(node->token);
+        memcpy(out, wff_token_get_string(node->token), node->length);
+        return out + node->length;
     } else if (node->type == WPTNT_NONTERMINAL) {
-        char* str = malloc(1);
-        str[0] = '\0';
-        int str_size = 1;
         for (int i = 0; i < node->child_count; i++) {
-            const char* substr = wff_parse_tree_get_subwff_string(node->children[i]);
-            str_size += strlen(substr);
-            str = realloc(str, str_size);
-            strcat(str, substr);
+            out = _wff_parse_tree_render(node->children[i], out);
         }
-        return str;
+        return out;
     }
 
     printf("ERROR: Unhandled case\n");
@@ -595,7 +1191,11 @@ const char* wff_parse_tree_get_subwff_string(WffParseTreeNode* node) {
 }
 
 bool wff_parse_tree_subtree_equals(WffParseTreeNode* node1, WffParseTreeNode* node2) {
-    if (node1->type != node2->type) {
+    WFF_STATS_ADD(subtree_equals_calls, 1);
+    if (node1 == node2) {
+        return true;
+    }
+    if (node1->type != node2->type || node1->hash != node2->hash) {
         return false;
     }
     if (node1->type == WPTNT_TERMINAL) {
@@ -615,6 +1215,37 @@ bool wff_parse_tree_subtree_equals(WffParseTreeNode* node1, WffParseTreeNode* no
     abort();
 }
 
+uint64_t _wff_parse_tree_node_hash(const WffParseTreeNode* node) {
+    uint64_t hash = 14695981039346656037ULL;
+    if (node->type == WPTNT_TERMINAL) {
+        WffToken* token = node->token;
+        hash = (hash ^ token->type) * 1099511628211ULL;
+        if (token->type == WTT_OPERATOR) {
+            hash = (hash ^ token->operator) * 1099511628211ULL;
+        } else if (token->type == WTT_CONSTANT) {
+            hash = (hash ^ token->value) * 1099511628211ULL;
+        } else if (token->type == WTT_PROPOSITION) {
+            hash = (hash ^ token->variable->id) * 1099511628211ULL;
+        }
+    } else {
+        hash = (hash ^ node->child_count) * 1099511628211ULL;
+        for (int i = 0; i < node->child_count; i++) {
+            hash = (hash ^ node->children[i]->hash) * 1099511628211ULL;
+        }
+    }
+    // Finish with a full avalanche so that the low bits alone are usable as a
+    // table index.
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// NOTE: Rewrites nodes in place, so the tree's node table must not be used to
+// build anything afterwards. A repeated variable is a single shared node that
+// is only rewritten the first time it is reached.
 void _wff_parse_tree_set_searchvars(WffParseTreeNode* node) {
     for (int i = 0; i < node->child_count; i++) {
         WffParseTreeNode* child = node->children[i];
@@ -622,60 +1253,229 @@ void _wff_parse_tree_set_searchvars(WffParseTreeNode* node) {
             if (child->token->type == WTT_PROPOSITION) {
                 node->type = WPTNT_SEARCHVAR;
                 node->token = child->token;
-                free(child);
                 return;
             }
-        } else {
+        } else if (child->type == WPTNT_NONTERMINAL) {
             _wff_parse_tree_set_searchvars(child);
         }
     }
 }
 
 
-/* === WffTree === */
+/* === WffNodeTable === */
 
-WffTree* wff_tree_create(WffParseTree* parse_tree) {
-    WffTreeNode* root = malloc(sizeof(WffTreeNode));
-    root->wff_string = malloc(sizeof(char));
-    root->wff_string[0] = '\0';
-    root->subwffs_count = 0;
-    _wff_tree_create(parse_tree->root, root);
-
-    WffTree* wff_tree = malloc(sizeof(WffTree));
-    wff_tree->root = root->subwffs[0];
-    free(root->wff_string);
-    free(root);
-    return wff_tree;
+WffNodeTable* wff_node_table_create(WffArena* arena) {
+    WffNodeTable* table = wff_arena_alloc(arena, sizeof(WffNodeTable));
+    table->arena = arena;
+    table->capacity = WFF_NODE_TABLE_MIN_CAPACITY;
+    table->count = 0;
+    table->slots = wff_arena_alloc(arena, table->capacity * sizeof(WffParseTreeNode*));
+    memset(table->slots, 0, table->capacity * sizeof(WffParseTreeNode*));
+    return table;
 }
 
-void _wff_tree_create(WffParseTreeNode* parse_node, WffTreeNode* wff_node) {
-    // If terminal, copy the symbol into wff_node's string (essentially, each
-    // recursive call builds the string for the previous call and passes it up).
-    if (parse_node->type == WPTNT_TERMINAL) {
-        const char* token_string = wff_token_get_string(parse_node->token);
-        wff_node->wff_string = realloc(wff_node->wff_string, (strlen(wff_node->wff_string) + strlen(token_string) + 1) * sizeof(char));
-        strcat(wff_node->wff_string, token_string);
-        return; 
-    } else {
-        WffTreeNode* subwff_node = malloc(sizeof(WffTreeNode));
-        subwff_node->wff_string = malloc(sizeof(char));
-        subwff_node->wff_string[0] = '\0';
-        subwff_node->subwffs_count = 0;
+WffParseTreeNode* wff_node_table_intern(WffNodeTable* table, const WffParseTreeNode* node) {
+    size_t mask = table->capacity - 1;
+    size_t i = node->hash & mask;
+    while (table->slots[i] != NULL) {
+        if (table->slots[i]->hash == node->hash && _wff_node_table_node_equals(table->slots[i], node)) {
+            return table->slots[i];
+        }
+        i = (i + 1) & mask;
+    }
+
+    WFF_STATS_ADD(nodes_allocated, 1);
+    WffParseTreeNode* copy = wff_arena_alloc(table->arena, sizeof(WffParseTreeNode));
+    memcpy(copy, node, sizeof(WffParseTreeNode));
+    table->slots[i] = copy;
+    table->count++;
+    // Keep the load factor under 3/4.
+    if (table->count * 4 >= table->capacity * 3) {
+        _wff_node_table_grow(table);
+    }
+    return copy;
+}
 
-        wff_node->subwffs[wff_node->subwffs_count] = subwff_node;
-        wff_node->subwffs_count++;
+bool _wff_node_table_node_equals(const WffParseTreeNode* node1, const WffParseTreeNode* node2) {
+    if (node1->type != node2->type) {
+        return false;
+    }
+    if (node1->type == WPTNT_TERMINAL) {
+        return wff_token_equal(node1->token, node2->token);
+    }
+    if (node1->child_count != node2->child_count) {
+        return false;
+    }
+    for (int i = 0; i < node1->child_count; i++) {
+        if (node1->children[i] != node2->children[i]) {
+            return false;
+        }
+    }
+    return true;
+}
 
-        for (int i = 0; i < parse_node->child_count; i++) {
-            _wff_tree_create(parse_node->children[i], subwff_node);
+void _wff_node_table_grow(WffNodeTable* table) {
+    // The old slot array stays in the arena; with doubling, that waste is
+    // bounded by the size of the final array.
+    WffParseTreeNode** old_slots = table->slots;
+    size_t old_capacity = table->capacity;
+    table->capacity *= 2;
+    table->slots = wff_arena_alloc(table->arena, table->capacity * sizeof(WffParseTreeNode*));
+    memset(table->slots, 0, table->capacity * sizeof(WffParseTreeNode*));
+
+    size_t mask = table->capacity - 1;
+    for (size_t j = 0; j < old_capacity; j++) {
+        if (old_slots[j] != NULL) {
+            size_t i = old_slots[j]->hash & mask;
+            while (table->slots[i] != NULL) {
+                i = (i + 1) & mask;
+            }
+            table->slots[i] = old_slots[j];
         }
+    }
+}
 
-        wff_node->wff_string = realloc(wff_node->wff_string, (strlen(wff_node->wff_string) + strlen(subwff_node->wff_string) + 1) * sizeof(char));
-        strcat(wff_node->wff_string, subwff_node->wff_string);
+
+/* === WffNodeMap === */
+
+void wff_node_map_init(WffNodeMap* map, size_t value_size, size_t count) {
+    map->capacity = 16;
+    while (map->capacity < count * 2) {
+        map->capacity *= 2;
     }
+    map->keys = calloc(map->capacity, sizeof(WffParseTreeNode*));
+    map->values = value_size == 0 ? NULL : malloc(map->capacity * value_size);
+    map->value_size = value_size;
+    map->count = 0;
+    map->structural = false;
+}
+
+void wff_node_map_finish(WffNodeMap* map) {
+    free(map->keys);
+    free(map->values);
+}
+
+void wff_node_map_clear(WffNodeMap* map) {
+    memset(map->keys, 0, map->capacity * sizeof(WffParseTreeNode*));
+    map->count = 0;
+}
+
+bool wff_node_map_contains(const WffNodeMap* map, const WffParseTreeNode* node) {
+    return map->keys[_wff_node_map_slot(map, node)] != NULL;
+}
+
+void* wff_node_map_get(const WffNodeMap* map, const WffParseTreeNode* node) {
+    size_t i = _wff_node_map_slot(map, node);
+    return map->keys[i] == NULL ? NULL : map->values + i * map->value_size;
+}
+
+void* wff_node_map_put(WffNodeMap* map, WffParseTreeNode* node) {
+    size_t i;
+    _wff_node_map_insert(map, node, &i);
+    return map->values + i * map->value_size;
+}
+
+bool wff_node_map_add(WffNodeMap* map, WffParseTreeNode* node) {
+    size_t i;
+    return _wff_node_map_insert(map, node, &i);
+}
+
+// Returns the slot holding 'node', or the empty slot where it would go.
+size_t _wff_node_map_slot(const WffNodeMap* map, const WffParseTreeNode* node) {
+    size_t mask = map->capacity - 1;
+    size_t i = node->hash & mask;
+    while (map->keys[i] != NULL && map->keys[i] != node) {
+        if (map->structural && map->keys[i]->hash == node->hash && wff_parse_tree_subtree_equals(map->keys[i], (WffParseTreeNode*) node)) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+bool _wff_node_map_insert(WffNodeMap* map, WffParseTreeNode* node, size_t* slot) {
+    // Keep the load factor at or under 1/2.
+    if ((map->count + 1) * 2 > map->capacity) {
+        _wff_node_map_grow(map);
+    }
+    size_t i = _wff_node_map_slot(map, node);
+    *slot = i;
+    if (map->keys[i] != NULL) {
+        return false;
+    }
+    map->keys[i] = node;
+    if (map->value_size != 0) {
+        memset(map->values + i * map->value_size, 0, map->value_size);
+    }
+    map->count++;
+    return true;
+}
+
+void _wff_node_map_grow(WffNodeMap* map) {
+    WffParseTreeNode** old_keys = map->keys;
+    unsigned char* old_values = map->values;
+    size_t old_capacity = map->capacity;
+    map->capacity *= 2;
+    map->keys = calloc(map->capacity, sizeof(WffParseTreeNode*));
+    map->values = map->value_size == 0 ? NULL : malloc(map->capacity * map->value_size);
+
+    size_t mask = map->capacity - 1;
+    for (size_t j = 0; j < old_capacity; j++) {
+        if (old_keys[j] != NULL) {
+            size_t i = old_keys[j]->hash & mask;
+            while (map->keys[i] != NULL) {
+                i = (i + 1) & mask;
+            }
+            map->keys[i] = old_keys[j];
+            if (map->value_size != 0) {
+                memcpy(map->values + i * map->value_size, old_values + j * map->value_size, map->value_size);
+            }
+        }
+    }
+    free(old_keys);
+    free(old_values);
+}
+
+
+/* === WffTree === */
+
+WffTree* wff_tree_create(WffParseTree* parse_tree, WffArena* arena) {
+    WFF_STATS_BEGIN(WSTP_TREE);
+    WffTree* wff_tree = wff_arena_alloc(arena, sizeof(WffTree));
+    wff_tree->arena = arena;
+    wff_tree->string = wff_arena_alloc(arena, (parse_tree->root->length + 1) * sizeof(char));
+    wff_parse_tree_render(parse_tree->root, wff_tree->string);
+    wff_tree->root = _wff_tree_create(parse_tree->root, wff_tree->string, arena);
+    WFF_STATS_END(WSTP_TREE);
+    return wff_tree;
+}
+
+// 'span' is where this subwff starts in the tree's rendering; its subwffs
+// start further along it, after the children before them.
+WffTreeNode* _wff_tree_create(WffParseTreeNode* parse_node, const char* span, WffArena* arena) {
+    WffTreeNode* wff_node = wff_arena_alloc(arena, sizeof(WffTreeNode));
+    wff_node->wff_string = span;
+    wff_node->wff_string_length = parse_node->length;
+    wff_node->subwffs_count = 0;
+
+    for (int i = 0; i < parse_node->child_count; i++) {
+        WffParseTreeNode* child = parse_node->children[i];
+        if (child->type != WPTNT_TERMINAL) {
+            wff_node->subwffs[wff_node->subwffs_count] = _wff_tree_create(child, span, arena);
+            wff_node->subwffs_count++;
+        }
+        span += child->length;
+    }
+    return wff_node;
 }
 
 void wff_tree_destroy(WffTree* tree) {
+    if (tree->arena != NULL) {
+        // Owned by the arena.
+        return;
+    }
     _wff_tree_destroy(tree->root);
+    free(tree->string);
     free(tree);
 }
 
@@ -685,7 +1485,6 @@ void _wff_tree_destroy(WffTreeNode* node) {
             _wff_tree_destroy(node->subwffs[i]);
         }
     }
-    free(node->wff_string);
     free(node);
 }
 
@@ -700,24 +1499,85 @@ void _wff_tree_print(WffTreeNode* wff_node, int level) {
     for (int i = 0; i < level; i++) {
         printf("\t\t");
     }
-    printf("%s\n", wff_node->wff_string);
+    printf("%.*s\n", (int) wff_node->wff_string_length, wff_node->wff_string);
     for (int i = wff_node->subwffs_count / 2; i < wff_node->subwffs_count; i++) {
         _wff_tree_print(wff_node->subwffs[i], level + 1);
     }
 }
 
 
-/* === WffMatch === */
+/* === WffArena === */
+
+WffArena* wff_arena_create() {
+    WffArena* arena = malloc(sizeof(WffArena));
+    arena->refs = 1;
+    arena->blocks = NULL;
+    arena->allocation_count = 0;
+    arena->block_count = 0;
+    arena->bytes_allocated = 0;
+    return arena;
+}
+
+void wff_arena_destroy(WffArena* arena) {
+    WffArenaBlock* block = arena->blocks;
+    while (block != NULL) {
+        WffArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+void wff_arena_retain(WffArena* arena) {
+    arena->refs++;
+}
+
+void wff_arena_release(WffArena* arena) {
+    if (--arena->refs == 0) {
+        wff_arena_destroy(arena);
+    }
+}
 
-WffMatch* wff_match_create(WffParseTreeNode* wff_node, WffParseTreeNode* pattern_var_node) {
-    WffMatch* match = malloc(sizeof(WffMatch));
-    match->wff_node = wff_node;
-    match->pattern_var_node = pattern_var_node;
-    return match;
+void* wff_arena_alloc(WffArena* arena, size_t size) {
+    if (arena == NULL) {
+        WFF_STATS_ADD(bytes_allocated, size);
+        return malloc(size);
+    }
+    // Round up to the strictest alignment (not the size) of any type, so
+    // that every allocation stays suitably aligned without padding it more.
+    size_t alignment = _Alignof(max_align_t);
+    size = (size + alignment - 1) / alignment * alignment;
+    WFF_STATS_ADD(bytes_allocated, size);
+
+    WffArenaBlock* block = arena->blocks;
+    if (block == NULL || block->capacity - block->used < size) {
+        size_t capacity = block == NULL ? WFF_ARENA_MIN_BLOCK_SIZE : block->capacity * 2;
+        if (capacity > WFF_ARENA_MAX_BLOCK_SIZE) {
+            capacity = WFF_ARENA_MAX_BLOCK_SIZE;
+        }
+        if (capacity < size) {
+            capacity = size;
+        }
+        block = malloc(sizeof(WffArenaBlock) + capacity);
+        block->next = arena->blocks;
+        block->capacity = capacity;
+        block->used = 0;
+        arena->blocks = block;
+        arena->block_count++;
+    }
+
+    void* ptr = (char*) block->data + block->used;
+    block->used += size;
+    arena->allocation_count++;
+    arena->bytes_allocated += size;
+    return ptr;
 }
 
-void wff_match_destroy(WffMatch* match) {
-    free(match);
+char* wff_arena_strdup(WffArena* arena, const char* string) {
+    size_t size = strlen(string) + 1;
+    char* copy = wff_arena_alloc(arena, size * sizeof(char));
+    memcpy(copy, string, size);
+    return copy;
 }
 
 
@@ -725,127 +1585,91 @@ void wff_match_destroy(WffMatch* match) {
 
 WffList* wff_list_create() {
     WffList* list = malloc(sizeof(WffList));
-    list->start = NULL;
-    list->end = NULL;
-    list->current = NULL;
-    list->length = 0;
+    wff_vector_init(&list->wffs, sizeof(Wff*), NULL);
     return list;
 }
 
 void wff_list_destroy(WffList* list) {
-    WffListNode* node = list->start;
-    while (node != NULL) {
-        WffListNode* next = node->next;
-        free(node);
-        node = next;
-    }
+    wff_vector_finish(&list->wffs);
     free(list);
 }
 
 void wff_list_append(WffList* list, Wff* wff) {
-    WffListNode* node = malloc(sizeof(WffListNode));
-    node->wff = wff;
-    node->next = NULL;
+    wff_vector_append(&list->wffs, &wff);
+}
 
-    if (list->length == 0) {
-        list->start = node;
-        list->length = 1;
-    } else {
-        list->end->next = node;
-        list->length++;
-    }
-    list->end = node;
+Wff* wff_list_get(WffList* list, size_t index) {
+    Wff** wff = wff_vector_get(&list->wffs, index);
+    return wff == NULL ? NULL : *wff;
 }
 
-void wff_list_reset_current(WffList* list) {
-    list->current = list->start;
+WffVectorIterator wff_list_iterate(WffList* list) {
+    return wff_vector_iterate(&list->wffs);
 }
 
-Wff* wff_list_next(WffList* list) {
-    if (list->current == NULL) {
-        return NULL;
-    }
-    WffListNode* current = list->current;
-    list->current = list->current->next;
-    return current->wff;
+Wff* wff_list_next(WffVectorIterator* iterator) {
+    Wff** wff = wff_vector_iterator_next(iterator);
+    return wff == NULL ? NULL : *wff;
 }
 
 size_t wff_list_length(WffList* list) {
-    return list->length;
+    return list->wffs.length;
 }
 
-// Use set / hash set
+// Prints each structurally distinct wff once, in list order. The wffs each
+// have a tree of their own, so their roots are compared structurally, which
+// only ever compares roots with equal hashes.
 void wff_list_print_unique(WffList* subwffs_list) {
-    const char* done[subwffs_list->length];
-    size_t done_count = 0;
-    for (WffListNode* node = subwffs_list->start; node != NULL; node = node->next) {
-        bool isUniqe = true;
-        for (int i = 0; i < done_count; i++) {
-            if (strcmp(node->wff->string, done[i]) == 0) {
-                isUniqe = false;
-                break;
-            }
-        }
-        if (isUniqe) {
-            printf("%s\n", node->wff->string);
-            done[done_count] = node->wff->string;
-            done_count++;
+    WffNodeMap done;
+    wff_node_map_init(&done, 0, wff_list_length(subwffs_list));
+    done.structural = true;
+    WffVectorIterator iterator = wff_list_iterate(subwffs_list);
+    for (Wff* wff = wff_list_next(&iterator); wff != NULL; wff = wff_list_next(&iterator)) {
+        if (wff_node_map_add(&done, wff->parse_tree->root)) {
+            printf("%s\n", wff_get_string(wff));
         }
     }
+    wff_node_map_finish(&done);
 }
 
 
 /* === WffTokenList === */
 
-WffTokenList* wff_token_list_create() {
-    WffTokenList* list = malloc(sizeof(WffTokenList));
-    list->start = NULL;
-    list->end = NULL;
-    list->current = NULL;
-    list->length = 0;
+WffTokenList* wff_token_list_create(WffArena* arena) {
+    WffTokenList* list = wff_arena_alloc(arena, sizeof(WffTokenList));
+    wff_vector_init(&list->tokens, sizeof(WffToken*), arena);
     return list;
 }
 
 void wff_token_list_destroy(WffTokenList* list) {
-    WffTokenListNode* node = list->start;
-    while (node != NULL) {
-        WffTokenListNode* next = node->next;
-        free(node);
-        node = next;
+    if (list->tokens.arena != NULL) {
+        // Owned by the arena.
+        return;
     }
+    wff_vector_finish(&list->tokens);
     free(list);
 }
 
 void wff_token_list_append(WffTokenList* list, WffToken* wff_token) {
-    WffTokenListNode* node = malloc(sizeof(WffTokenListNode));
-    node->wff_token = wff_token;
-    node->next = NULL;
+    wff_vector_append(&list->tokens, &wff_token);
+}
 
-    if (list->length == 0) {
-        list->start = node;
-        list->length = 1;
-    } else {
-        list->end->next = node;
-        list->length++;
-    }
-    list->end = node;
+WffToken* wff_token_list_get(WffTokenList* list, size_t index) {
+    WffToken** token = wff_vector_get(&list->tokens, index);
+    return token == NULL ? NULL : *token;
 }
 
-void wff_token_list_reset_current(WffTokenList* list) {
-    list->current = list->start;
+WffVectorIterator wff_token_list_iterate(WffTokenList* list) {
+    return wff_vector_iterate(&list->tokens);
 }
 
-WffToken* wff_token_list_next(WffTokenList* list) {
-    if (list->current == NULL) {
-        return NULL;
-    }
-    WffTokenListNode* current = list->current;
-    list->current = list->current->next;
-    return current->wff_token;
+WffToken* wff_token_list_next(WffVectorIterator* iterator) {
+    WffToken** token = wff_vector_iterator_next(iterator);
+    return token == NULL ? NULL : *token;
 }
 
 size_t wff_token_list_length(WffTokenList* list) {
-    return list->length;
+    return list->tokens.length;
 }
 
 
@@ -853,86 +1677,45 @@ size_t wff_token_list_length(WffTokenList* list) {
 
 WffMatchList* wff_match_list_create() {
     WffMatchList* list = malloc(sizeof(WffMatchList));
-    list->start = NULL;
-    list->end = NULL;
-    list->current = NULL;
-    list->length = 0;
+    list->pattern = NULL;
+    wff_vector_init(&list->matches, sizeof(WffMatch), NULL);
     return list;
 }
 
 void wff_match_list_destroy(WffMatchList* list) {
-    WffMatchListNode* node = list->start;
-    while (node != NULL) {
-        WffMatchListNode* next = node->next;
-        free(node);
-        node = next;
+    wff_vector_finish(&list->matches);
+    if (list->pattern != NULL) {
+        wff_pattern_destroy(list->pattern);
     }
     free(list);
 }
 
-void wff_match_list_append(WffMatchList* list, WffMatch* match) {
-    WffMatchListNode* node = malloc(sizeof(WffMatchListNode));
-    node->match = match;
-    node->next = NULL;
-
-    if (list->length == 0) {
-        list->start = node;
-        list->length = 1;
-    } else {
-        list->end->next = node;
-        list->length++;
-    }
-    list->end = node;
+// Matches are stored by value: 'match' is copied, and what get and next
+// return is only good until the next append.
+void wff_match_list_append(WffMatchList* list, const WffMatch* match) {
+    wff_vector_append(&list->matches, match);
 }
 
-WffMatch* wff_match_list_get(WffMatchList* list, size_t index, bool set_current) {
-    if (index >= list->length) {
-        return NULL;
-    } else if (index + 1 == list->length) {
-        if (set_current) {
-            list->current = list->end->next;
-        }
-        return list->end->match;
-    }
-
-    WffMatchListNode* node = list->start; 
-    for (size_t i = 0; i < index; i++) {
-        node = node->next;
-    }
-    if (set_current) {
-        list->current = node->next;
-    }
-    return node->match;
+WffMatch* wff_match_list_get(WffMatchList* list, size_t index) {
+    return wff_vector_get(&list->matches, index);
 }
 
-void wff_match_list_reset_current(WffMatchList* list) {
-    list->current = list->start;
+WffVectorIterator wff_match_list_iterate(WffMatchList* list) {
+    return wff_vector_iterate(&list->matches);
 }
 
-WffMatch* wff_match_list_next(WffMatchList* list) {
-    if (list->current == NULL) {
-        return NULL;
-    }
-    WffMatchListNode* current = list->current;
-    list->current = list->current->next;
-    return current->match;
+WffMatch* wff_match_list_next(WffVectorIterator* iterator) {
+    return wff_vector_iterator_next(iterator);
 }
 
 size_t wff_match_list_length(WffMatchList* list) {
-    return list->length;
+    return list->matches.length;
 }
 
+// Moves the matches of 'list2' to the end of 'list1' and destroys 'list2'.
 void wff_match_list_merge(WffMatchList* list1, WffMatchList* list2) {
-    if (list1->length == 0) {
-        list1->start = list2->start;
-        list1->end = list2->end;
-        list1->length = list2->length;
-    } else if (list2->length != 0) {
-        list1->end->next = list2->start;
-        list1->end = list2->end;
-        list1->length += list2->length;
-    }
-    free(list2);
+    wff_vector_append_all(&list1->matches, &list2->matches);
+    wff_match_list_destroy(list2);
 }
 
 
@@ -940,51 +1723,33 @@ void wff_match_list_merge(WffMatchList* list1, WffMatchList* list2) {
 
 WffParseTreeNodeList* wff_parse_tree_node_list_create() {
     WffParseTreeNodeList* list = malloc(sizeof(WffParseTreeNodeList));
-    list->start = NULL;
-    list->end = NULL;
-    list->current = NULL;
-    list->length = 0;
+    wff_vector_init(&list->nodes, sizeof(WffParseTreeNode*), NULL);
     return list;
 }
 
 void wff_parse_tree_node_list_destroy(WffParseTreeNodeList* list) {
-    WffParseTreeNodeListNode* list_node = list->start;
-    while (list_node != NULL) {
-        WffParseTreeNodeListNode* next = list_node->next;
-        free(list_node);
-        list_node = next;
-    }
+    wff_vector_finish(&list->nodes);
     free(list);
 }
 
 void wff_parse_tree_node_list_append(WffParseTreeNodeList* list, WffParseTreeNode* parse_node) {
-    WffParseTreeNodeListNode* list_node = malloc(sizeof(WffParseTreeNodeListNode));
-    list_node->parse_node = parse_node;
-    list_node->next = NULL;
+    wff_vector_append(&list->nodes, &parse_node);
+}
 
-    if (list->length == 0) {
-        list->start = list_node;
-        list->length = 1;
-    } else {
-        list->end->next = list_node;
-        list->length++;
-    }
-    list->end = list_node;
+WffParseTreeNode* wff_parse_tree_node_list_get(WffParseTreeNodeList* list, size_t index) {
+    WffParseTreeNode** node = wff_vector_get(&list->nodes, index);
+    return node == NULL ? NULL : *node;
 }
 
-void wff_parse_tree_node_list_reset_current(WffParseTreeNodeList* list) {
-    list->current = list->start;
+WffVectorIterator wff_parse_tree_node_list_iterate(WffParseTreeNodeList* list) {
+    return wff_vector_iterate(&list->nodes);
 }
 
-WffParseTreeNode* wff_parse_tree_node_list_next(WffParseTreeNodeList* list) {
-    if (list->current == NULL) {
-        return NULL;
-    }
-    WffParseTreeNodeListNode* current = list->current;
-    list->current = list->current->next;
-    return current->parse_node;
+WffParseTreeNode* wff_parse_tree_node_list_next(WffVectorIterator* iterator) {
+    WffParseTreeNode** node = wff_vector_iterator_next(iterator);
+    return node == NULL ? NULL : *node;
 }
 
 size_t wff_parse_tree_node_list_length(WffParseTreeNodeList* list) {
-    return list->length;
-}
\ No newline at end of file
+    return list->nodes.length;
+}
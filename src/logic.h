@@ -2,11 +2,17 @@
 #define LOGIC_H_
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
 
+#include "vector.h"
+
 
 typedef struct Wff Wff;
 typedef struct WffMatch WffMatch;
+typedef struct WffArena WffArena;
+typedef struct WffPattern WffPattern;
+typedef struct WffOutcomeCursor WffOutcomeCursor;
 
 typedef struct WffToken WffToken;
 typedef struct WffTokenVariable WffTokenVariable;
@@ -20,63 +26,104 @@ typedef struct WffMatchList WffMatchList;
 
 
 struct Wff {
+    // The string and wff tree are NULL after the parse tree has changed, until
+    // wff_get_string or wff_get_tree makes them again.
     const char* string;
     size_t var_count;
     WffParseTree* parse_tree;
     WffTree* wff_tree;
+    // Owns every allocation made on behalf of this wff (string, tokens, parse
+    // tree and wff tree), so wff_destroy frees it all at once. Wffs rewritten
+    // from it with wff_rewrite and the like share its nodes, and so its arena,
+    // which is freed once the last of them is destroyed.
+    WffArena* arena;
 };
 
 
-// TODO: Generic list data structure
 void test();
 
 Wff* wff_create(const char* wff_string);
 void wff_destroy(Wff* wff);
-WffTokenList* wff_tokenize(const char* wff_string);
+WffTokenList* wff_tokenize(const char* wff_string, WffArena* arena);
 WffList* wff_subwffs(Wff* wff);
 WffMatchList* wff_match(Wff* wff, const char* wff_pattern_string);
 bool wff_substitute(Wff* wff, const char* search, const char* replace, size_t index);
-
-void wff_token_destroy(WffToken* token);
-WffToken* wff_token_copy(WffToken* token);
+Wff* wff_rewrite(Wff* wff, const char* search, const char* replace, size_t index);
+const char* wff_get_string(Wff* wff);
+WffTree* wff_get_tree(Wff* wff);
+
+WffPattern* wff_pattern_create(const char* search, const char* replace);
+void wff_pattern_destroy(WffPattern* pattern);
+WffMatchList* wff_pattern_match(Wff* wff, const WffPattern* pattern);
+bool wff_pattern_substitute(Wff* wff, const WffPattern* pattern, size_t index);
+Wff* wff_pattern_rewrite(Wff* wff, const WffPattern* pattern, size_t index);
+
+// A cursor has no current outcome until next, prev or seek first succeeds,
+// and never does if the pattern matches nowhere. Until then index and site
+// return WFF_OUTCOME_NONE, and binding, string and rewrite return NULL.
+#define WFF_OUTCOME_NONE SIZE_MAX
+
+WffOutcomeCursor* wff_outcome_cursor_create(Wff* wff, const WffPattern* pattern);
+void wff_outcome_cursor_destroy(WffOutcomeCursor* cursor);
+bool wff_outcome_cursor_next(WffOutcomeCursor* cursor);
+bool wff_outcome_cursor_prev(WffOutcomeCursor* cursor);
+bool wff_outcome_cursor_seek(WffOutcomeCursor* cursor, size_t index);
+size_t wff_outcome_cursor_count(WffOutcomeCursor* cursor);
+size_t wff_outcome_cursor_index(WffOutcomeCursor* cursor);
+size_t wff_outcome_cursor_site(WffOutcomeCursor* cursor);
+char* wff_outcome_cursor_binding(WffOutcomeCursor* cursor, const char* variable);
+char* wff_outcome_cursor_string(WffOutcomeCursor* cursor);
+Wff* wff_outcome_cursor_rewrite(WffOutcomeCursor* cursor);
+
+// Tokens from wff_tokenize are canonical, shared by every wff, and never the
+// caller's to free. Copies and variables belong to the arena given.
+WffToken* wff_token_copy(WffToken* token, WffArena* arena);
 bool wff_token_equal(WffToken* token1, WffToken* token2);
 const char* const wff_token_get_string(WffToken* token);
 
-WffTokenVariable* wff_token_variable_create(const char* variable_string);
-void wff_token_variable_destroy(WffTokenVariable* variable);
-WffTokenVariable* wff_token_variable_copy(WffTokenVariable* variable);
+WffTokenVariable* wff_token_variable_create(const char* variable_string, WffArena* arena);
+WffTokenVariable* wff_token_variable_copy(WffTokenVariable* variable, WffArena* arena);
 bool wff_token_variable_equals(WffTokenVariable* variable1, WffTokenVariable* variable2);
 const char* wff_token_variable_get_string(WffTokenVariable* variable);
 
-WffParseTree* wff_parse_tree_create(WffTokenList* token_list);
+WffParseTree* wff_parse_tree_create(WffTokenList* token_list, WffArena* arena);
 void wff_parse_tree_destroy(WffParseTree* tree);
 void wff_parse_tree_print(WffParseTree* tree);
 
-WffTree* wff_tree_create(WffParseTree* parse_tree);
+WffTree* wff_tree_create(WffParseTree* parse_tree, WffArena* arena);
 void wff_tree_destroy(WffTree* tree);
 void wff_tree_print(WffTree* wff_tree);
 
+WffArena* wff_arena_create();
+void wff_arena_destroy(WffArena* arena);
+void wff_arena_retain(WffArena* arena);
+void wff_arena_release(WffArena* arena);
+void* wff_arena_alloc(WffArena* arena, size_t size);
+char* wff_arena_strdup(WffArena* arena, const char* string);
+
 WffList* wff_list_create();
 void wff_list_destroy(WffList* list);
 void wff_list_append(WffList* list, Wff* wff);
-void wff_list_reset_current(WffList* list);
-Wff* wff_list_next(WffList* list);
+Wff* wff_list_get(WffList* list, size_t index);
+WffVectorIterator wff_list_iterate(WffList* list);
+Wff* wff_list_next(WffVectorIterator* iterator);
 size_t wff_list_length(WffList* list);
 void wff_list_print_unique(WffList* subwffs_list);
 
-WffTokenList* wff_token_list_create();
+WffTokenList* wff_token_list_create(WffArena* arena);
 void wff_token_list_destroy(WffTokenList* list);
 void wff_token_list_append(WffTokenList* list, WffToken* wff);
-void wff_token_list_reset_current(WffTokenList* list);
-WffToken* wff_token_list_next(WffTokenList* list);
+WffToken* wff_token_list_get(WffTokenList* list, size_t index);
+WffVectorIterator wff_token_list_iterate(WffTokenList* list);
+WffToken* wff_token_list_next(WffVectorIterator* iterator);
 size_t wff_token_list_length(WffTokenList* list);
 
 WffMatchList* wff_match_list_create();
 void wff_match_list_destroy(WffMatchList* list);
-void wff_match_list_append(WffMatchList* list, WffMatch* match);
-WffMatch* wff_match_list_get(WffMatchList* list, size_t index, bool set_current);
-void wff_match_list_reset_current(WffMatchList* list);
-WffMatch* wff_match_list_next(WffMatchList* list);
+void wff_match_list_append(WffMatchList* list, const WffMatch* match);
+WffMatch* wff_match_list_get(WffMatchList* list, size_t index);
+WffVectorIterator wff_match_list_iterate(WffMatchList* list);
+WffMatch* wff_match_list_next(WffVectorIterator* iterator);
 size_t wff_match_list_length(WffMatchList* list);
 void wff_match_list_merge(WffMatchList* list1, WffMatchList* list2);
 
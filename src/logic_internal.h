@@ -2,27 +2,31 @@
 #define LOGIC_INTERNAL_H_
 
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 #include "logic.h"
 
+typedef struct WffArenaBlock WffArenaBlock;
+
 typedef struct WffParseTreeNode WffParseTreeNode;
+typedef struct WffNodeTable WffNodeTable;
+typedef struct WffNodeMap WffNodeMap;
 typedef struct WffTreeNode WffTreeNode;
 
-typedef struct WffListNode WffListNode;
-
-typedef struct WffTokenListNode WffTokenListNode;
+typedef struct WffTokenReader WffTokenReader;
 
 typedef struct WffParseTreeNodeList WffParseTreeNodeList;
-typedef struct WffParseTreeNodeListNode WffParseTreeNodeListNode;
 
-typedef struct WffMatchListNode WffMatchListNode;
+typedef struct WffOutcome WffOutcome;
 
 typedef enum {
     WTT_NONE,
     WTT_LPAREN,
     WTT_RPAREN,
     WTT_PROPOSITION,
+    WTT_CONSTANT,
     WTT_OPERATOR
 } WffTokenType;
 
@@ -43,10 +47,35 @@ typedef enum {
 
 /* === Wff === */
 WffParseTreeNodeList* wff_find_vars(Wff* wff);
-const char* _wff_subwffs(WffList* list, WffParseTreeNode* node);
+WffParseTreeNodeList* wff_unique_subwffs(Wff* wff);
+void _wff_unique_subwffs(WffParseTreeNode* node, WffNodeMap* seen, WffParseTreeNodeList* list);
+void _wff_subwffs(WffList* list, WffParseTreeNode* node, char* buffer);
 void _wff_find_vars(WffParseTreeNode* node, WffParseTreeNodeList* list);
-bool _wff_match(WffParseTreeNode* wff_parse_node, WffParseTreeNode* pattern_parse_node, WffMatchList* list);
-void _wff_match_traversal(WffParseTreeNode* wff_parse_node_root, WffParseTree* pattern_tree, WffMatchList* list);
+bool _wff_match(WffParseTreeNode* wff_parse_node, WffParseTreeNode* pattern_parse_node, WffMatchList* list, WffParseTreeNode** bindings);
+void _wff_match_traversal(WffParseTreeNode* wff_parse_node_root, const WffParseTree* pattern_tree, WffMatchList* list, size_t* site, WffParseTreeNode** bindings);
+WffParseTreeNode* _wff_instantiate(WffNodeTable* table, WffParseTreeNode* template_node, WffParseTreeNode** bindings);
+WffParseTreeNode* _wff_replace_site(WffNodeTable* table, WffParseTreeNode* node, size_t* ordinal, size_t site, WffParseTreeNode* replacement);
+WffParseTreeNode* _wff_pattern_rewrite_root(Wff* wff, const WffPattern* pattern, size_t index, size_t* var_count);
+void _wff_set_root(Wff* wff, WffParseTreeNode* root, size_t var_count);
+Wff* _wff_create_version(Wff* wff, WffParseTreeNode* root, size_t var_count);
+size_t _wff_count_propositions(WffParseTreeNode* node);
+
+
+/* === WffPattern === */
+// A search expression (and optionally a replace expression) parsed once so
+// that it can be matched and substituted any number of times. Nothing in it is
+// modified after wff_pattern_create, so one pattern can be shared between
+// threads.
+struct WffPattern {
+    WffArena* arena;
+    // Search expression with its variables turned into search vars.
+    WffParseTree* search;
+    // Number of variable occurrences in the search expression, which is the
+    // size of each group of matches that wff_pattern_match reports.
+    size_t var_count;
+    // Replace expression to instantiate, or NULL for a match-only pattern.
+    WffParseTreeNode* replace;
+};
 
 
 /* === WffToken === */
@@ -55,23 +84,83 @@ struct WffToken {
     union {
         WffTokenVariable* variable;
         WffOperator operator;
+        bool value;
     };
 };
 
+// Number of possible variables: the letters a-z and A-Z.
+#define WFF_VARIABLE_COUNT 52
+
+extern const char* const STR_NOT;
+extern const char* const STR_AND;
+extern const char* const STR_OR;
+extern const char* const STR_COND;
+extern const char* const STR_BICOND;
+extern const char* const STR_LPAREN;
+extern const char* const STR_RPAREN;
+extern const char* const STR_TRUE;
+extern const char* const STR_FALSE;
+
+WffToken* wff_token_canonical(const WffToken* token);
+WffToken* _wff_lex(const char** cursor);
+int _wff_variable_index(char c);
+
 
 /* === WffTokenVariable === */
+// Variables are identified by a dense ID assigned from their name when they
+// are lexed (see wff_token_canonical), so comparing two is an integer compare
+// and anything kept per variable can be an array of WFF_VARIABLE_COUNT
+// indexed by ID.
 struct WffTokenVariable {
+    size_t id;
     const char* string;
 };
 
+// Canonical variables, indexed by ID.
+extern WffTokenVariable WFF_VARIABLES[WFF_VARIABLE_COUNT];
+
+
+/* === WffTokenReader === */
+// Where _wff_parse takes its tokens from: a token list if one is given, a
+// function if one is given (which returns NULL at the end), or else a string
+// that is lexed as it is parsed. Counts the propositions read.
+struct WffTokenReader {
+    WffTokenList* list;
+    WffVectorIterator tokens;
+    WffToken* (*next)(void* source);
+    void* source;
+    const char* cursor;
+    size_t var_count;
+};
+
+WffToken* _wff_token_reader_next(WffTokenReader* reader);
+bool _wff_token_reader_done(WffTokenReader* reader);
+
 
 /* === WffParseTree === */
+// Trees built in an arena are hash-consed through their node table:
+// structurally identical subtrees are a single shared node, so the tree is
+// really a DAG and two subtrees of it are equal iff their pointers are. Such
+// nodes must never be modified in place. Trees built without an arena have no
+// table and are plain trees.
 struct WffParseTree {
+    WffArena* arena;
+    WffNodeTable* nodes;
     WffParseTreeNode* root;
 };
 
 struct WffParseTreeNode {
     WffParseTreeNodeType type;
+    // Structural (Merkle) hash: derived from the token for terminals and from
+    // the children's hashes for nonterminals, so equal subtrees hash equally
+    // no matter which tree or table they belong to.
+    uint64_t hash;
+    // Length of the subwff as rendered (without spaces), cached alongside the
+    // hash so that rendering can size its output up front.
+    size_t length;
+    // Nonterminals in the subtree, i.e. how many sites it spans, so that a
+    // site can be reached without counting the subtrees before it.
+    size_t site_count;
     union {
         struct {
             int child_count;
@@ -81,102 +170,209 @@ struct WffParseTreeNode {
     };
 };
 
-const char* wff_parse_tree_get_subwff_string(WffParseTreeNode* node);
+char* wff_parse_tree_get_subwff_string(WffParseTreeNode* node);
+char* wff_parse_tree_render(WffParseTreeNode* node, char* buffer);
+char* _wff_parse_tree_render(WffParseTreeNode* node, char* out);
+uint64_t _wff_parse_tree_node_hash(const WffParseTreeNode* node);
 bool wff_parse_tree_subtree_equals(WffParseTreeNode* node1, WffParseTreeNode* node2);
 void _wff_parse_tree_destroy(WffParseTreeNode* node);
-bool _wff_parse(WffTokenList* token_list, WffParseTreeNode* node);
+WffParseTree* _wff_parse_tree_create(WffTokenReader* reader, WffArena* arena, WffNodeTable* nodes);
+WffParseTree* _wff_parse_tree_create_from_string(const char* string, WffArena* arena, WffNodeTable* nodes, size_t* var_count);
+WffParseTreeNode* _wff_parse(WffTokenReader* reader, WffNodeTable* nodes);
+WffParseTreeNode* _wff_parse_tree_node_create(WffNodeTable* nodes, const WffParseTreeNode* node);
 void _wff_parse_tree_print(WffParseTreeNode* node, int level);
 void _wff_parse_tree_set_searchvars(WffParseTreeNode* node);
 
 
+/* === WffNodeTable === */
+// Unique table used to hash-cons parse tree nodes. Terminals only ever point
+// at canonical tokens, which are never freed, so nodes from any tree can be
+// interned into any table. Slots are found with the
+// node's structural hash, and nonterminals are compared on their (already
+// unique) child pointers and terminals on their token, so a lookup never has
+// to recurse.
+struct WffNodeTable {
+    WffArena* arena;
+    WffParseTreeNode** slots;
+    size_t capacity;
+    size_t count;
+};
+
+WffNodeTable* wff_node_table_create(WffArena* arena);
+WffParseTreeNode* wff_node_table_intern(WffNodeTable* table, const WffParseTreeNode* node);
+bool _wff_node_table_node_equals(const WffParseTreeNode* node1, const WffParseTreeNode* node2);
+void _wff_node_table_grow(WffNodeTable* table);
+
+
+/* === WffNodeMap === */
+// Open-addressed map from parse tree nodes to fixed-size values, for keeping
+// something per distinct subwff. Nodes of a hash-consed tree are equal iff
+// their pointers are, so by default keys are only compared by pointer; set
+// 'structural' to compare keys from different trees by structure instead.
+// With a 'value_size' of 0 it is a set of nodes. Values start out zeroed, and
+// pointers to them only last until the next key is added.
+struct WffNodeMap {
+    WffParseTreeNode** keys;
+    unsigned char* values;
+    size_t value_size;
+    size_t capacity;
+    size_t count;
+    bool structural;
+};
+
+// 'count' is how many keys are expected, to size the map up front.
+void wff_node_map_init(WffNodeMap* map, size_t value_size, size_t count);
+void wff_node_map_finish(WffNodeMap* map);
+void wff_node_map_clear(WffNodeMap* map);
+bool wff_node_map_contains(const WffNodeMap* map, const WffParseTreeNode* node);
+// Returns the value of 'node', or NULL if it isn't a key.
+void* wff_node_map_get(const WffNodeMap* map, const WffParseTreeNode* node);
+// Returns the value of 'node', adding it first if it isn't a key yet.
+void* wff_node_map_put(WffNodeMap* map, WffParseTreeNode* node);
+// Adds 'node' if it isn't a key yet. Returns whether it was added.
+bool wff_node_map_add(WffNodeMap* map, WffParseTreeNode* node);
+size_t _wff_node_map_slot(const WffNodeMap* map, const WffParseTreeNode* node);
+bool _wff_node_map_insert(WffNodeMap* map, WffParseTreeNode* node, size_t* slot);
+void _wff_node_map_grow(WffNodeMap* map);
+
+
 /* === WffMatch === */
 struct WffMatch {
     WffParseTreeNode* wff_node;
+    // Only set on the first match of each group: the root of the matched
+    // subwff and its preorder position among the wff's nonterminals. The
+    // position is what identifies the site, since a shared node can occur at
+    // several places in the wff.
     WffParseTreeNode* subwff_root;
+    size_t site;
     WffParseTreeNode* pattern_var_node;
 };
 
-WffMatch* wff_match_create(WffParseTreeNode* wff_node, WffParseTreeNode* pattern_var_node);
-// NOTE: Does not free members, just the 'match' struct
-void wff_match_destroy(WffMatch* match);
+
+/* === WffOutcomeCursor === */
+// Steps through the outcomes of substituting a pattern at each site of a wff,
+// matching only as far as it is asked to go. The preorder walk over the sites
+// is kept on a stack so that it can stop at each outcome and pick up there
+// later. Outcomes found are kept, so going back, or around again once every
+// site has been tried, never matches anything twice.
+struct WffOutcomeCursor {
+    Wff* wff;
+    const WffPattern* pattern;
+    // Distinct variables of the search expression, in order of appearance.
+    size_t var_ids[WFF_VARIABLE_COUNT];
+    size_t var_count;
+
+    WffParseTreeNode** stack;
+    size_t stack_length;
+    size_t stack_capacity;
+    size_t next_site;
+    // Scratch space for _wff_match, all NULL between uses.
+    WffParseTreeNode* bindings[WFF_VARIABLE_COUNT];
+
+    // Holds the binding records.
+    WffArena* arena;
+    WffOutcome* outcomes;
+    size_t outcome_count;
+    size_t outcome_capacity;
+    // Index of the current outcome, or WFF_OUTCOME_NONE before the first move.
+    size_t current;
+};
+
+struct WffOutcome {
+    size_t site;
+    WffParseTreeNode* subwff_root;
+    // Subwff bound to each of the cursor's var_ids.
+    WffParseTreeNode** bindings;
+    // Root of the rewritten wff and its proposition count, once built.
+    WffParseTreeNode* root;
+    size_t var_count;
+};
+
+void _wff_outcome_cursor_find_vars(WffOutcomeCursor* cursor, WffParseTreeNode* node, bool* seen);
+bool _wff_outcome_cursor_advance(WffOutcomeCursor* cursor);
+WffOutcome* _wff_outcome_cursor_build(WffOutcomeCursor* cursor);
 
 
 /* === WffTree === */
+// The wff is rendered once into 'string', and each node's string is the span
+// of it that holds that subwff.
 struct WffTree {
+    WffArena* arena;
+    char* string;
     WffTreeNode* root;
 };
 
 struct WffTreeNode {
-    char* wff_string;
+    // Not NUL-terminated.
+    const char* wff_string;
+    size_t wff_string_length;
     int subwffs_count;
     struct WffTreeNode* subwffs[3];
 };
 
-void _wff_tree_create(WffParseTreeNode* parse_node, WffTreeNode* wff_node);
+WffTreeNode* _wff_tree_create(WffParseTreeNode* parse_node, const char* span, WffArena* arena);
 void _wff_tree_destroy(WffTreeNode* node);
 void _wff_tree_print(WffTreeNode* wff_node, int level);
 
 
-/* === WffList === */
-struct WffList {
-    WffListNode* start;
-    WffListNode* end;
-    WffListNode* current;
-    size_t length;
+/* === WffArena === */
+// Region allocator: memory is handed out from large blocks and only released
+// all at once by wff_arena_destroy. Functions that accept an arena fall back
+// to malloc when it is NULL.
+//
+// An arena with several owners (like the versions of a rewritten wff) counts
+// them: wff_arena_retain adds one and wff_arena_release frees the arena when
+// the last one lets go.
+struct WffArena {
+    size_t refs;
+    WffArenaBlock* blocks;
+    size_t allocation_count;
+    size_t block_count;
+    size_t bytes_allocated;
 };
 
-struct WffListNode {
-    Wff* wff;
-    struct WffListNode* next;
+struct WffArenaBlock {
+    WffArenaBlock* next;
+    size_t capacity;
+    size_t used;
+    max_align_t data[];
 };
 
 
-/* === WffTokenList === */
-struct WffTokenList {
-    WffTokenListNode* start;
-    WffTokenListNode* end;
-    WffTokenListNode* current;
-    size_t length;
+/* === WffList === */
+// The lists below each hold pointers in a WffVector.
+struct WffList {
+    WffVector wffs;
 };
 
-struct WffTokenListNode {
-    WffToken* wff_token;
-    struct WffTokenListNode* next;
+
+/* === WffTokenList === */
+// In the arena it was created with, if any.
+struct WffTokenList {
+    WffVector tokens;
 };
 
 
 /* === WffMatchList === */
 struct WffMatchList {
-    WffMatchListNode* start;
-    WffMatchListNode* end;
-    WffMatchListNode* current;
-    size_t length;
-};
-
-struct WffMatchListNode {
-    WffMatch* match;
-    struct WffMatchListNode* next;
+    // Pattern compiled by wff_match on the caller's behalf; the matches point
+    // into it, so it is destroyed along with the list.
+    WffPattern* pattern;
+    WffVector matches;
 };
 
 
 /* === WffParseTreeNodeList ===*/
 struct WffParseTreeNodeList {
-    WffParseTreeNodeListNode* start;
-    WffParseTreeNodeListNode* end;
-    WffParseTreeNodeListNode* current;
-    size_t length;
-};
-
-struct WffParseTreeNodeListNode {
-    WffParseTreeNode* parse_node;
-    struct WffParseTreeNodeListNode* next;
+    WffVector nodes;
 };
 
 WffParseTreeNodeList* wff_parse_tree_node_list_create();
 void wff_parse_tree_node_list_destroy(WffParseTreeNodeList* list);
 void wff_parse_tree_node_list_append(WffParseTreeNodeList* list, WffParseTreeNode* parse_node);
-void wff_parse_tree_node_list_reset_current(WffParseTreeNodeList* list);
-WffParseTreeNode* wff_parse_tree_node_list_next(WffParseTreeNodeList* list);
+WffParseTreeNode* wff_parse_tree_node_list_get(WffParseTreeNodeList* list, size_t index);
+WffVectorIterator wff_parse_tree_node_list_iterate(WffParseTreeNodeList* list);
+WffParseTreeNode* wff_parse_tree_node_list_next(WffVectorIterator* iterator);
 size_t wff_parse_tree_node_list_length(WffParseTreeNodeList* list);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,370 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "sat.h"
+#include "sat_internal.h"
+#include "normal.h"
+#include "normal_internal.h"
+
+
+/* === Wff === */
+
+Wff* wff_normal_nnf(Wff* wff) {
+    WffNnf nnf;
+    _wff_nnf_init(&nnf, wff->parse_tree->nodes);
+    size_t count;
+    WffParseTreeNode* root = _wff_nnf(&nnf, wff->parse_tree->root, false, &count);
+    _wff_nnf_finish(&nnf);
+    return _wff_create_version(wff, root, count);
+}
+
+WffCnf* wff_normal_cnf(Wff* wff) {
+    WffParseTreeNode* root = wff->parse_tree->root;
+    size_t node_count = wff->parse_tree->nodes->count;
+    WffCnf* cnf = wff_cnf_create();
+    WffTseitin encoder;
+    _wff_tseitin_init(&encoder, cnf, node_count);
+
+    // The letters get the first variables, in order, before any subwff does.
+    WffNodeMap seen;
+    wff_node_map_init(&seen, 0, node_count);
+    bool present[WFF_VARIABLE_COUNT] = {false};
+    _wff_normal_mark_variables(root, &seen, present);
+    wff_node_map_finish(&seen);
+    for (size_t id = 0; id < WFF_VARIABLE_COUNT; id++) {
+        if (present[id]) {
+            encoder.variables[id] = wff_cnf_new_var(cnf);
+        }
+    }
+
+    // Only the root's truth is asserted, so everything under it starts out
+    // positive.
+    int literal = _wff_tseitin_encode_polarity(&encoder, root, WFF_TSEITIN_POSITIVE);
+    wff_cnf_add_clause(cnf, &literal, 1);
+    _wff_tseitin_finish(&encoder);
+    return cnf;
+}
+
+Wff* wff_normal_dnf(Wff* wff, size_t max_terms) {
+    WffNnf nnf;
+    _wff_nnf_init(&nnf, wff->parse_tree->nodes);
+    size_t count;
+    WffParseTreeNode* root = _wff_nnf(&nnf, wff->parse_tree->root, false, &count);
+
+    WffDnf dnf;
+    dnf.arena = wff_arena_create();
+    wff_node_map_init(&dnf.terms, sizeof(WffDnfTerms*), wff->parse_tree->nodes->count);
+    dnf.max_terms = max_terms;
+    memset(dnf.literals, 0, sizeof(dnf.literals));
+
+    Wff* result = NULL;
+    WffDnfTerms* terms = _wff_dnf(&dnf, root);
+    if (terms != NULL) {
+        root = _wff_dnf_build(&dnf, &nnf, terms, &count);
+        result = _wff_create_version(wff, root, count);
+    }
+    wff_node_map_finish(&dnf.terms);
+    wff_arena_destroy(dnf.arena);
+    _wff_nnf_finish(&nnf);
+    return result;
+}
+
+void _wff_normal_mark_variables(WffParseTreeNode* node, WffNodeMap* seen, bool* present) {
+    if (node->type != WPTNT_NONTERMINAL || !wff_node_map_add(seen, node)) {
+        return;
+    }
+
+    if (node->child_count == 1) {
+        WffToken* token = node->children[0]->token;
+        if (token->type == WTT_PROPOSITION) {
+            present[token->variable->id] = true;
+        }
+        return;
+    }
+    for (int j = 0; j < node->child_count; j++) {
+        _wff_normal_mark_variables(node->children[j], seen, present);
+    }
+}
+
+
+/* === WffNnf === */
+
+void _wff_nnf_init(WffNnf* nnf, WffNodeTable* nodes) {
+    nnf->nodes = nodes;
+    wff_node_map_init(&nnf->entries, sizeof(WffNnfEntry), nodes->count);
+    nnf->lparen = _wff_nnf_terminal(nnf, (WffToken) {.type = WTT_LPAREN});
+    nnf->rparen = _wff_nnf_terminal(nnf, (WffToken) {.type = WTT_RPAREN});
+    nnf->not = _wff_nnf_terminal(nnf, (WffToken) {.type = WTT_OPERATOR, .operator = WO_NOT});
+    nnf->and = _wff_nnf_terminal(nnf, (WffToken) {.type = WTT_OPERATOR, .operator = WO_AND});
+    nnf->or = _wff_nnf_terminal(nnf, (WffToken) {.type = WTT_OPERATOR, .operator = WO_OR});
+}
+
+void _wff_nnf_finish(WffNnf* nnf) {
+    wff_node_map_finish(&nnf->entries);
+}
+
+// Returns the NNF of the subwff, or of its negation, and writes how many
+// propositions it has to 'count'.
+WffParseTreeNode* _wff_nnf(WffNnf* nnf, WffParseTreeNode* node, bool negated, size_t* count) {
+    WffNnfEntry* entry = wff_node_map_get(&nnf->entries, node);
+    if (entry != NULL && entry->results[negated] != NULL) {
+        *count = entry->counts[negated];
+        return entry->results[negated];
+    }
+    WffParseTreeNode* result = _wff_nnf_convert(nnf, node, negated, count);
+    // Converting the operands may have added keys and moved the entry.
+    entry = wff_node_map_put(&nnf->entries, node);
+    entry->results[negated] = result;
+    entry->counts[negated] = *count;
+    return result;
+}
+
+WffParseTreeNode* _wff_nnf_convert(WffNnf* nnf, WffParseTreeNode* node, bool negated, size_t* count) {
+    if (node->child_count == 1) {
+        WffToken* token = node->children[0]->token;
+        *count = token->type == WTT_PROPOSITION;
+        if (!negated) {
+            return node;
+        }
+        return token->type == WTT_CONSTANT ? _wff_nnf_constant(nnf, !token->value) : _wff_nnf_not(nnf, node);
+    } else if (node->child_count == 2) {
+        return _wff_nnf(nnf, node->children[1], !negated, count);
+    }
+
+    WffParseTreeNode* left = node->children[1];
+    WffParseTreeNode* right = node->children[3];
+    size_t left_count;
+    size_t right_count;
+    WffOperator operator = node->children[2]->token->operator;
+    switch (operator) {
+        case WO_AND:
+        case WO_OR: {
+            // A negation turns one into the other (De Morgan).
+            bool conjunction = (operator == WO_AND) != negated;
+            WffParseTreeNode* a = _wff_nnf(nnf, left, negated, &left_count);
+            WffParseTreeNode* b = _wff_nnf(nnf, right, negated, &right_count);
+            *count = left_count + right_count;
+            return _wff_nnf_binary(nnf, a, conjunction ? nnf->and : nnf->or, b);
+        }
+        case WO_COND: {
+            // (a => b) is (~a v b), and its negation (a ^ ~b).
+            WffParseTreeNode* a = _wff_nnf(nnf, left, !negated, &left_count);
+            WffParseTreeNode* b = _wff_nnf(nnf, right, negated, &right_count);
+            *count = left_count + right_count;
+            return _wff_nnf_binary(nnf, a, negated ? nnf->and : nnf->or, b);
+        }
+        case WO_BICOND: {
+            // (a <=> b) is ((a ^ b) v (~a ^ ~b)), and its negation
+            // ((a ^ ~b) v (~a ^ b)).
+            size_t counts[4];
+            WffParseTreeNode* a = _wff_nnf(nnf, left, false, &counts[0]);
+            WffParseTreeNode* not_a = _wff_nnf(nnf, left, true, &counts[1]);
+            WffParseTreeNode* b = _wff_nnf(nnf, right, negated, &counts[2]);
+            WffParseTreeNode* not_b = _wff_nnf(nnf, right, !negated, &counts[3]);
+            *count = counts[0] + counts[1] + counts[2] + counts[3];
+            return _wff_nnf_binary(nnf, _wff_nnf_binary(nnf, a, nnf->and, b), nnf->or, _wff_nnf_binary(nnf, not_a, nnf->and, not_b));
+        }
+        default:
+            printf("ERROR: Unhandled case\n");
+            abort();
+    }
+}
+
+WffParseTreeNode* _wff_nnf_binary(WffNnf* nnf, WffParseTreeNode* left, WffParseTreeNode* operator, WffParseTreeNode* right) {
+    WffParseTreeNode node = {.type = WPTNT_NONTERMINAL, .child_count = 5, .children = {nnf->lparen, left, operator, right, nnf->rparen}};
+    return _wff_parse_tree_node_create(nnf->nodes, &node);
+}
+
+WffParseTreeNode* _wff_nnf_not(WffNnf* nnf, WffParseTreeNode* operand) {
+    WffParseTreeNode node = {.type = WPTNT_NONTERMINAL, .child_count = 2, .children = {nnf->not, operand}};
+    return _wff_parse_tree_node_create(nnf->nodes, &node);
+}
+
+WffParseTreeNode* _wff_nnf_constant(WffNnf* nnf, bool value) {
+    WffParseTreeNode* terminal = _wff_nnf_terminal(nnf, (WffToken) {.type = WTT_CONSTANT, .value = value});
+    WffParseTreeNode node = {.type = WPTNT_NONTERMINAL, .child_count = 1, .children = {terminal}};
+    return _wff_parse_tree_node_create(nnf->nodes, &node);
+}
+
+// Returns the table's terminal for the token, which needn't be canonical.
+WffParseTreeNode* _wff_nnf_terminal(WffNnf* nnf, WffToken token) {
+    WffParseTreeNode node = {.type = WPTNT_TERMINAL, .token = &token};
+    return _wff_parse_tree_node_create(nnf->nodes, &node);
+}
+
+
+/* === WffDnf === */
+
+// Returns the conjunctions of the NNF subwff, or NULL if there are too many.
+WffDnfTerms* _wff_dnf(WffDnf* dnf, WffParseTreeNode* node) {
+    WffDnfTerms** expanded = wff_node_map_get(&dnf->terms, node);
+    if (expanded != NULL) {
+        return *expanded;
+    }
+
+    WffDnfTerms* terms;
+    if (node->child_count != 5) {
+        terms = _wff_dnf_leaf(dnf, node);
+    } else {
+        WffDnfTerms* left = _wff_dnf(dnf, node->children[1]);
+        WffDnfTerms* right = left == NULL ? NULL : _wff_dnf(dnf, node->children[3]);
+        if (right == NULL) {
+            return NULL;
+        }
+        bool conjunction = node->children[2]->token->operator == WO_AND;
+        terms = conjunction ? _wff_dnf_product(dnf, left, right) : _wff_dnf_union(dnf, left, right);
+        if (terms == NULL) {
+            return NULL;
+        }
+    }
+
+    *(WffDnfTerms**) wff_node_map_put(&dnf->terms, node) = terms;
+    return terms;
+}
+
+// A literal or a constant: one conjunction of one literal, T is the empty
+// conjunction and F is no conjunction at all.
+WffDnfTerms* _wff_dnf_leaf(WffDnf* dnf, WffParseTreeNode* node) {
+    WffParseTreeNode* atom = node->child_count == 2 ? node->children[1] : node;
+    WffToken* token = atom->children[0]->token;
+    if (token->type == WTT_CONSTANT) {
+        WffDnfTerm empty = {.length = 0, .literals = NULL};
+        return _wff_dnf_store(dnf, &empty, token->value ? 1 : 0);
+    }
+
+    uint8_t literal = 2 * token->variable->id + (node->child_count == 2);
+    dnf->literals[literal] = node;
+    WffDnfTerm term = {.length = 1, .literals = wff_arena_alloc(dnf->arena, 1)};
+    term.literals[0] = literal;
+    return _wff_dnf_store(dnf, &term, 1);
+}
+
+WffDnfTerms* _wff_dnf_union(WffDnf* dnf, WffDnfTerms* left, WffDnfTerms* right) {
+    size_t count = left->count + right->count;
+    WffDnfTerm* terms = malloc((count + 1) * sizeof(WffDnfTerm));
+    memcpy(terms, left->terms, left->count * sizeof(WffDnfTerm));
+    memcpy(terms + left->count, right->terms, right->count * sizeof(WffDnfTerm));
+    count = _wff_dnf_normalize(terms, count);
+    WffDnfTerms* result = count > dnf->max_terms ? NULL : _wff_dnf_store(dnf, terms, count);
+    free(terms);
+    return result;
+}
+
+// Conjoins every conjunction of 'left' with every one of 'right'. Repeats are
+// dropped whenever the buffer fills, so it holds at most twice the limit.
+WffDnfTerms* _wff_dnf_product(WffDnf* dnf, WffDnfTerms* left, WffDnfTerms* right) {
+    size_t capacity = 2 * dnf->max_terms + 1;
+    if (left->count * right->count < capacity) {
+        capacity = left->count * right->count;
+    }
+    WffDnfTerm* terms = malloc((capacity + 1) * sizeof(WffDnfTerm));
+    size_t count = 0;
+    uint8_t scratch[WFF_DNF_LITERAL_COUNT];
+    for (size_t i = 0; i < left->count; i++) {
+        for (size_t j = 0; j < right->count; j++) {
+            size_t length;
+            if (!_wff_dnf_merge(&left->terms[i], &right->terms[j], scratch, &length)) {
+                continue;
+            }
+            if (count == capacity) {
+                count = _wff_dnf_normalize(terms, count);
+                if (count > dnf->max_terms) {
+                    free(terms);
+                    return NULL;
+                }
+            }
+            terms[count].length = length;
+            terms[count].literals = wff_arena_alloc(dnf->arena, length);
+            memcpy(terms[count].literals, scratch, length);
+            count++;
+        }
+    }
+    count = _wff_dnf_normalize(terms, count);
+    WffDnfTerms* result = count > dnf->max_terms ? NULL : _wff_dnf_store(dnf, terms, count);
+    free(terms);
+    return result;
+}
+
+// Writes the union of two sorted conjunctions to 'out'. Returns false if it
+// has a literal and its negation, which makes it a contradiction.
+bool _wff_dnf_merge(WffDnfTerm* left, WffDnfTerm* right, uint8_t* out, size_t* length) {
+    size_t i = 0;
+    size_t j = 0;
+    *length = 0;
+    while (i < left->length || j < right->length) {
+        uint8_t literal;
+        if (j == right->length || (i < left->length && left->literals[i] <= right->literals[j])) {
+            literal = left->literals[i++];
+            if (j < right->length && right->literals[j] == literal) {
+                j++;
+            }
+        } else {
+            literal = right->literals[j++];
+        }
+        // A variable's two literals sort next to each other.
+        if (*length > 0 && (out[*length - 1] ^ 1) == literal) {
+            return false;
+        }
+        out[(*length)++] = literal;
+    }
+    return true;
+}
+
+// Sorts the conjunctions, shortest first, and drops repeats. Returns how many
+// are left.
+size_t _wff_dnf_normalize(WffDnfTerm* terms, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    qsort(terms, count, sizeof(WffDnfTerm), _wff_dnf_compare_terms);
+    size_t kept = 1;
+    for (size_t i = 1; i < count; i++) {
+        if (_wff_dnf_compare_terms(&terms[i], &terms[kept - 1]) != 0) {
+            terms[kept++] = terms[i];
+        }
+    }
+    return kept;
+}
+
+int _wff_dnf_compare_terms(const void* a, const void* b) {
+    const WffDnfTerm* term1 = a;
+    const WffDnfTerm* term2 = b;
+    if (term1->length != term2->length) {
+        return term1->length < term2->length ? -1 : 1;
+    }
+    return term1->length == 0 ? 0 : memcmp(term1->literals, term2->literals, term1->length);
+}
+
+WffDnfTerms* _wff_dnf_store(WffDnf* dnf, WffDnfTerm* terms, size_t count) {
+    WffDnfTerms* stored = wff_arena_alloc(dnf->arena, sizeof(WffDnfTerms));
+    stored->count = count;
+    stored->terms = wff_arena_alloc(dnf->arena, (count + 1) * sizeof(WffDnfTerm));
+    memcpy(stored->terms, terms, count * sizeof(WffDnfTerm));
+    return stored;
+}
+
+// Builds the disjunction of the conjunctions, each nested to the left, and
+// writes how many propositions it has to 'count'.
+WffParseTreeNode* _wff_dnf_build(WffDnf* dnf, WffNnf* nnf, WffDnfTerms* terms, size_t* count) {
+    *count = 0;
+    // The empty conjunction sorts first, and makes the whole disjunction T.
+    if (terms->count == 0 || terms->terms[0].length == 0) {
+        return _wff_nnf_constant(nnf, terms->count > 0);
+    }
+    WffParseTreeNode* result = NULL;
+    for (size_t i = 0; i < terms->count; i++) {
+        WffDnfTerm* term = &terms->terms[i];
+        WffParseTreeNode* conjunction = dnf->literals[term->literals[0]];
+        for (size_t k = 1; k < term->length; k++) {
+            conjunction = _wff_nnf_binary(nnf, conjunction, nnf->and, dnf->literals[term->literals[k]]);
+        }
+        *count += term->length;
+        result = result == NULL ? conjunction : _wff_nnf_binary(nnf, result, nnf->or, conjunction);
+    }
+    return result;
+}
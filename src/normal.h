@@ -0,0 +1,35 @@
+#ifndef NORMAL_H_
+#define NORMAL_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "sat.h"
+
+
+// Conversions to normal forms, each in one pass over the hash-consed parse
+// tree, so a subwff shared by several parts of a wff is converted once.
+//
+// The wffs returned share nodes with 'wff' (see wff_rewrite), which is left
+// as it is; the caller destroys them.
+
+// Negation normal form: only ~, ^ and v, with ~ only in front of variables.
+// Conditionals and biconditionals are expanded, a biconditional using each of
+// its operands both ways; both ways are built once per subwff, so the result
+// takes at most four nodes per node of 'wff', however the string grows.
+Wff* wff_normal_nnf(Wff* wff);
+
+// A CNF that is satisfiable iff 'wff' is, with the Plaisted-Greenbaum
+// encoding (see WffTseitin): linear in the size of the hash-consed tree.
+// Variables 1 to n are the letters of 'wff' in alphabetical order (a to z,
+// then A to Z) and the rest stand for its subwffs. The caller destroys it.
+WffCnf* wff_normal_cnf(Wff* wff);
+
+// Disjunctive normal form: a disjunction of conjunctions of literals, each
+// listing its variables in alphabetical order, shortest first. Contradictory
+// and repeated conjunctions are left out. Returns NULL if it takes more than
+// 'max_terms' conjunctions.
+Wff* wff_normal_dnf(Wff* wff, size_t max_terms);
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef NORMAL_INTERNAL_H_
+#define NORMAL_INTERNAL_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic_internal.h"
+#include "sat_internal.h"
+#include "normal.h"
+
+typedef struct WffNnf WffNnf;
+typedef struct WffNnfEntry WffNnfEntry;
+typedef struct WffDnf WffDnf;
+typedef struct WffDnfTerm WffDnfTerm;
+typedef struct WffDnfTerms WffDnfTerms;
+
+// Literals of a DNF are numbered 2 * ID for a variable and 2 * ID + 1 for its
+// negation, so sorting them groups them by variable in alphabetical order.
+#define WFF_DNF_LITERAL_COUNT (2 * WFF_VARIABLE_COUNT)
+
+
+/* === WffNnf === */
+// Builds the NNF of subwffs, and of their negations, in a node table. Both
+// are remembered for every subwff converted, keyed by its node in a node map,
+// along with the number of propositions in each.
+struct WffNnf {
+    WffNodeTable* nodes;
+    WffNodeMap entries;
+    // Terminals the NNF is built from.
+    WffParseTreeNode* lparen;
+    WffParseTreeNode* rparen;
+    WffParseTreeNode* not;
+    WffParseTreeNode* and;
+    WffParseTreeNode* or;
+};
+
+struct WffNnfEntry {
+    // Indexed by whether the subwff is negated; NULL until built.
+    WffParseTreeNode* results[2];
+    size_t counts[2];
+};
+
+void _wff_nnf_init(WffNnf* nnf, WffNodeTable* nodes);
+void _wff_nnf_finish(WffNnf* nnf);
+WffParseTreeNode* _wff_nnf(WffNnf* nnf, WffParseTreeNode* node, bool negated, size_t* count);
+WffParseTreeNode* _wff_nnf_convert(WffNnf* nnf, WffParseTreeNode* node, bool negated, size_t* count);
+WffParseTreeNode* _wff_nnf_binary(WffNnf* nnf, WffParseTreeNode* left, WffParseTreeNode* operator, WffParseTreeNode* right);
+WffParseTreeNode* _wff_nnf_not(WffNnf* nnf, WffParseTreeNode* operand);
+WffParseTreeNode* _wff_nnf_constant(WffNnf* nnf, bool value);
+WffParseTreeNode* _wff_nnf_terminal(WffNnf* nnf, WffToken token);
+
+
+/* === WffDnf === */
+// Expands an NNF into sets of conjunctions, distributing ^ over v from the
+// leaves up. The set for each subwff is kept, sorted and without repeats,
+// keyed by its node, so shared subwffs are expanded once. Conjunctions are
+// sorted arrays of literals, allocated in 'arena' along with the sets.
+struct WffDnf {
+    WffArena* arena;
+    // Set of conjunctions of each subwff expanded.
+    WffNodeMap terms;
+    size_t max_terms;
+    // Node of each literal seen, to build the result from.
+    WffParseTreeNode* literals[WFF_DNF_LITERAL_COUNT];
+};
+
+struct WffDnfTerm {
+    size_t length;
+    uint8_t* literals;
+};
+
+struct WffDnfTerms {
+    size_t count;
+    WffDnfTerm* terms;
+};
+
+WffDnfTerms* _wff_dnf(WffDnf* dnf, WffParseTreeNode* node);
+WffDnfTerms* _wff_dnf_leaf(WffDnf* dnf, WffParseTreeNode* node);
+WffDnfTerms* _wff_dnf_union(WffDnf* dnf, WffDnfTerms* left, WffDnfTerms* right);
+WffDnfTerms* _wff_dnf_product(WffDnf* dnf, WffDnfTerms* left, WffDnfTerms* right);
+bool _wff_dnf_merge(WffDnfTerm* left, WffDnfTerm* right, uint8_t* out, size_t* length);
+size_t _wff_dnf_normalize(WffDnfTerm* terms, size_t count);
+int _wff_dnf_compare_terms(const void* a, const void* b);
+WffDnfTerms* _wff_dnf_store(WffDnf* dnf, WffDnfTerm* terms, size_t count);
+WffParseTreeNode* _wff_dnf_build(WffDnf* dnf, WffNnf* nnf, WffDnfTerms* terms, size_t* count);
+
+void _wff_normal_mark_variables(WffParseTreeNode* node, WffNodeMap* seen, bool* present);
+
+#endif
@@ -0,0 +1,411 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "preview.h"
+#include "preview_internal.h"
+
+// Initial capacity of the text and token buffers.
+#define WFF_PREVIEW_MIN_CAPACITY 64
+// Table size under which nodes of replaced trees are never dropped.
+#define WFF_PREVIEW_MIN_NODES 1024
+// Characters the lexer may look at from the start of a token ("<=>").
+#define WFF_PREVIEW_LOOKAHEAD 3
+
+// Stands for a character that doesn't start a token, so that every line has
+// a token stream even if it doesn't parse.
+WffToken WFF_PREVIEW_BAD_TOKEN = {.type = WTT_NONE};
+
+
+/* === WffPreview === */
+
+WffPreview* wff_preview_create(const char* string) {
+    WffPreview* preview = malloc(sizeof(WffPreview));
+    preview->text_capacity = WFF_PREVIEW_MIN_CAPACITY;
+    preview->text = malloc(preview->text_capacity * sizeof(char));
+    preview->text_gap = 0;
+    preview->text_gap_end = preview->text_capacity;
+
+    preview->token_capacity = WFF_PREVIEW_MIN_CAPACITY;
+    preview->tokens = malloc(preview->token_capacity * sizeof(WffPreviewToken));
+    preview->token_gap = 0;
+    preview->token_gap_end = preview->token_capacity;
+    preview->compact_length = 0;
+    memset(preview->counts, 0, sizeof(preview->counts));
+
+    preview->arena = wff_arena_create();
+    preview->nodes = wff_node_table_create(preview->arena);
+    preview->compact_at = WFF_PREVIEW_MIN_NODES;
+    preview->root = NULL;
+    preview->valid = false;
+    preview->damaged = false;
+    preview->path = NULL;
+    preview->path_capacity = 0;
+
+    wff_preview_edit(preview, 0, 0, string);
+    return preview;
+}
+
+void wff_preview_destroy(WffPreview* preview) {
+    wff_arena_destroy(preview->arena);
+    free(preview->text);
+    free(preview->tokens);
+    free(preview->path);
+    free(preview);
+}
+
+// Replaces 'removed' characters at 'offset' (both clamped to the text) with
+// 'inserted'. Returns whether the line is a wff now.
+bool wff_preview_edit(WffPreview* preview, size_t offset, size_t removed, const char* inserted) {
+    size_t text_length = _wff_preview_text_length(preview);
+    if (offset > text_length) {
+        offset = text_length;
+    }
+    if (removed > text_length - offset) {
+        removed = text_length - offset;
+    }
+
+    // Tokens that start far enough before the edit were lexed without looking
+    // at any character it changes.
+    size_t first = _wff_preview_token_at_offset(preview, offset >= WFF_PREVIEW_LOOKAHEAD ? offset - (WFF_PREVIEW_LOOKAHEAD - 1) : 0);
+    _wff_preview_token_move_gap(preview, first);
+    _wff_preview_text_edit(preview, offset, removed, inserted);
+    _wff_preview_relex(preview, offset + strlen(inserted));
+
+    preview->valid = _wff_preview_may_parse(preview) && _wff_preview_reparse(preview);
+    if (preview->nodes->count > preview->compact_at) {
+        _wff_preview_compact(preview);
+    }
+    return preview->valid;
+}
+
+bool wff_preview_is_valid(WffPreview* preview) {
+    return preview->valid;
+}
+
+size_t wff_preview_length(WffPreview* preview) {
+    return _wff_preview_text_length(preview);
+}
+
+// Returns the line as typed, which the caller frees.
+char* wff_preview_string(WffPreview* preview) {
+    size_t tail = preview->text_capacity - preview->text_gap_end;
+    char* string = malloc((preview->text_gap + tail + 1) * sizeof(char));
+    memcpy(string, preview->text, preview->text_gap);
+    memcpy(string + preview->text_gap, preview->text + preview->text_gap_end, tail);
+    string[preview->text_gap + tail] = '\0';
+    return string;
+}
+
+// Returns the wff as wff_create would print it, which the caller frees, or
+// NULL if the line isn't a wff.
+char* wff_preview_render(WffPreview* preview) {
+    return preview->valid ? wff_parse_tree_get_subwff_string(preview->root) : NULL;
+}
+
+size_t _wff_preview_text_length(WffPreview* preview) {
+    return preview->text_capacity - (preview->text_gap_end - preview->text_gap);
+}
+
+// Returns '\0' past the end of the text.
+char _wff_preview_char(WffPreview* preview, size_t offset) {
+    if (offset < preview->text_gap) {
+        return preview->text[offset];
+    }
+    offset += preview->text_gap_end - preview->text_gap;
+    return offset < preview->text_capacity ? preview->text[offset] : '\0';
+}
+
+void _wff_preview_text_edit(WffPreview* preview, size_t offset, size_t removed, const char* inserted) {
+    if (offset < preview->text_gap) {
+        size_t count = preview->text_gap - offset;
+        memmove(preview->text + preview->text_gap_end - count, preview->text + offset, count);
+        preview->text_gap -= count;
+        preview->text_gap_end -= count;
+    } else if (offset > preview->text_gap) {
+        size_t count = offset - preview->text_gap;
+        memmove(preview->text + preview->text_gap, preview->text + preview->text_gap_end, count);
+        preview->text_gap += count;
+        preview->text_gap_end += count;
+    }
+    preview->text_gap_end += removed;
+
+    size_t length = strlen(inserted);
+    if (preview->text_gap_end - preview->text_gap < length) {
+        size_t tail = preview->text_capacity - preview->text_gap_end;
+        size_t capacity = preview->text_capacity * 2;
+        if (capacity < preview->text_gap + length + tail) {
+            capacity = preview->text_gap + length + tail;
+        }
+        preview->text = realloc(preview->text, capacity * sizeof(char));
+        memmove(preview->text + capacity - tail, preview->text + preview->text_gap_end, tail);
+        preview->text_gap_end = capacity - tail;
+        preview->text_capacity = capacity;
+    }
+    memcpy(preview->text + preview->text_gap, inserted, length);
+    preview->text_gap += length;
+}
+
+size_t _wff_preview_token_count(WffPreview* preview) {
+    return preview->token_capacity - (preview->token_gap_end - preview->token_gap);
+}
+
+WffPreviewToken* _wff_preview_token(WffPreview* preview, size_t index) {
+    if (index >= preview->token_gap) {
+        index += preview->token_gap_end - preview->token_gap;
+    }
+    return &preview->tokens[index];
+}
+
+size_t _wff_preview_token_offset(WffPreview* preview, size_t index) {
+    WffPreviewToken* token = _wff_preview_token(preview, index);
+    return index < preview->token_gap ? token->offset : _wff_preview_text_length(preview) - token->offset;
+}
+
+size_t _wff_preview_token_position(WffPreview* preview, size_t index) {
+    WffPreviewToken* token = _wff_preview_token(preview, index);
+    return index < preview->token_gap ? token->position : preview->compact_length - token->position;
+}
+
+// Index of the first token at or after 'offset' in the text.
+size_t _wff_preview_token_at_offset(WffPreview* preview, size_t offset) {
+    size_t low = 0;
+    size_t high = _wff_preview_token_count(preview);
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (_wff_preview_token_offset(preview, middle) < offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Index of the first token at or after 'position' in the line without spaces.
+size_t _wff_preview_token_at_position(WffPreview* preview, size_t position) {
+    size_t low = 0;
+    size_t high = _wff_preview_token_count(preview);
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (_wff_preview_token_position(preview, middle) < position) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Moves the token gap to just before token 'index', switching each token it
+// passes between counting from the start and from the end.
+void _wff_preview_token_move_gap(WffPreview* preview, size_t index) {
+    size_t text_length = _wff_preview_text_length(preview);
+    while (preview->token_gap > index) {
+        WffPreviewToken* token = &preview->tokens[--preview->token_gap_end];
+        *token = preview->tokens[--preview->token_gap];
+        token->offset = text_length - token->offset;
+        token->position = preview->compact_length - token->position;
+    }
+    while (preview->token_gap < index) {
+        WffPreviewToken* token = &preview->tokens[preview->token_gap++];
+        *token = preview->tokens[preview->token_gap_end++];
+        token->offset = text_length - token->offset;
+        token->position = preview->compact_length - token->position;
+    }
+}
+
+void _wff_preview_token_push(WffPreview* preview, WffToken* token, size_t offset, size_t position, size_t length) {
+    if (preview->token_gap == preview->token_gap_end) {
+        size_t tail = preview->token_capacity - preview->token_gap_end;
+        size_t capacity = preview->token_capacity * 2;
+        preview->tokens = realloc(preview->tokens, capacity * sizeof(WffPreviewToken));
+        memmove(preview->tokens + capacity - tail, preview->tokens + preview->token_gap_end, tail * sizeof(WffPreviewToken));
+        preview->token_gap_end = capacity - tail;
+        preview->token_capacity = capacity;
+    }
+    preview->tokens[preview->token_gap++] = (WffPreviewToken) {.token = token, .offset = offset, .position = position, .length = length};
+    _wff_preview_count(preview, token, true);
+}
+
+void _wff_preview_count(WffPreview* preview, WffToken* token, bool add) {
+    WffPreviewClass class;
+    switch (token->type) {
+        case WTT_PROPOSITION:
+        case WTT_CONSTANT:
+            class = WPC_ATOM;
+            break;
+        case WTT_OPERATOR:
+            class = token->operator == WO_NOT ? WPC_NOT : WPC_BINARY;
+            break;
+        case WTT_LPAREN:
+            class = WPC_LPAREN;
+            break;
+        case WTT_RPAREN:
+            class = WPC_RPAREN;
+            break;
+        default:
+            class = WPC_BAD;
+    }
+    if (add) {
+        preview->counts[class]++;
+    } else {
+        preview->counts[class]--;
+    }
+}
+
+// Lexes the text from the token gap on, dropping the old tokens the new ones
+// overlap, until past 'edit_end' the text lines up with an old token again.
+// Everything from there on lexes as it did before.
+void _wff_preview_relex(WffPreview* preview, size_t edit_end) {
+    size_t text_length = _wff_preview_text_length(preview);
+    size_t offset = 0;
+    size_t position = 0;
+    if (preview->token_gap > 0) {
+        WffPreviewToken* last = &preview->tokens[preview->token_gap - 1];
+        offset = last->offset + last->length;
+        position = last->position + last->length;
+    }
+    size_t start = position;
+    size_t dropped = 0;
+
+    for (;;) {
+        while (_wff_preview_char(preview, offset) == ' ') {
+            offset++;
+        }
+        // Old tokens after the gap count their offsets from the end, which the
+        // edit didn't move.
+        while (preview->token_gap_end < preview->token_capacity && preview->tokens[preview->token_gap_end].offset > text_length - offset) {
+            WffPreviewToken* old = &preview->tokens[preview->token_gap_end++];
+            dropped += old->length;
+            _wff_preview_count(preview, old->token, false);
+        }
+        if (offset >= edit_end && preview->token_gap_end < preview->token_capacity
+                && preview->tokens[preview->token_gap_end].offset == text_length - offset) {
+            break;
+        }
+        if (offset >= text_length) {
+            break;
+        }
+
+        char window[WFF_PREVIEW_LOOKAHEAD + 1];
+        for (size_t i = 0; i < WFF_PREVIEW_LOOKAHEAD; i++) {
+            window[i] = _wff_preview_char(preview, offset + i);
+        }
+        window[WFF_PREVIEW_LOOKAHEAD] = '\0';
+        const char* cursor = window;
+        WffToken* token = _wff_lex(&cursor);
+        size_t length = token != NULL ? (size_t) (cursor - window) : 1;
+        _wff_preview_token_push(preview, token != NULL ? token : &WFF_PREVIEW_BAD_TOKEN, offset, position, length);
+        offset += length;
+        position += length;
+    }
+
+    // Positions after the gap count from the end too, so they stay put.
+    preview->compact_length = preview->compact_length - dropped + (position - start);
+    size_t tail = preview->compact_length - position;
+    if (!preview->damaged || start < preview->damage_start) {
+        preview->damage_start = start;
+    }
+    if (!preview->damaged || tail < preview->damage_tail) {
+        preview->damage_tail = tail;
+    }
+    preview->damaged = true;
+}
+
+// Whether the token counts allow a wff: every binary operator comes with a
+// pair of parentheses and joins two operands.
+bool _wff_preview_may_parse(WffPreview* preview) {
+    size_t* counts = preview->counts;
+    return counts[WPC_BAD] == 0 && counts[WPC_LPAREN] == counts[WPC_BINARY] && counts[WPC_RPAREN] == counts[WPC_BINARY]
+        && counts[WPC_ATOM] == counts[WPC_BINARY] + 1;
+}
+
+// Parses the smallest subwff of the last tree that contains the damage again,
+// and puts it in place of the old one. If it no longer parses on its own, the
+// whole line is parsed, since the damage may have moved the boundaries of the
+// subwffs around it.
+bool _wff_preview_reparse(WffPreview* preview) {
+    WffParseTreeNode* node = preview->root;
+    size_t start = 0;
+    size_t length = preview->compact_length;
+    size_t depth = 0;
+    if (node != NULL) {
+        size_t damage_end = preview->root->length - preview->damage_tail;
+        bool descended = true;
+        while (descended) {
+            descended = false;
+            size_t child_start = start;
+            for (int i = 0; i < node->child_count; i++) {
+                WffParseTreeNode* child = node->children[i];
+                if (child->type == WPTNT_NONTERMINAL && child_start <= preview->damage_start && damage_end <= child_start + child->length) {
+                    if (depth == preview->path_capacity) {
+                        preview->path_capacity = preview->path_capacity == 0 ? 16 : preview->path_capacity * 2;
+                        preview->path = realloc(preview->path, preview->path_capacity * sizeof(WffPreviewStep));
+                    }
+                    preview->path[depth++] = (WffPreviewStep) {.node = node, .child = i};
+                    node = child;
+                    start = child_start;
+                    descended = true;
+                    break;
+                }
+                child_start += child->length;
+            }
+        }
+        // Everything outside the subwff is as long as it was.
+        length = node->length + preview->compact_length - preview->root->length;
+    }
+
+    WffParseTreeNode* replacement = _wff_preview_parse(preview, start, start + length);
+    if (replacement == NULL && depth > 0) {
+        depth = 0;
+        replacement = _wff_preview_parse(preview, 0, preview->compact_length);
+    }
+    if (replacement == NULL) {
+        return false;
+    }
+    while (depth > 0) {
+        WffPreviewStep* step = &preview->path[--depth];
+        WffParseTreeNode copy = *step->node;
+        copy.children[step->child] = replacement;
+        replacement = _wff_parse_tree_node_create(preview->nodes, &copy);
+    }
+    preview->root = replacement;
+    preview->damaged = false;
+    return true;
+}
+
+// Parses the tokens in [start, end) of the line without spaces, which must be
+// exactly one wff.
+WffParseTreeNode* _wff_preview_parse(WffPreview* preview, size_t start, size_t end) {
+    WffPreviewCursor cursor = {.preview = preview, .index = _wff_preview_token_at_position(preview, start), .end = end};
+    WffTokenReader reader = {.next = _wff_preview_cursor_next, .source = &cursor};
+    WffParseTreeNode* node = _wff_parse(&reader, preview->nodes);
+    return node != NULL && _wff_token_reader_done(&reader) ? node : NULL;
+}
+
+WffToken* _wff_preview_cursor_next(void* source) {
+    WffPreviewCursor* cursor = source;
+    if (cursor->index == _wff_preview_token_count(cursor->preview) || _wff_preview_token_position(cursor->preview, cursor->index) >= cursor->end) {
+        return NULL;
+    }
+    return _wff_preview_token(cursor->preview, cursor->index++)->token;
+}
+
+// Moves the last tree into a fresh table, leaving behind the nodes of the
+// trees it replaced and of attempts that didn't parse.
+void _wff_preview_compact(WffPreview* preview) {
+    WffArena* arena = wff_arena_create();
+    WffNodeTable* nodes = wff_node_table_create(arena);
+    if (preview->root != NULL) {
+        WffParseTreeNode* bindings[WFF_VARIABLE_COUNT] = {NULL};
+        preview->root = _wff_instantiate(nodes, preview->root, bindings);
+    }
+    wff_arena_destroy(preview->arena);
+    preview->arena = arena;
+    preview->nodes = nodes;
+    preview->compact_at = nodes->count * 2 + WFF_PREVIEW_MIN_NODES;
+}
@@ -0,0 +1,24 @@
+#ifndef PREVIEW_H_
+#define PREVIEW_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "logic.h"
+
+
+typedef struct WffPreview WffPreview;
+
+
+// A line being typed, parsed again after every edit. Only the tokens around
+// an edit are lexed again, and only the smallest subwff that contained it is
+// parsed again, so an edit costs about the same however long the line is.
+WffPreview* wff_preview_create(const char* string);
+void wff_preview_destroy(WffPreview* preview);
+bool wff_preview_edit(WffPreview* preview, size_t offset, size_t removed, const char* inserted);
+bool wff_preview_is_valid(WffPreview* preview);
+size_t wff_preview_length(WffPreview* preview);
+char* wff_preview_string(WffPreview* preview);
+char* wff_preview_render(WffPreview* preview);
+
+#endif
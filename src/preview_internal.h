@@ -0,0 +1,111 @@
+#ifndef PREVIEW_INTERNAL_H_
+#define PREVIEW_INTERNAL_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "logic_internal.h"
+#include "preview.h"
+
+typedef struct WffPreviewToken WffPreviewToken;
+typedef struct WffPreviewCursor WffPreviewCursor;
+typedef struct WffPreviewStep WffPreviewStep;
+
+// Classes of tokens counted to rule out most unfinished lines without
+// parsing them.
+typedef enum {
+    WPC_ATOM,
+    WPC_NOT,
+    WPC_BINARY,
+    WPC_LPAREN,
+    WPC_RPAREN,
+    WPC_BAD,
+    WPC_COUNT
+} WffPreviewClass;
+
+
+/* === WffPreview === */
+// The text and its tokens are each kept in a gap buffer whose gap follows the
+// edits, so typing in one place moves nothing. Tokens before the token gap
+// hold their offset in the text and their position (see below) from the
+// start, and tokens after it hold them from the end, so an edit doesn't have
+// to shift the tokens that follow it.
+//
+// A token's position is where it starts in the line with the spaces left out,
+// which is also where it starts in the rendered parse tree, so the cached
+// lengths of parse tree nodes locate any subwff among the tokens.
+//
+// 'root' is the tree of the last text that parsed. Tokens that have changed
+// since are the damage: they took the place of positions [damage_start,
+// root->length - damage_tail) of the tree and now fill [damage_start,
+// compact_length - damage_tail). The smallest subwff of the tree around the
+// damage is parsed again on its own, and if that works the rest of the tree
+// still holds, so the new subwff is put in its place.
+struct WffPreview {
+    char* text;
+    size_t text_capacity;
+    size_t text_gap;
+    size_t text_gap_end;
+
+    WffPreviewToken* tokens;
+    size_t token_capacity;
+    size_t token_gap;
+    size_t token_gap_end;
+    size_t compact_length;
+    size_t counts[WPC_COUNT];
+
+    WffArena* arena;
+    WffNodeTable* nodes;
+    // Node count past which nodes of replaced trees are dropped.
+    size_t compact_at;
+    WffParseTreeNode* root;
+    bool valid;
+    bool damaged;
+    size_t damage_start;
+    size_t damage_tail;
+    // Path from the root to the subwff being parsed again.
+    WffPreviewStep* path;
+    size_t path_capacity;
+};
+
+struct WffPreviewToken {
+    // A canonical token, or WFF_PREVIEW_BAD_TOKEN for a character that doesn't
+    // start one.
+    WffToken* token;
+    size_t offset;
+    size_t position;
+    size_t length;
+};
+
+struct WffPreviewStep {
+    WffParseTreeNode* node;
+    int child;
+};
+
+// Reads the tokens from 'index' up to position 'end' for _wff_parse.
+struct WffPreviewCursor {
+    WffPreview* preview;
+    size_t index;
+    size_t end;
+};
+
+size_t _wff_preview_text_length(WffPreview* preview);
+char _wff_preview_char(WffPreview* preview, size_t offset);
+void _wff_preview_text_edit(WffPreview* preview, size_t offset, size_t removed, const char* inserted);
+size_t _wff_preview_token_count(WffPreview* preview);
+WffPreviewToken* _wff_preview_token(WffPreview* preview, size_t index);
+size_t _wff_preview_token_offset(WffPreview* preview, size_t index);
+size_t _wff_preview_token_position(WffPreview* preview, size_t index);
+size_t _wff_preview_token_at_offset(WffPreview* preview, size_t offset);
+size_t _wff_preview_token_at_position(WffPreview* preview, size_t position);
+void _wff_preview_token_move_gap(WffPreview* preview, size_t index);
+void _wff_preview_token_push(WffPreview* preview, WffToken* token, size_t offset, size_t position, size_t length);
+void _wff_preview_count(WffPreview* preview, WffToken* token, bool add);
+void _wff_preview_relex(WffPreview* preview, size_t edit_end);
+bool _wff_preview_may_parse(WffPreview* preview);
+bool _wff_preview_reparse(WffPreview* preview);
+WffParseTreeNode* _wff_preview_parse(WffPreview* preview, size_t start, size_t end);
+WffToken* _wff_preview_cursor_next(void* source);
+void _wff_preview_compact(WffPreview* preview);
+
+#endif
@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <ctype.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "rules.h"
+#include "proof.h"
+#include "proof_internal.h"
+#include "stats_internal.h"
+#include "vector.h"
+
+const WffOperator WFF_PROOF_LEVELS[WFF_PROOF_LEVEL_COUNT] = {WO_BICOND, WO_COND, WO_OR, WO_AND};
+
+
+/* === WffProof === */
+
+// Checks the proof in 'text' line by line, verifying each step with the rule
+// it cites. Checking stops at the first line that is wrong, which 'report'
+// describes along with the outcome.
+WffProofStatus wff_proof_check(const char* text, WffRuleIndex* index, WffProofReport* report) {
+    WFF_STATS_BEGIN(WSTP_CHECK);
+    report->status = WPS_VALID;
+    report->line_count = 0;
+    report->line = 0;
+    report->message[0] = '\0';
+
+    WffProof proof;
+    proof.goal = NULL;
+    wff_vector_init(&proof.lines, sizeof(Wff*), NULL);
+
+    char* copy = strdup(text);
+    bool ok = true;
+    char* save;
+    for (char* line = strtok_r(copy, "\n", &save); ok && line != NULL; line = strtok_r(NULL, "\n", &save)) {
+        ok = _wff_proof_read_line(&proof, line, index, report);
+    }
+    free(copy);
+
+    if (ok && proof.goal == NULL) {
+        _wff_proof_fail(report, WPS_MALFORMED, 0, "no PROVE line");
+    } else if (ok && wff_vector_length(&proof.lines) == 0) {
+        _wff_proof_fail(report, WPS_INCOMPLETE, 0, "no proof lines");
+    } else if (ok) {
+        WffParseTreeNode* consequent = proof.goal->parse_tree->root->children[3];
+        Wff* last = *(Wff**) wff_vector_get(&proof.lines, wff_vector_length(&proof.lines) - 1);
+        if (!wff_parse_tree_subtree_equals(consequent, last->parse_tree->root)) {
+            _wff_proof_fail(report, WPS_INCOMPLETE, 0, "last line isn't the consequent of the goal");
+        }
+    }
+    report->line_count = wff_vector_length(&proof.lines);
+
+    if (proof.goal != NULL) {
+        wff_destroy(proof.goal);
+    }
+    WffVectorIterator iterator = wff_vector_iterate(&proof.lines);
+    for (Wff** line = wff_vector_iterator_next(&iterator); line != NULL; line = wff_vector_iterator_next(&iterator)) {
+        wff_destroy(*line);
+    }
+    wff_vector_finish(&proof.lines);
+    WFF_STATS_END(WSTP_CHECK);
+    return report->status;
+}
+
+const char* wff_proof_status_string(WffProofStatus status) {
+    switch (status) {
+        case WPS_VALID:
+            return "valid";
+        case WPS_INCOMPLETE:
+            return "incomplete";
+        case WPS_INVALID:
+            return "invalid";
+        case WPS_MALFORMED:
+            return "malformed";
+        case WPS_UNREADABLE:
+            return "unreadable";
+    }
+    return NULL;
+}
+
+// Handles one line of text. Returns false once the proof has failed.
+bool _wff_proof_read_line(WffProof* proof, char* line, WffRuleIndex* index, WffProofReport* report) {
+    line = _wff_proof_trim(line);
+    // Code fences, command prompts and the end of an interactive session.
+    if (*line == '\0' || strncmp(line, "```", 3) == 0 || *line == '>' || strcmp(line, "PROOF DONE") == 0) {
+        return true;
+    }
+
+    if (strncmp(line, "PROVE ", 6) == 0) {
+        if (proof->goal != NULL) {
+            _wff_proof_fail(report, WPS_MALFORMED, 0, "more than one PROVE line");
+            return false;
+        }
+        char* string = wff_proof_normalize(line + 6);
+        if (string == NULL) {
+            _wff_proof_fail(report, WPS_MALFORMED, 0, "goal isn't a wff");
+            return false;
+        }
+        proof->goal = wff_create(string);
+        free(string);
+        WffParseTreeNode* root = proof->goal->parse_tree->root;
+        if (root->child_count != 5 || root->children[2]->token->operator != WO_COND) {
+            _wff_proof_fail(report, WPS_MALFORMED, 0, "a direct proof needs a conditional goal");
+            return false;
+        }
+        return true;
+    }
+
+    if (*line == '(') {
+        if (strcasecmp(line, "(Direct Proof)") != 0) {
+            _wff_proof_fail(report, WPS_MALFORMED, 0, "unsupported proof method %s", line);
+            return false;
+        }
+        return true;
+    }
+
+    if (isdigit((unsigned char) *line)) {
+        char* end;
+        size_t number = strtoul(line, &end, 10);
+        if (*end != '.') {
+            _wff_proof_fail(report, WPS_MALFORMED, 0, "expected '.' after line number %zu", number);
+            return false;
+        }
+        char* body = _wff_proof_trim(end + 1);
+        // The next line of an unfinished session, possibly showing a preview.
+        if (*body == '\0' || *body == '[') {
+            return true;
+        }
+        if (proof->goal == NULL) {
+            _wff_proof_fail(report, WPS_MALFORMED, number, "proof line before the PROVE line");
+            return false;
+        }
+        if (number != wff_vector_length(&proof->lines) + 1) {
+            _wff_proof_fail(report, WPS_MALFORMED, number, "expected line %zu", wff_vector_length(&proof->lines) + 1);
+            return false;
+        }
+        return _wff_proof_check_step(proof, number, body, index, report);
+    }
+
+    _wff_proof_fail(report, WPS_MALFORMED, 0, "unexpected line");
+    return false;
+}
+
+// Checks a numbered line, "<wff> (<justification>)", where the justification
+// is "hypothesis" or a rule and the earlier line it was applied to.
+bool _wff_proof_check_step(WffProof* proof, size_t number, char* body, WffRuleIndex* index, WffProofReport* report) {
+    // The justification is the parenthesized group that ends the line.
+    size_t length = strlen(body);
+    char* open = NULL;
+    if (length > 0 && body[length - 1] == ')') {
+        size_t depth = 0;
+        for (char* c = body + length - 1; c >= body; c--) {
+            if (*c == ')') {
+                depth++;
+            } else if (*c == '(' && --depth == 0) {
+                open = c;
+                break;
+            }
+        }
+    }
+    if (open == NULL || open == body) {
+        _wff_proof_fail(report, WPS_MALFORMED, number, "missing justification");
+        return false;
+    }
+    body[length - 1] = '\0';
+    *open = '\0';
+    char* justification = _wff_proof_trim(open + 1);
+
+    char* string = wff_proof_normalize(body);
+    if (string == NULL) {
+        _wff_proof_fail(report, WPS_MALFORMED, number, "not a wff");
+        return false;
+    }
+    Wff* wff = wff_create(string);
+    free(string);
+    wff_vector_append(&proof->lines, &wff);
+
+    if (strcasecmp(justification, "hypothesis") == 0) {
+        WffParseTreeNode* antecedent = proof->goal->parse_tree->root->children[1];
+        if (!wff_parse_tree_subtree_equals(antecedent, wff->parse_tree->root)) {
+            _wff_proof_fail(report, WPS_INVALID, number, "hypothesis isn't the antecedent of the goal");
+            return false;
+        }
+        return true;
+    }
+
+    char name[16];
+    size_t cited;
+    int consumed = 0;
+    if (sscanf(justification, "%15[^ ,] , %zu %n", name, &cited, &consumed) != 2 || justification[consumed] != '\0') {
+        _wff_proof_fail(report, WPS_MALFORMED, number, "unrecognized justification");
+        return false;
+    }
+    const WffRule* rule = wff_rule_find(name);
+    if (rule == NULL) {
+        _wff_proof_fail(report, WPS_MALFORMED, number, "unknown rule %s", name);
+        return false;
+    }
+    if (cited == 0 || cited >= number) {
+        _wff_proof_fail(report, WPS_INVALID, number, "cites line %zu, which doesn't precede it", cited);
+        return false;
+    }
+    if (!wff_rule_verify(index, *(Wff**) wff_vector_get(&proof->lines, cited - 1), rule, wff, NULL)) {
+        _wff_proof_fail(report, WPS_INVALID, number, "%s doesn't give this line from line %zu", name, cited);
+        return false;
+    }
+    return true;
+}
+
+char* _wff_proof_trim(char* string) {
+    while (isspace((unsigned char) *string)) {
+        string++;
+    }
+    char* end = string + strlen(string);
+    while (end > string && isspace((unsigned char) end[-1])) {
+        end--;
+    }
+    *end = '\0';
+    return string;
+}
+
+void _wff_proof_fail(WffProofReport* report, WffProofStatus status, size_t line, const char* format, ...) {
+    report->status = status;
+    report->line = line;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(report->message, sizeof(report->message), format, args);
+    va_end(args);
+}
+
+
+/* === WffProofNormalizer === */
+
+char* wff_proof_normalize(const char* string) {
+    // Each binary operation takes at least two characters of the input (its
+    // operator and an operand) and comes out with at most six: spaces around
+    // the operator and a pair of parentheses.
+    size_t capacity = strlen(string) * 3 + 1;
+    WffProofNormalizer normalizer;
+    normalizer.cursor = string;
+    normalizer.out = malloc(capacity);
+    normalizer.length = 0;
+    normalizer.opens = calloc(capacity, sizeof(size_t));
+    normalizer.token = _wff_lex(&normalizer.cursor);
+
+    bool ok = _wff_proof_normalize_binary(&normalizer, 0);
+    // Whatever stopped the lexer must be the end of the string.
+    char* result = NULL;
+    if (ok && normalizer.token == NULL && *normalizer.cursor == '\0') {
+        result = malloc(capacity);
+        size_t length = 0;
+        for (size_t i = 0; i < normalizer.length; i++) {
+            memset(result + length, '(', normalizer.opens[i]);
+            length += normalizer.opens[i];
+            result[length++] = normalizer.out[i];
+        }
+        result[length] = '\0';
+    }
+    free(normalizer.opens);
+    free(normalizer.out);
+    return result;
+}
+
+bool _wff_proof_normalize_binary(WffProofNormalizer* normalizer, size_t level) {
+    if (level == WFF_PROOF_LEVEL_COUNT) {
+        return _wff_proof_normalize_unary(normalizer);
+    }
+    size_t start = normalizer->length;
+    if (!_wff_proof_normalize_binary(normalizer, level + 1)) {
+        return false;
+    }
+    WffOperator operator = WFF_PROOF_LEVELS[level];
+    while (normalizer->token != NULL && normalizer->token->type == WTT_OPERATOR && normalizer->token->operator == operator) {
+        _wff_proof_normalizer_emit(normalizer, " ");
+        _wff_proof_normalizer_emit(normalizer, wff_token_get_string(normalizer->token));
+        _wff_proof_normalizer_emit(normalizer, " ");
+        _wff_proof_normalizer_advance(normalizer);
+        // => groups to the right, everything else to the left.
+        bool right = operator == WO_COND;
+        if (!_wff_proof_normalize_binary(normalizer, right ? level : level + 1)) {
+            return false;
+        }
+        normalizer->opens[start]++;
+        _wff_proof_normalizer_emit(normalizer, ")");
+        if (right) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool _wff_proof_normalize_unary(WffProofNormalizer* normalizer) {
+    WffToken* token = normalizer->token;
+    if (token == NULL) {
+        return false;
+    }
+    switch (token->type) {
+        case WTT_OPERATOR:
+            if (token->operator != WO_NOT) {
+                return false;
+            }
+            _wff_proof_normalizer_emit(normalizer, wff_token_get_string(token));
+            _wff_proof_normalizer_advance(normalizer);
+            return _wff_proof_normalize_unary(normalizer);
+        case WTT_PROPOSITION:
+        case WTT_CONSTANT:
+            _wff_proof_normalizer_emit(normalizer, wff_token_get_string(token));
+            _wff_proof_normalizer_advance(normalizer);
+            return true;
+        case WTT_LPAREN:
+            // A binary operation inside comes out wrapped already, and
+            // anything else doesn't need to be.
+            _wff_proof_normalizer_advance(normalizer);
+            if (!_wff_proof_normalize_binary(normalizer, 0)) {
+                return false;
+            }
+            if (normalizer->token == NULL || normalizer->token->type != WTT_RPAREN) {
+                return false;
+            }
+            _wff_proof_normalizer_advance(normalizer);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void _wff_proof_normalizer_advance(WffProofNormalizer* normalizer) {
+    normalizer->token = _wff_lex(&normalizer->cursor);
+}
+
+void _wff_proof_normalizer_emit(WffProofNormalizer* normalizer, const char* string) {
+    size_t length = strlen(string);
+    memcpy(normalizer->out + normalizer->length, string, length);
+    normalizer->length += length;
+}
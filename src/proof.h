@@ -0,0 +1,53 @@
+#ifndef PROOF_H_
+#define PROOF_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "rules.h"
+
+
+typedef struct WffProofReport WffProofReport;
+
+typedef enum {
+    // Every step follows and the last line is the goal's consequent.
+    WPS_VALID,
+    // Every step follows but the goal isn't reached.
+    WPS_INCOMPLETE,
+    // A step doesn't follow from the line it cites.
+    WPS_INVALID,
+    // The text isn't a proof in the format of sample.md.
+    WPS_MALFORMED,
+    // The proof couldn't be read at all.
+    WPS_UNREADABLE
+} WffProofStatus;
+
+struct WffProofReport {
+    WffProofStatus status;
+    size_t line_count;
+    // Number of the offending proof line (0 if there is none) and what is
+    // wrong with it.
+    size_t line;
+    char message[128];
+};
+
+
+// Proofs are written the way sample.md shows them:
+//
+//     PROVE (p v q) ^ (p v ~q) => p
+//     (Direct Proof)
+//     1. (p v q) ^ (p v ~q)              (hypothesis)
+//     2. p v (q ^ ~q)                    (E14, 1)
+//
+// Lines of the interactive session around them (prompts, previews, "PROOF
+// DONE") are skipped.
+WffProofStatus wff_proof_check(const char* text, WffRuleIndex* index, WffProofReport* report);
+const char* wff_proof_status_string(WffProofStatus status);
+
+// Adds the parentheses that wffs in proofs may leave out, binding ~ tightest,
+// then ^, v, => (to the right) and <=>. Returns a new string for wff_create,
+// or NULL if 'string' isn't a wff even so.
+char* wff_proof_normalize(const char* string);
+
+#endif
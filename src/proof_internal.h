@@ -0,0 +1,53 @@
+#ifndef PROOF_INTERNAL_H_
+#define PROOF_INTERNAL_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "logic_internal.h"
+#include "rules.h"
+#include "proof.h"
+#include "vector.h"
+
+typedef struct WffProof WffProof;
+typedef struct WffProofNormalizer WffProofNormalizer;
+
+// Binary operators from the loosest to the tightest binding.
+#define WFF_PROOF_LEVEL_COUNT 4
+
+
+/* === WffProof === */
+// A proof being checked: its goal and the wffs of the lines so far, a Wff*
+// per line, where index i is line i + 1.
+struct WffProof {
+    Wff* goal;
+    WffVector lines;
+};
+
+bool _wff_proof_read_line(WffProof* proof, char* line, WffRuleIndex* index, WffProofReport* report);
+bool _wff_proof_check_step(WffProof* proof, size_t number, char* body, WffRuleIndex* index, WffProofReport* report);
+char* _wff_proof_trim(char* string);
+void _wff_proof_fail(WffProofReport* report, WffProofStatus status, size_t line, const char* format, ...);
+
+
+/* === WffProofNormalizer === */
+// Precedence climbing over the tokens of a wff, writing it back out with a
+// pair of parentheses around every binary operation. A binary operation is
+// only known to need its opening parenthesis once its right operand has been
+// read, so rather than shifting what follows, 'opens' counts the parentheses
+// due before each position of 'out', and they are written in one last pass.
+struct WffProofNormalizer {
+    const char* cursor;
+    // Next token, or NULL at the end of the string or at a bad character.
+    WffToken* token;
+    char* out;
+    size_t length;
+    size_t* opens;
+};
+
+bool _wff_proof_normalize_binary(WffProofNormalizer* normalizer, size_t level);
+bool _wff_proof_normalize_unary(WffProofNormalizer* normalizer);
+void _wff_proof_normalizer_advance(WffProofNormalizer* normalizer);
+void _wff_proof_normalizer_emit(WffProofNormalizer* normalizer, const char* string);
+
+#endif
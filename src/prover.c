@@ -0,0 +1,509 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "rules.h"
+#include "rules_internal.h"
+#include "proof.h"
+#include "sat.h"
+#include "prover.h"
+#include "prover_internal.h"
+#include "stats_internal.h"
+#include "threads.h"
+#include "vector.h"
+
+
+/* === WffProver === */
+
+WffProverStatus wff_prover_prove(const char* goal, WffRuleIndex* index, size_t thread_count, WffProverReport* report) {
+    report->proof = NULL;
+    report->step_count = 0;
+    report->expanded = 0;
+    report->reached = 0;
+
+    while (isspace((unsigned char) *goal)) {
+        goal++;
+    }
+    if (strncmp(goal, "PROVE ", 6) == 0) {
+        goal += 6;
+    }
+    char* string = wff_proof_normalize(goal);
+    if (string == NULL) {
+        report->status = WPRS_MALFORMED;
+        return report->status;
+    }
+    WffProver prover;
+    prover.goal = wff_create(string);
+    free(string);
+    WffParseTreeNode* root = prover.goal->parse_tree->root;
+    if (root->child_count != 5 || root->children[2]->token->operator != WO_COND) {
+        wff_destroy(prover.goal);
+        report->status = WPRS_MALFORMED;
+        return report->status;
+    }
+
+    // Rewriting with equivalences only ever reaches equivalent wffs, so there
+    // is nothing to search for otherwise.
+    Wff* antecedent = _wff_create_version(prover.goal, root->children[1], _wff_count_propositions(root->children[1]));
+    Wff* consequent = _wff_create_version(prover.goal, root->children[3], _wff_count_propositions(root->children[3]));
+    bool equivalent = wff_sat_equivalent(antecedent, consequent, NULL);
+    wff_destroy(consequent);
+    wff_destroy(antecedent);
+    if (!equivalent) {
+        wff_destroy(prover.goal);
+        report->status = WPRS_INEQUIVALENT;
+        return report->status;
+    }
+
+    thread_count = wff_threads_resolve(thread_count);
+    // No point in more threads than states expanded per round.
+    if (thread_count > WFF_PROVER_BATCH) {
+        thread_count = WFF_PROVER_BATCH;
+    }
+
+    WffParseTreeNode* start = root->children[1];
+    prover.index = index;
+    prover.arena = prover.goal->arena;
+    prover.nodes = prover.goal->parse_tree->nodes;
+    prover.target = root->children[3];
+    size_t longest = start->length > prover.target->length ? start->length : prover.target->length;
+    prover.max_length = 2 * longest + 8;
+
+    wff_node_map_init(&prover.target_subwffs, 0, prover.nodes->count);
+    _wff_prover_collect_target(&prover, prover.target);
+
+    wff_vector_init(&prover.states, sizeof(WffProverState), NULL);
+    wff_node_map_init(&prover.reached, 0, 256);
+    wff_vector_init(&prover.heap, sizeof(size_t), NULL);
+    prover.slots = malloc(WFF_PROVER_BATCH * sizeof(WffProverSlot));
+    for (size_t i = 0; i < WFF_PROVER_BATCH; i++) {
+        wff_vector_init(&prover.slots[i].children, sizeof(WffProverChild), NULL);
+    }
+    prover.slot_count = 0;
+    prover.expanded = 0;
+    prover.thread_count = thread_count;
+    prover.done = false;
+    pthread_barrier_init(&prover.start, NULL, thread_count);
+    pthread_barrier_init(&prover.finish, NULL, thread_count);
+    pthread_mutex_init(&prover.lock, NULL);
+
+    WffProverWorker workers[thread_count];
+    pthread_t threads[thread_count];
+    for (size_t i = 0; i < thread_count; i++) {
+        workers[i].prover = &prover;
+        workers[i].id = i;
+        wff_node_map_init(&workers[i].seen, 0, prover.nodes->count);
+    }
+    for (size_t i = 1; i < thread_count; i++) {
+        pthread_create(&threads[i], NULL, _wff_prover_worker, &workers[i]);
+    }
+
+    _wff_prover_reach(&prover, start);
+    size_t found = _wff_prover_add_state(&prover, start, _wff_count_propositions(start), WFF_PROVER_NO_PARENT, NULL,
+                                         _wff_prover_distance(&workers[0], start), 0);
+    // The calling thread is worker 0.
+    WFF_STATS_BEGIN(WSTP_PROVE);
+    report->status = start == prover.target ? WPRS_FOUND : _wff_prover_search(&workers[0], &found);
+    WFF_STATS_END(WSTP_PROVE);
+
+    prover.done = true;
+    pthread_barrier_wait(&prover.start);
+    for (size_t i = 1; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (report->status == WPRS_FOUND) {
+        report->proof = _wff_prover_write_proof(&prover, goal, found, &report->step_count);
+    }
+    report->expanded = prover.expanded;
+    report->reached = wff_vector_length(&prover.states);
+
+    for (size_t i = 0; i < thread_count; i++) {
+        wff_node_map_finish(&workers[i].seen);
+    }
+    for (size_t i = 0; i < WFF_PROVER_BATCH; i++) {
+        wff_vector_finish(&prover.slots[i].children);
+    }
+    free(prover.slots);
+    wff_vector_finish(&prover.heap);
+    wff_node_map_finish(&prover.reached);
+    wff_vector_finish(&prover.states);
+    wff_node_map_finish(&prover.target_subwffs);
+    pthread_mutex_destroy(&prover.lock);
+    pthread_barrier_destroy(&prover.finish);
+    pthread_barrier_destroy(&prover.start);
+    wff_destroy(prover.goal);
+    return report->status;
+}
+
+const char* wff_prover_status_string(WffProverStatus status) {
+    switch (status) {
+        case WPRS_FOUND:
+            return "found";
+        case WPRS_EXHAUSTED:
+            return "exhausted";
+        case WPRS_LIMIT:
+            return "limit";
+        case WPRS_INEQUIVALENT:
+            return "inequivalent";
+        case WPRS_MALFORMED:
+            return "malformed";
+    }
+    return NULL;
+}
+
+int wff_prover_main(int argc, char** argv) {
+    size_t thread_count = 0;
+    int first = wff_threads_parse_option(argc, argv, &thread_count);
+    if (first < 0) {
+        return 1;
+    }
+    if (first + 1 != argc) {
+        fprintf(stderr, "Usage: main --prove [-j threads] \"<wff> => <wff>\"\n");
+        return 1;
+    }
+
+    WffRuleIndex* index = wff_rule_index_create(WFF_RULES, WFF_RULE_COUNT);
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    WffProverReport report;
+    wff_prover_prove(argv[first], index, thread_count, &report);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    wff_rule_index_destroy(index);
+
+    switch (report.status) {
+        case WPRS_FOUND:
+            printf("%s", report.proof);
+            fflush(stdout);
+            fprintf(stderr, "Found a %zu-step proof in %.3f ms (%zu wffs expanded, %zu reached)\n", report.step_count,
+                    seconds * 1e3, report.expanded, report.reached);
+            free(report.proof);
+            return 0;
+        case WPRS_MALFORMED:
+            fprintf(stderr, "ERROR: The goal must be a wff of the form X => Y\n");
+            return 1;
+        case WPRS_INEQUIVALENT:
+            fprintf(stderr, "No proof: the two sides aren't equivalent\n");
+            return 1;
+        default:
+            fprintf(stderr, "No proof found in %.3f ms (%s after %zu wffs expanded, %zu reached)\n", seconds * 1e3,
+                    wff_prover_status_string(report.status), report.expanded, report.reached);
+            return 1;
+    }
+}
+
+// Runs rounds until the target is reached, writing its state to 'found'.
+WffProverStatus _wff_prover_search(WffProverWorker* worker, size_t* found) {
+    WffProver* prover = worker->prover;
+    _wff_prover_heap_push(prover, 0);
+    WffProverStatus status;
+    while (true) {
+        if (wff_vector_length(&prover->heap) == 0) {
+            status = WPRS_EXHAUSTED;
+            break;
+        }
+        if (wff_vector_length(&prover->states) >= WFF_PROVER_STATE_LIMIT) {
+            status = WPRS_LIMIT;
+            break;
+        }
+        prover->slot_count = 0;
+        while (prover->slot_count < WFF_PROVER_BATCH && wff_vector_length(&prover->heap) > 0) {
+            prover->slots[prover->slot_count].state = _wff_prover_heap_pop(prover);
+            prover->slot_count++;
+        }
+
+        pthread_barrier_wait(&prover->start);
+        _wff_prover_work(worker);
+        pthread_barrier_wait(&prover->finish);
+        prover->expanded += prover->slot_count;
+
+        if (_wff_prover_merge(prover, found)) {
+            status = WPRS_FOUND;
+            break;
+        }
+    }
+    return status;
+}
+
+void* _wff_prover_worker(void* arg) {
+    WffProverWorker* worker = arg;
+    WffProver* prover = worker->prover;
+    while (true) {
+        pthread_barrier_wait(&prover->start);
+        if (prover->done) {
+            return NULL;
+        }
+        _wff_prover_work(worker);
+        pthread_barrier_wait(&prover->finish);
+    }
+}
+
+void _wff_prover_work(WffProverWorker* worker) {
+    WffProver* prover = worker->prover;
+    for (size_t i = worker->id; i < prover->slot_count; i += prover->thread_count) {
+        _wff_prover_expand(worker, &prover->slots[i]);
+    }
+}
+
+// Finds every rewrite of the slot's state and measures how far each is from
+// the target.
+void _wff_prover_expand(WffProverWorker* worker, WffProverSlot* slot) {
+    WffProver* prover = worker->prover;
+    WffProverState* state = _wff_prover_state(prover, slot->state);
+    WffParseTree tree = {.arena = prover->arena, .nodes = prover->nodes, .root = state->root};
+    Wff wff = {.string = NULL, .var_count = state->var_count, .parse_tree = &tree, .wff_tree = NULL, .arena = prover->arena};
+
+    wff_vector_truncate(&slot->children, 0);
+    WffRuleMatchList* matches = wff_rule_index_match(prover->index, &wff);
+    WffVectorIterator iterator = wff_rule_match_list_iterate(matches);
+    for (WffRuleMatch* match = wff_rule_match_list_next(&iterator); match != NULL; match = wff_rule_match_list_next(&iterator)) {
+        size_t var_count;
+        pthread_mutex_lock(&prover->lock);
+        WffParseTreeNode* root = _wff_rule_match_rewrite_root(&wff, match, &var_count);
+        pthread_mutex_unlock(&prover->lock);
+        const WffRule* rule = wff_rule_match_get_rule(match);
+        size_t cost = _wff_prover_step_cost(match);
+        wff_rule_match_destroy(match);
+        if (root->length > prover->max_length || root == state->root) {
+            continue;
+        }
+
+        WffProverChild* child = wff_vector_push(&slot->children);
+        child->root = root;
+        child->var_count = var_count;
+        child->rule = rule;
+        child->distance = _wff_prover_distance(worker, root);
+        child->cost = cost;
+    }
+    wff_rule_match_list_destroy(matches);
+}
+
+// Rewrites that wrap a subwff whole, such as p to ~~p or to (p ^ T), apply at
+// every site of every wff and are seldom what a proof needs, so they cost
+// more than other steps and are tried once the rest look no better.
+size_t _wff_prover_step_cost(WffRuleMatch* match) {
+    // Only a search side that is a lone variable binds the whole subwff.
+    bool wraps = match->entry->var_count == 1 && match->bindings[0] == match->subwff_root;
+    return wraps ? WFF_PROVER_WRAP_COST : 1;
+}
+
+// Adds the new wffs of this round to the frontier, in batch order. Returns
+// true, with its state in 'found', if one of them is the target.
+bool _wff_prover_merge(WffProver* prover, size_t* found) {
+    for (size_t i = 0; i < prover->slot_count; i++) {
+        WffProverSlot* slot = &prover->slots[i];
+        WffVectorIterator iterator = wff_vector_iterate(&slot->children);
+        for (WffProverChild* child = wff_vector_iterator_next(&iterator); child != NULL; child = wff_vector_iterator_next(&iterator)) {
+            if (!_wff_prover_reach(prover, child->root)) {
+                continue;
+            }
+            size_t state = _wff_prover_add_state(prover, child->root, child->var_count, slot->state, child->rule, child->distance, child->cost);
+            if (child->root == prover->target) {
+                *found = state;
+                return true;
+            }
+            _wff_prover_heap_push(prover, state);
+        }
+    }
+    return false;
+}
+
+size_t _wff_prover_add_state(WffProver* prover, WffParseTreeNode* root, size_t var_count, size_t parent, const WffRule* rule, size_t distance, size_t cost) {
+    // Read before the push, which may move the states.
+    WffProverState* parent_state = parent == WFF_PROVER_NO_PARENT ? NULL : _wff_prover_state(prover, parent);
+    size_t steps = parent_state == NULL ? 0 : parent_state->steps + 1;
+    cost = parent_state == NULL ? 0 : parent_state->cost + cost;
+    WffProverState* state = wff_vector_push(&prover->states);
+    state->root = root;
+    state->var_count = var_count;
+    state->parent = parent;
+    state->rule = rule;
+    state->steps = steps;
+    state->cost = cost;
+    state->distance = distance;
+    return wff_vector_length(&prover->states) - 1;
+}
+
+WffProverState* _wff_prover_state(WffProver* prover, size_t state) {
+    return wff_vector_get(&prover->states, state);
+}
+
+// Marks the wff as reached by the state about to be added. Returns false if
+// it already was.
+bool _wff_prover_reach(WffProver* prover, WffParseTreeNode* root) {
+    return wff_node_map_add(&prover->reached, root);
+}
+
+void _wff_prover_collect_target(WffProver* prover, WffParseTreeNode* node) {
+    if (node->type != WPTNT_NONTERMINAL || !wff_node_map_add(&prover->target_subwffs, node)) {
+        return;
+    }
+    for (int j = 0; j < node->child_count; j++) {
+        _wff_prover_collect_target(prover, node->children[j]);
+    }
+}
+
+bool _wff_prover_is_target_subwff(WffProver* prover, WffParseTreeNode* node) {
+    return wff_node_map_contains(&prover->target_subwffs, node);
+}
+
+// Distinct subwffs of 'root' that the target lacks plus those of the target
+// that 'root' lacks. Zero only for the target itself, and a rewrite that
+// leaves most of a wff alone changes it by little.
+size_t _wff_prover_distance(WffProverWorker* worker, WffParseTreeNode* root) {
+    wff_node_map_clear(&worker->seen);
+    size_t common = 0;
+    _wff_prover_count_subwffs(worker, root, &common);
+    size_t count = worker->seen.count;
+    size_t target_count = worker->prover->target_subwffs.count;
+    return (count - common) + (target_count - common);
+}
+
+void _wff_prover_count_subwffs(WffProverWorker* worker, WffParseTreeNode* node, size_t* common) {
+    if (node->type != WPTNT_NONTERMINAL || !wff_node_map_add(&worker->seen, node)) {
+        return;
+    }
+    if (_wff_prover_is_target_subwff(worker->prover, node)) {
+        (*common)++;
+    }
+    for (int j = 0; j < node->child_count; j++) {
+        _wff_prover_count_subwffs(worker, node->children[j], common);
+    }
+}
+
+// Whether state 'a' comes off the frontier before state 'b': least cost plus
+// distance first, then the closer of the two, then the older.
+bool _wff_prover_heap_less(WffProver* prover, size_t a, size_t b) {
+    WffProverState* state_a = _wff_prover_state(prover, a);
+    WffProverState* state_b = _wff_prover_state(prover, b);
+    size_t cost_a = state_a->cost + state_a->distance;
+    size_t cost_b = state_b->cost + state_b->distance;
+    if (cost_a != cost_b) {
+        return cost_a < cost_b;
+    }
+    if (state_a->distance != state_b->distance) {
+        return state_a->distance < state_b->distance;
+    }
+    return a < b;
+}
+
+void _wff_prover_heap_push(WffProver* prover, size_t state) {
+    wff_vector_push(&prover->heap);
+    size_t* heap = wff_vector_get(&prover->heap, 0);
+    size_t i = wff_vector_length(&prover->heap) - 1;
+    while (i > 0 && _wff_prover_heap_less(prover, state, heap[(i - 1) / 2])) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = state;
+}
+
+size_t _wff_prover_heap_pop(WffProver* prover) {
+    size_t* heap = wff_vector_get(&prover->heap, 0);
+    size_t count = wff_vector_length(&prover->heap) - 1;
+    size_t top = heap[0];
+    size_t last = heap[count];
+    wff_vector_truncate(&prover->heap, count);
+    size_t i = 0;
+    while (true) {
+        size_t child = 2 * i + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && _wff_prover_heap_less(prover, heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!_wff_prover_heap_less(prover, heap[child], last)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (count > 0) {
+        heap[i] = last;
+    }
+    return top;
+}
+
+// Writes the proof ending at state 'found' as sample.md does:
+//
+//     PROVE (p v q) ^ (p v ~q) => p
+//     (Direct Proof)
+//     1. (p v q) ^ (p v ~q)              (hypothesis)
+//     2. p v (q ^ ~q)                    (E14, 1)
+char* _wff_prover_write_proof(WffProver* prover, const char* goal, size_t found, size_t* step_count) {
+    *step_count = _wff_prover_state(prover, found)->steps;
+    size_t line_count = *step_count + 1;
+    size_t path[line_count];
+    size_t size = strlen(goal) + 32;
+    for (size_t state = found, i = line_count; i > 0; state = _wff_prover_state(prover, state)->parent, i--) {
+        path[i - 1] = state;
+        // Each binary operator adds two spaces, and takes up at least five
+        // characters.
+        size += 2 * _wff_prover_state(prover, state)->root->length + 64;
+    }
+
+    char* proof = malloc(size);
+    char* out = proof;
+    size_t goal_length = strlen(goal);
+    while (goal_length > 0 && isspace((unsigned char) goal[goal_length - 1])) {
+        goal_length--;
+    }
+    out += sprintf(out, "PROVE %.*s\n(Direct Proof)\n", (int) goal_length, goal);
+    for (size_t i = 0; i < line_count; i++) {
+        WffProverState* state = _wff_prover_state(prover, path[i]);
+        char* line = out;
+        out += sprintf(out, "%zu. ", i + 1);
+        out = _wff_prover_render(state->root, out, true);
+        // Justifications line up after the wffs, as in sample.md.
+        do {
+            *out++ = ' ';
+        } while (out - line < 35 || out[-2] != ' ');
+        if (state->parent == WFF_PROVER_NO_PARENT) {
+            out += sprintf(out, "(hypothesis)\n");
+        } else {
+            out += sprintf(out, "(%s, %zu)\n", state->rule->name, i);
+        }
+    }
+    *out = '\0';
+    return proof;
+}
+
+// Writes the wff with spaces around binary operators, leaving off the
+// parentheses around the outermost one as proofs do. Returns the end of what
+// was written.
+char* _wff_prover_render(WffParseTreeNode* node, char* out, bool outermost) {
+    if (node->child_count == 1) {
+        const char* string = wff_token_get_string(node->children[0]->token);
+        size_t length = strlen(string);
+        memcpy(out, string, length);
+        return out + length;
+    } else if (node->child_count == 2) {
+        *out++ = '~';
+        return _wff_prover_render(node->children[1], out, false);
+    }
+
+    if (!outermost) {
+        *out++ = '(';
+    }
+    out = _wff_prover_render(node->children[1], out, false);
+    *out++ = ' ';
+    const char* operator = wff_token_get_string(node->children[2]->token);
+    size_t length = strlen(operator);
+    memcpy(out, operator, length);
+    out += length;
+    *out++ = ' ';
+    out = _wff_prover_render(node->children[3], out, false);
+    if (!outermost) {
+        *out++ = ')';
+    }
+    return out;
+}
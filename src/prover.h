@@ -0,0 +1,52 @@
+#ifndef PROVER_H_
+#define PROVER_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "rules.h"
+
+
+typedef struct WffProverReport WffProverReport;
+
+typedef enum {
+    // A proof was found.
+    WPRS_FOUND,
+    // Every wff the rules reach, up to the size bound, was tried.
+    WPRS_EXHAUSTED,
+    // The search gave up after WFF_PROVER_STATE_LIMIT wffs.
+    WPRS_LIMIT,
+    // The two sides of the goal aren't equivalent, so no rewrites lead from
+    // one to the other.
+    WPRS_INEQUIVALENT,
+    // The goal isn't a conditional wff.
+    WPRS_MALFORMED
+} WffProverStatus;
+
+struct WffProverReport {
+    WffProverStatus status;
+    // The proof, written the way sample.md shows it, or NULL if none was
+    // found. The caller frees it.
+    char* proof;
+    // Steps after the hypothesis.
+    size_t step_count;
+    // Wffs whose rewrites were generated and distinct wffs reached.
+    size_t expanded;
+    size_t reached;
+};
+
+
+// Searches for a direct proof of 'goal', "X => Y", that rewrites X into Y
+// with the rules of 'index', one equivalence per line. 'thread_count'
+// threads expand the search frontier together (0 picks one per processor);
+// the proof found doesn't depend on how many there are.
+WffProverStatus wff_prover_prove(const char* goal, WffRuleIndex* index, size_t thread_count, WffProverReport* report);
+const char* wff_prover_status_string(WffProverStatus status);
+
+// Proves the goal given on the command line, "[-j threads] <goal>", printing
+// the proof to stdout and what the search took to stderr. Returns the exit
+// status.
+int wff_prover_main(int argc, char** argv);
+
+#endif
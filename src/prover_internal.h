@@ -0,0 +1,124 @@
+#ifndef PROVER_INTERNAL_H_
+#define PROVER_INTERNAL_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "logic_internal.h"
+#include "rules.h"
+#include "prover.h"
+#include "vector.h"
+
+typedef struct WffProver WffProver;
+typedef struct WffProverState WffProverState;
+typedef struct WffProverChild WffProverChild;
+typedef struct WffProverSlot WffProverSlot;
+typedef struct WffProverWorker WffProverWorker;
+
+// Wffs taken off the frontier and expanded together in each round.
+#define WFF_PROVER_BATCH 16
+#define WFF_PROVER_STATE_LIMIT 200000
+// Cost of a rewrite that wraps a subwff whole (see _wff_prover_step_cost);
+// any other step costs 1.
+#define WFF_PROVER_WRAP_COST 6
+#define WFF_PROVER_NO_PARENT ((size_t) -1)
+
+
+/* === WffProver === */
+// Best-first search from the antecedent of the goal to its consequent. Each
+// wff reached is a state, ordered on the frontier (a binary heap of state
+// indices) by the cost of the steps taken plus its distance from the target.
+// The distance is how many distinct subwffs one of the two has and the other
+// doesn't, which hash-consing makes cheap: every wff of the search is built in
+// the node table of the goal, so equal subwffs are the same node and the
+// target's subwffs can be kept in a pointer set. For the same reason the set
+// of states already reached only needs to compare roots.
+//
+// In each round the main thread takes the best WFF_PROVER_BATCH states off the
+// frontier, every thread expands its share of them, and the main thread adds
+// the new wffs in batch order, so the search goes the same way with any
+// number of threads. Matching only reads the tree and the rule index; the
+// rewrites add nodes to the shared table, so they hold 'lock'.
+struct WffProver {
+    WffRuleIndex* index;
+    Wff* goal;
+    WffArena* arena;
+    WffNodeTable* nodes;
+    WffParseTreeNode* target;
+    // Rewrites longer than this (rendered without spaces) are dropped, which
+    // keeps the rules that only ever add to a wff from running away.
+    size_t max_length;
+    WffNodeMap target_subwffs;
+
+    // WffProverState, indexed by state.
+    WffVector states;
+    // Roots of the states so far.
+    WffNodeMap reached;
+    // State indices.
+    WffVector heap;
+
+    WffProverSlot* slots;
+    size_t slot_count;
+    size_t expanded;
+    size_t thread_count;
+    pthread_barrier_t start;
+    pthread_barrier_t finish;
+    bool done;
+    pthread_mutex_t lock;
+};
+
+struct WffProverState {
+    WffParseTreeNode* root;
+    size_t var_count;
+    // The state this one was rewritten from and the rule that did it.
+    size_t parent;
+    const WffRule* rule;
+    // Lines after the hypothesis, and what they cost to search.
+    size_t steps;
+    size_t cost;
+    size_t distance;
+};
+
+struct WffProverChild {
+    WffParseTreeNode* root;
+    size_t var_count;
+    const WffRule* rule;
+    size_t distance;
+    size_t cost;
+};
+
+// A state being expanded this round and the rewrites found for it.
+struct WffProverSlot {
+    size_t state;
+    // WffProverChild, kept from round to round so their storage is reused.
+    WffVector children;
+};
+
+struct WffProverWorker {
+    WffProver* prover;
+    size_t id;
+    // Scratch set for measuring distances.
+    WffNodeMap seen;
+};
+
+WffProverStatus _wff_prover_search(WffProverWorker* worker, size_t* found);
+void* _wff_prover_worker(void* arg);
+void _wff_prover_work(WffProverWorker* worker);
+void _wff_prover_expand(WffProverWorker* worker, WffProverSlot* slot);
+size_t _wff_prover_step_cost(WffRuleMatch* match);
+bool _wff_prover_merge(WffProver* prover, size_t* found);
+size_t _wff_prover_add_state(WffProver* prover, WffParseTreeNode* root, size_t var_count, size_t parent, const WffRule* rule, size_t distance, size_t cost);
+WffProverState* _wff_prover_state(WffProver* prover, size_t state);
+bool _wff_prover_reach(WffProver* prover, WffParseTreeNode* root);
+void _wff_prover_collect_target(WffProver* prover, WffParseTreeNode* node);
+bool _wff_prover_is_target_subwff(WffProver* prover, WffParseTreeNode* node);
+size_t _wff_prover_distance(WffProverWorker* worker, WffParseTreeNode* root);
+void _wff_prover_count_subwffs(WffProverWorker* worker, WffParseTreeNode* node, size_t* common);
+bool _wff_prover_heap_less(WffProver* prover, size_t a, size_t b);
+void _wff_prover_heap_push(WffProver* prover, size_t state);
+size_t _wff_prover_heap_pop(WffProver* prover);
+char* _wff_prover_write_proof(WffProver* prover, const char* goal, size_t found, size_t* step_count);
+char* _wff_prover_render(WffParseTreeNode* node, char* out, bool outermost);
+
+#endif
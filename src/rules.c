@@ -0,0 +1,566 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "rules.h"
+#include "rules_internal.h"
+#include "stats_internal.h"
+
+
+// Numbered so that the examples in sample.md hold: E1 turns (q ^ ~q) into F,
+// E6 turns (p v F) into p, E10 commutes v and E14 distributes v over ^.
+const WffRule WFF_RULES[] = {
+    {"E1", "Contradiction", "(p ^ ~p)", "F"},
+    {"E2", "Excluded middle", "(p v ~p)", "T"},
+    {"E3", "Double negation", "~~p", "p"},
+    {"E4", "Identity", "(p ^ T)", "p"},
+    {"E5", "Domination", "(p v T)", "T"},
+    {"E6", "Identity", "(p v F)", "p"},
+    {"E7", "Domination", "(p ^ F)", "F"},
+    {"E8", "Idempotence", "(p ^ p)", "p"},
+    {"E9", "Idempotence", "(p v p)", "p"},
+    {"E10", "Commutativity", "(p v q)", "(q v p)"},
+    {"E11", "Commutativity", "(p ^ q)", "(q ^ p)"},
+    {"E12", "Associativity", "((p v q) v r)", "(p v (q v r))"},
+    {"E13", "Associativity", "((p ^ q) ^ r)", "(p ^ (q ^ r))"},
+    {"E14", "Distributivity", "(p v (q ^ r))", "((p v q) ^ (p v r))"},
+    {"E15", "Distributivity", "(p ^ (q v r))", "((p ^ q) v (p ^ r))"},
+    {"E16", "De Morgan", "~(p ^ q)", "(~p v ~q)"},
+    {"E17", "De Morgan", "~(p v q)", "(~p ^ ~q)"},
+    {"E18", "Implication", "(p => q)", "(~p v q)"},
+    {"E19", "Contrapositive", "(p => q)", "(~q => ~p)"},
+    {"E20", "Biconditional", "(p <=> q)", "((p => q) ^ (q => p))"},
+    {"E21", "Commutativity", "(p <=> q)", "(q <=> p)"},
+    {"E22", "Absorption", "(p v (p ^ q))", "p"},
+    {"E23", "Absorption", "(p ^ (p v q))", "p"},
+    {"E24", "Negation", "~T", "F"},
+    {"E25", "Negation", "~F", "T"},
+    {"E26", "Exportation", "((p ^ q) => r)", "(p => (q => r))"},
+    {"E27", "Biconditional", "(p <=> q)", "((p ^ q) v (~p ^ ~q))"},
+    {"E28", "Negated biconditional", "~(p <=> q)", "(p <=> ~q)"},
+};
+
+const size_t WFF_RULE_COUNT = sizeof(WFF_RULES) / sizeof(WFF_RULES[0]);
+
+
+/* === WffRule === */
+
+const WffRule* wff_rule_find(const char* name) {
+    for (size_t i = 0; i < WFF_RULE_COUNT; i++) {
+        if (strcmp(WFF_RULES[i].name, name) == 0) {
+            return &WFF_RULES[i];
+        }
+    }
+    return NULL;
+}
+
+// Whether applying the rule right-to-left is the same rewrite as left-to-right
+// up to renaming variables (e.g. commutativity). Indexing both directions of
+// such a rule would only report every outcome twice.
+bool _wff_rule_is_symmetric(const char* search, const char* replace) {
+    char forward_search[strlen(search) + 1];
+    char forward_replace[strlen(replace) + 1];
+    char reverse_search[strlen(replace) + 1];
+    char reverse_replace[strlen(search) + 1];
+    _wff_rule_canonicalize(search, search, forward_search);
+    _wff_rule_canonicalize(search, replace, forward_replace);
+    _wff_rule_canonicalize(replace, replace, reverse_search);
+    _wff_rule_canonicalize(replace, search, reverse_replace);
+    return strcmp(forward_search, reverse_search) == 0 && strcmp(forward_replace, reverse_replace) == 0;
+}
+
+// Writes 'string' to 'out' without spaces and with each variable replaced by
+// a digit giving its order of first appearance in 'search'.
+void _wff_rule_canonicalize(const char* search, const char* string, char* out) {
+    char names[strlen(search) + 1];
+    size_t name_count = 0;
+    for (const char* c = search; *c != '\0'; c++) {
+        bool isVariable = (('a' <= *c && *c <= 'z') || ('A' <= *c && *c <= 'Z')) && *c != 'v' && *c != 'T' && *c != 'F';
+        if (isVariable && memchr(names, *c, name_count) == NULL) {
+            names[name_count] = *c;
+            name_count++;
+        }
+    }
+    for (const char* c = string; *c != '\0'; c++) {
+        if (*c == ' ') {
+            continue;
+        }
+        const char* name = memchr(names, *c, name_count);
+        *out = name == NULL ? *c : '0' + (name - names);
+        out++;
+    }
+    *out = '\0';
+}
+
+
+/* === WffRuleIndex === */
+
+WffRuleIndex* wff_rule_index_create(const WffRule* rules, size_t rule_count) {
+    WffArena* arena = wff_arena_create();
+    WffRuleIndex* index = wff_arena_alloc(arena, sizeof(WffRuleIndex));
+    index->arena = arena;
+    index->nodes = wff_node_table_create(arena);
+    index->root = wff_arena_alloc(arena, sizeof(WffRuleIndexNode));
+    memset(index->root, 0, sizeof(WffRuleIndexNode));
+    index->entry_count = 0;
+    index->max_length = 0;
+
+    for (size_t i = 0; i < rule_count; i++) {
+        _wff_rule_index_add(index, &rules[i], false);
+        if (!_wff_rule_is_symmetric(rules[i].left, rules[i].right)) {
+            _wff_rule_index_add(index, &rules[i], true);
+        }
+    }
+    return index;
+}
+
+void wff_rule_index_destroy(WffRuleIndex* index) {
+    wff_arena_destroy(index->arena);
+}
+
+void _wff_rule_index_add(WffRuleIndex* index, const WffRule* rule, bool reverse) {
+    const char* search_string = reverse ? rule->right : rule->left;
+    const char* replace_string = reverse ? rule->left : rule->right;
+    WffParseTree* search = _wff_parse_tree_create_from_string(search_string, index->arena, index->nodes, NULL);
+    WffParseTree* replace = _wff_parse_tree_create_from_string(replace_string, index->arena, index->nodes, NULL);
+    if (search == NULL || replace == NULL) {
+        printf("ERROR: Invalid rule '%s'\n", rule->name);
+        exit(1);
+    }
+
+    // Every symbol takes up at least one character, so the string lengths
+    // bound the number of symbols.
+    WffRuleSymbol symbols[strlen(search_string)];
+    WffTokenVariable* wildcards[strlen(search_string)];
+    size_t symbol_count = 0;
+    size_t wildcard_count = 0;
+    _wff_rule_index_flatten(search->root, symbols, wildcards, &symbol_count, &wildcard_count);
+
+    WffRuleIndexEntry* entry = wff_arena_alloc(index->arena, sizeof(WffRuleIndexEntry));
+    entry->rule = rule;
+    entry->reverse = reverse;
+    entry->replace = replace->root;
+    entry->var_count = 0;
+    entry->vars = wff_arena_alloc(index->arena, wildcard_count * sizeof(WffTokenVariable*));
+    entry->wildcard_count = wildcard_count;
+    entry->wildcard_vars = wff_arena_alloc(index->arena, wildcard_count * sizeof(size_t));
+    entry->next = NULL;
+    // Index into entry->vars of each variable ID, or -1 if not seen yet.
+    int var_index[WFF_VARIABLE_COUNT];
+    memset(var_index, -1, sizeof(var_index));
+    for (size_t i = 0; i < wildcard_count; i++) {
+        size_t id = wildcards[i]->id;
+        if (var_index[id] < 0) {
+            var_index[id] = entry->var_count;
+            entry->vars[entry->var_count] = wildcards[i];
+            entry->var_count++;
+        }
+        entry->wildcard_vars[i] = var_index[id];
+    }
+
+    // A direction that introduces variables (such as F to (p ^ ~p)) has no
+    // single outcome, so it is left out.
+    WffRuleSymbol replace_symbols[strlen(replace_string)];
+    WffTokenVariable* replace_vars[strlen(replace_string)];
+    size_t replace_symbol_count = 0;
+    size_t replace_var_count = 0;
+    _wff_rule_index_flatten(replace->root, replace_symbols, replace_vars, &replace_symbol_count, &replace_var_count);
+    for (size_t i = 0; i < replace_var_count; i++) {
+        if (var_index[replace_vars[i]->id] < 0) {
+            return;
+        }
+    }
+
+    WffRuleIndexNode* trie_node = index->root;
+    for (size_t i = 0; i < symbol_count; i++) {
+        if (trie_node->children[symbols[i]] == NULL) {
+            WffRuleIndexNode* child = wff_arena_alloc(index->arena, sizeof(WffRuleIndexNode));
+            memset(child, 0, sizeof(WffRuleIndexNode));
+            trie_node->children[symbols[i]] = child;
+        }
+        trie_node = trie_node->children[symbols[i]];
+    }
+    // Keep entries in rule order.
+    WffRuleIndexEntry** end = &trie_node->entries;
+    while (*end != NULL) {
+        end = &(*end)->next;
+    }
+    *end = entry;
+
+    index->entry_count++;
+    if (symbol_count > index->max_length) {
+        index->max_length = symbol_count;
+    }
+}
+
+void _wff_rule_index_flatten(WffParseTreeNode* node, WffRuleSymbol* symbols, WffTokenVariable** wildcards, size_t* symbol_count, size_t* wildcard_count) {
+    WffParseTreeNode* operands[2];
+    size_t operand_count;
+    WffRuleSymbol symbol = _wff_rule_symbol(node, operands, &operand_count);
+    if (symbol == WRS_ATOM) {
+        symbols[*symbol_count] = WRS_WILDCARD;
+        (*symbol_count)++;
+        wildcards[*wildcard_count] = node->children[0]->token->variable;
+        (*wildcard_count)++;
+        return;
+    }
+    symbols[*symbol_count] = symbol;
+    (*symbol_count)++;
+    for (size_t i = 0; i < operand_count; i++) {
+        _wff_rule_index_flatten(operands[i], symbols, wildcards, symbol_count, wildcard_count);
+    }
+}
+
+WffRuleMatchList* wff_rule_index_match(WffRuleIndex* index, Wff* wff) {
+    WFF_STATS_BEGIN(WSTP_MATCH);
+    WffParseTreeNode* wildcards[index->max_length + 1];
+    WffRuleIndexSearch search = {.wildcards = wildcards, .list = wff_rule_match_list_create()};
+    size_t site = 0;
+    _wff_rule_index_traversal(index, wff->parse_tree->root, &search, &site);
+    WFF_STATS_END(WSTP_MATCH);
+    return search.list;
+}
+
+// Whether 'result' is an outcome of applying 'rule', in either direction, at
+// some site of 'source'. If so and 'site' isn't NULL, the first such site is
+// written there.
+bool wff_rule_verify(WffRuleIndex* index, Wff* source, const WffRule* rule, Wff* result, size_t* site) {
+    WffRuleMatchList* list = _wff_rule_index_explain(index, source, result, rule);
+    bool found = wff_rule_match_list_length(list) > 0;
+    if (found && site != NULL) {
+        *site = wff_rule_match_list_get(list, 0)->site;
+    }
+    WffVectorIterator iterator = wff_rule_match_list_iterate(list);
+    for (WffRuleMatch* match = wff_rule_match_list_next(&iterator); match != NULL; match = wff_rule_match_list_next(&iterator)) {
+        wff_rule_match_destroy(match);
+    }
+    wff_rule_match_list_destroy(list);
+    return found;
+}
+
+// Every (rule, site) that turns 'source' into 'result', one match each, in
+// order of site, e.g. to fill in the justification of a proof line written
+// without one.
+WffRuleMatchList* wff_rule_infer(WffRuleIndex* index, Wff* source, Wff* result) {
+    return _wff_rule_index_explain(index, source, result, NULL);
+}
+
+void _wff_rule_index_traversal(WffRuleIndex* index, WffParseTreeNode* node, WffRuleIndexSearch* search, size_t* site) {
+    // Visit nonterminals in the same preorder as _wff_match_traversal so that
+    // sites mean the same thing.
+    if (node->type != WPTNT_NONTERMINAL) {
+        return;
+    }
+    search->subwff_root = node;
+    search->site = *site;
+    WffParseTreeNode* pending[1] = {node};
+    WFF_STATS_ADD(match_attempts, 1);
+    _wff_rule_index_retrieve(index->root, pending, 1, 0, search);
+    (*site)++;
+
+    for (int i = 0; i < node->child_count; i++) {
+        _wff_rule_index_traversal(index, node->children[i], search, site);
+    }
+}
+
+// Walks every path of the discrimination tree that the pending subwffs could
+// spell. 'pending' is a stack with the next subwff to match on top.
+void _wff_rule_index_retrieve(WffRuleIndexNode* trie_node, WffParseTreeNode** pending, size_t pending_count, size_t wildcard_count, WffRuleIndexSearch* search) {
+    if (pending_count == 0) {
+        for (WffRuleIndexEntry* entry = trie_node->entries; entry != NULL; entry = entry->next) {
+            _wff_rule_index_report(entry, search);
+        }
+        return;
+    }
+
+    WffParseTreeNode* node = pending[pending_count - 1];
+    if (trie_node->children[WRS_WILDCARD] != NULL) {
+        search->wildcards[wildcard_count] = node;
+        _wff_rule_index_retrieve(trie_node->children[WRS_WILDCARD], pending, pending_count - 1, wildcard_count + 1, search);
+    }
+
+    WffParseTreeNode* operands[2];
+    size_t operand_count;
+    WffRuleSymbol symbol = _wff_rule_symbol(node, operands, &operand_count);
+    WffRuleIndexNode* child = trie_node->children[symbol];
+    if (child != NULL) {
+        WffParseTreeNode* next[pending_count + 1];
+        memcpy(next, pending, (pending_count - 1) * sizeof(WffParseTreeNode*));
+        // Push in reverse so that the first operand is matched first.
+        for (size_t i = 0; i < operand_count; i++) {
+            next[pending_count - 1 + i] = operands[operand_count - 1 - i];
+        }
+        _wff_rule_index_retrieve(child, next, pending_count - 1 + operand_count, wildcard_count, search);
+    }
+}
+
+void _wff_rule_index_report(WffRuleIndexEntry* entry, WffRuleIndexSearch* search) {
+    if (search->rule != NULL && entry->rule != search->rule) {
+        return;
+    }
+    WffParseTreeNode** bindings = calloc(entry->var_count, sizeof(WffParseTreeNode*));
+    for (size_t i = 0; i < entry->wildcard_count; i++) {
+        size_t k = entry->wildcard_vars[i];
+        // Subwffs of one hash-consed tree are equal iff they are the same node.
+        if (bindings[k] == NULL) {
+            bindings[k] = search->wildcards[i];
+        } else if (bindings[k] != search->wildcards[i]) {
+            free(bindings);
+            return;
+        }
+    }
+    if (search->target != NULL) {
+        if (!_wff_rule_index_outcome_equals(entry, entry->replace, bindings, search->target)) {
+            free(bindings);
+            return;
+        }
+        // Both directions of a rule may explain the same rewrite.
+        WffVectorIterator iterator = wff_rule_match_list_iterate(search->list);
+        for (WffRuleMatch* match = wff_rule_match_list_next(&iterator); match != NULL; match = wff_rule_match_list_next(&iterator)) {
+            if (match->site == search->site && match->entry->rule == entry->rule) {
+                free(bindings);
+                return;
+            }
+        }
+    }
+
+    WffRuleMatch* match = malloc(sizeof(WffRuleMatch));
+    match->entry = entry;
+    match->subwff_root = search->subwff_root;
+    match->site = search->site;
+    match->bindings = bindings;
+    wff_rule_match_list_append(search->list, match);
+}
+
+// Finds the applications of 'rule' (or of any rule, if NULL) that turn
+// 'source' into 'result', without producing any outcome. Everything outside
+// the rewritten subwff is unchanged, so the site must be on the path from the
+// root to where the two wffs first differ in more than one operand, and its
+// outcome is compared against the subwff of 'result' in the same position.
+// No outcome is built: besides the depth of that path and the size of the
+// rules, the only cost is confirming node by node the subwffs whose hashes
+// agree (see _wff_rule_same_subwff), which grows with the parts of the two
+// wffs that really are equal rather than with every outcome tried.
+WffRuleMatchList* _wff_rule_index_explain(WffRuleIndex* index, Wff* source, Wff* result, const WffRule* rule) {
+    WffParseTreeNode* wildcards[index->max_length + 1];
+    WffRuleIndexSearch search = {.wildcards = wildcards, .list = wff_rule_match_list_create(), .rule = rule};
+    WffParseTreeNode* source_root = source->parse_tree->root;
+    WffParseTreeNode* result_root = result->parse_tree->root;
+    if (_wff_rule_same_subwff(source_root, result_root)) {
+        // Any rewrite that leaves its site as it was (e.g. E10 on (p v p)).
+        size_t site = 0;
+        _wff_rule_index_explain_unchanged(index, source_root, &search, &site);
+    } else {
+        _wff_rule_index_explain_site(index, source_root, result_root, 0, &search);
+    }
+    return search.list;
+}
+
+// Tries 'site' (the site of 'source') and, if the two subwffs only differ in
+// one operand, the sites within it.
+void _wff_rule_index_explain_site(WffRuleIndex* index, WffParseTreeNode* source, WffParseTreeNode* result, size_t site, WffRuleIndexSearch* search) {
+    search->subwff_root = source;
+    search->site = site;
+    search->target = result;
+    WffParseTreeNode* pending[1] = {source};
+    WFF_STATS_ADD(match_attempts, 1);
+    _wff_rule_index_retrieve(index->root, pending, 1, 0, search);
+
+    if (source->child_count != result->child_count || source->child_count == 1) {
+        return;
+    }
+    int differing = -1;
+    for (int i = 0; i < source->child_count; i++) {
+        if (!_wff_rule_same_subwff(source->children[i], result->children[i])) {
+            // A different operator or a second different operand.
+            if (differing >= 0 || source->children[i]->type != WPTNT_NONTERMINAL) {
+                return;
+            }
+            differing = i;
+        }
+    }
+    size_t child_site = site + 1;
+    for (int i = 0; i < differing; i++) {
+        child_site += source->children[i]->site_count;
+    }
+    _wff_rule_index_explain_site(index, source->children[differing], result->children[differing], child_site, search);
+}
+
+// Tries every site under 'node' against itself as the outcome.
+void _wff_rule_index_explain_unchanged(WffRuleIndex* index, WffParseTreeNode* node, WffRuleIndexSearch* search, size_t* site) {
+    if (node->type != WPTNT_NONTERMINAL) {
+        return;
+    }
+    search->subwff_root = node;
+    search->site = *site;
+    search->target = node;
+    WffParseTreeNode* pending[1] = {node};
+    WFF_STATS_ADD(match_attempts, 1);
+    _wff_rule_index_retrieve(index->root, pending, 1, 0, search);
+    (*site)++;
+
+    for (int i = 0; i < node->child_count; i++) {
+        _wff_rule_index_explain_unchanged(index, node->children[i], search, site);
+    }
+}
+
+// Whether two subwffs, possibly from different trees, are equal. Their
+// structural hashes and cached sizes turn away almost every unequal pair at
+// once; a pair that agrees on all of them is compared node by node, so that
+// a hash collision can't get a wrong proof step accepted.
+bool _wff_rule_same_subwff(WffParseTreeNode* node1, WffParseTreeNode* node2) {
+    if (node1 == node2) {
+        return true;
+    }
+    if (node1->type != node2->type || node1->hash != node2->hash || node1->length != node2->length || node1->site_count != node2->site_count) {
+        return false;
+    }
+    return wff_parse_tree_subtree_equals(node1, node2);
+}
+
+// Whether instantiating 'template_node' with the bindings of a match of
+// 'entry' would give 'target', which may belong to another tree.
+bool _wff_rule_index_outcome_equals(WffRuleIndexEntry* entry, WffParseTreeNode* template_node, WffParseTreeNode** bindings, WffParseTreeNode* target) {
+    WffParseTreeNode* template_operands[2];
+    size_t template_operand_count;
+    WffRuleSymbol symbol = _wff_rule_symbol(template_node, template_operands, &template_operand_count);
+    if (symbol == WRS_ATOM) {
+        size_t id = template_node->children[0]->token->variable->id;
+        for (size_t k = 0; k < entry->var_count; k++) {
+            if (entry->vars[k]->id == id) {
+                return _wff_rule_same_subwff(bindings[k], target);
+            }
+        }
+    }
+
+    WffParseTreeNode* target_operands[2];
+    size_t target_operand_count;
+    if (_wff_rule_symbol(target, target_operands, &target_operand_count) != symbol) {
+        return false;
+    }
+    for (size_t i = 0; i < template_operand_count; i++) {
+        if (!_wff_rule_index_outcome_equals(entry, template_operands[i], bindings, target_operands[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns the symbol for a nonterminal and fills in its operands.
+WffRuleSymbol _wff_rule_symbol(WffParseTreeNode* node, WffParseTreeNode** operands, size_t* operand_count) {
+    if (node->child_count == 1) {
+        *operand_count = 0;
+        WffToken* token = node->children[0]->token;
+        if (token->type == WTT_CONSTANT) {
+            return token->value ? WRS_TRUE : WRS_FALSE;
+        }
+        return WRS_ATOM;
+    } else if (node->child_count == 2) {
+        operands[0] = node->children[1];
+        *operand_count = 1;
+        return WRS_NOT;
+    }
+
+    operands[0] = node->children[1];
+    operands[1] = node->children[3];
+    *operand_count = 2;
+    switch (node->children[2]->token->operator) {
+        case WO_AND:
+            return WRS_AND;
+        case WO_OR:
+            return WRS_OR;
+        case WO_COND:
+            return WRS_COND;
+        case WO_BICOND:
+            return WRS_BICOND;
+        default:
+            printf("ERROR: Unhandled case\n");
+            abort();
+    }
+}
+
+
+/* === WffRuleMatch === */
+
+void wff_rule_match_destroy(WffRuleMatch* match) {
+    free(match->bindings);
+    free(match);
+}
+
+const WffRule* wff_rule_match_get_rule(WffRuleMatch* match) {
+    return match->entry->rule;
+}
+
+// Rewrites the matched site of 'wff', which must be the wff the match was
+// found in and must not have changed since.
+void wff_rule_match_apply(Wff* wff, WffRuleMatch* match) {
+    WFF_STATS_BEGIN(WSTP_SUBSTITUTE);
+    size_t var_count;
+    WffParseTreeNode* root = _wff_rule_match_rewrite_root(wff, match, &var_count);
+    _wff_set_root(wff, root, var_count);
+    WFF_STATS_END(WSTP_SUBSTITUTE);
+}
+
+// Like wff_rule_match_apply, but returns the outcome as a new wff that shares
+// every subwff off the rewritten path with 'wff', which is left as it is. A
+// proof line made this way costs only that path.
+Wff* wff_rule_match_rewrite(Wff* wff, WffRuleMatch* match) {
+    WFF_STATS_BEGIN(WSTP_SUBSTITUTE);
+    size_t var_count;
+    WffParseTreeNode* root = _wff_rule_match_rewrite_root(wff, match, &var_count);
+    Wff* result = _wff_create_version(wff, root, var_count);
+    WFF_STATS_END(WSTP_SUBSTITUTE);
+    return result;
+}
+
+WffParseTreeNode* _wff_rule_match_rewrite_root(Wff* wff, WffRuleMatch* match, size_t* var_count) {
+    WFF_STATS_ADD(substitutions, 1);
+    WffRuleIndexEntry* entry = match->entry;
+    WffParseTreeNode* bindings[WFF_VARIABLE_COUNT] = {NULL};
+    for (size_t k = 0; k < entry->var_count; k++) {
+        bindings[entry->vars[k]->id] = match->bindings[k];
+    }
+    WffParseTreeNode* replacement = _wff_instantiate(wff->parse_tree->nodes, entry->replace, bindings);
+    *var_count = wff->var_count - _wff_count_propositions(match->subwff_root) + _wff_count_propositions(replacement);
+    size_t ordinal = 0;
+    return _wff_replace_site(wff->parse_tree->nodes, wff->parse_tree->root, &ordinal, match->site, replacement);
+}
+
+
+/* === WffRuleMatchList === */
+
+WffRuleMatchList* wff_rule_match_list_create() {
+    WffRuleMatchList* list = malloc(sizeof(WffRuleMatchList));
+    wff_vector_init(&list->matches, sizeof(WffRuleMatch*), NULL);
+    return list;
+}
+
+void wff_rule_match_list_destroy(WffRuleMatchList* list) {
+    wff_vector_finish(&list->matches);
+    free(list);
+}
+
+void wff_rule_match_list_append(WffRuleMatchList* list, WffRuleMatch* match) {
+    wff_vector_append(&list->matches, &match);
+}
+
+WffRuleMatch* wff_rule_match_list_get(WffRuleMatchList* list, size_t index) {
+    WffRuleMatch** match = wff_vector_get(&list->matches, index);
+    return match == NULL ? NULL : *match;
+}
+
+WffVectorIterator wff_rule_match_list_iterate(WffRuleMatchList* list) {
+    return wff_vector_iterate(&list->matches);
+}
+
+WffRuleMatch* wff_rule_match_list_next(WffVectorIterator* iterator) {
+    WffRuleMatch** match = wff_vector_iterator_next(iterator);
+    return match == NULL ? NULL : *match;
+}
+
+size_t wff_rule_match_list_length(WffRuleMatchList* list) {
+    return list->matches.length;
+}
@@ -0,0 +1,50 @@
+#ifndef RULES_H_
+#define RULES_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "logic.h"
+
+
+typedef struct WffRule WffRule;
+typedef struct WffRuleIndex WffRuleIndex;
+typedef struct WffRuleMatch WffRuleMatch;
+typedef struct WffRuleMatchList WffRuleMatchList;
+
+
+// An equivalence law 'left <=> right'. Letters on either side are pattern
+// variables, except for the constants T and F.
+struct WffRule {
+    const char* name;
+    const char* description;
+    const char* left;
+    const char* right;
+};
+
+extern const WffRule WFF_RULES[];
+extern const size_t WFF_RULE_COUNT;
+
+const WffRule* wff_rule_find(const char* name);
+
+WffRuleIndex* wff_rule_index_create(const WffRule* rules, size_t rule_count);
+void wff_rule_index_destroy(WffRuleIndex* index);
+WffRuleMatchList* wff_rule_index_match(WffRuleIndex* index, Wff* wff);
+bool wff_rule_verify(WffRuleIndex* index, Wff* source, const WffRule* rule, Wff* result, size_t* site);
+WffRuleMatchList* wff_rule_infer(WffRuleIndex* index, Wff* source, Wff* result);
+
+// NOTE: Does not free the rule or the bound subwffs, just the match itself
+void wff_rule_match_destroy(WffRuleMatch* match);
+const WffRule* wff_rule_match_get_rule(WffRuleMatch* match);
+void wff_rule_match_apply(Wff* wff, WffRuleMatch* match);
+Wff* wff_rule_match_rewrite(Wff* wff, WffRuleMatch* match);
+
+WffRuleMatchList* wff_rule_match_list_create();
+void wff_rule_match_list_destroy(WffRuleMatchList* list);
+void wff_rule_match_list_append(WffRuleMatchList* list, WffRuleMatch* match);
+WffRuleMatch* wff_rule_match_list_get(WffRuleMatchList* list, size_t index);
+WffVectorIterator wff_rule_match_list_iterate(WffRuleMatchList* list);
+WffRuleMatch* wff_rule_match_list_next(WffVectorIterator* iterator);
+size_t wff_rule_match_list_length(WffRuleMatchList* list);
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef RULES_INTERNAL_H_
+#define RULES_INTERNAL_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "logic_internal.h"
+#include "rules.h"
+
+typedef struct WffRuleIndexNode WffRuleIndexNode;
+typedef struct WffRuleIndexEntry WffRuleIndexEntry;
+typedef struct WffRuleIndexSearch WffRuleIndexSearch;
+
+// Symbols of the preorder strings stored in the index. Parentheses are left
+// out: each nonterminal contributes one symbol and its operands follow it.
+typedef enum {
+    WRS_WILDCARD,
+    WRS_ATOM,
+    WRS_TRUE,
+    WRS_FALSE,
+    WRS_NOT,
+    WRS_AND,
+    WRS_OR,
+    WRS_COND,
+    WRS_BICOND,
+    WRS_COUNT
+} WffRuleSymbol;
+
+
+/* === WffRule === */
+bool _wff_rule_is_symmetric(const char* search, const char* replace);
+void _wff_rule_canonicalize(const char* search, const char* string, char* out);
+
+
+/* === WffRuleIndex === */
+// Discrimination tree over the search side of every rule, in both directions.
+// A path from the root spells a pattern in preorder with each variable
+// replaced by a wildcard; patterns that only differ in which variables repeat
+// share a leaf, and the repeats are checked when the leaf is reached.
+struct WffRuleIndex {
+    WffArena* arena;
+    WffNodeTable* nodes;
+    WffRuleIndexNode* root;
+    size_t entry_count;
+    // Longest pattern (in symbols), which bounds the search stacks.
+    size_t max_length;
+};
+
+struct WffRuleIndexNode {
+    WffRuleIndexNode* children[WRS_COUNT];
+    WffRuleIndexEntry* entries;
+};
+
+// One direction of one rule.
+struct WffRuleIndexEntry {
+    const WffRule* rule;
+    bool reverse;
+    WffParseTreeNode* replace;
+    // Distinct variables of the search side.
+    size_t var_count;
+    WffTokenVariable** vars;
+    // For each wildcard in the path, in order, its index into 'vars'.
+    size_t wildcard_count;
+    size_t* wildcard_vars;
+    WffRuleIndexEntry* next;
+};
+
+// State shared by one traversal of a wff. When explaining a rewrite, only
+// matches of 'rule' (if given) whose outcome is 'target' are reported.
+struct WffRuleIndexSearch {
+    WffParseTreeNode* subwff_root;
+    size_t site;
+    WffParseTreeNode** wildcards;
+    WffRuleMatchList* list;
+    const WffRule* rule;
+    WffParseTreeNode* target;
+};
+
+void _wff_rule_index_add(WffRuleIndex* index, const WffRule* rule, bool reverse);
+void _wff_rule_index_flatten(WffParseTreeNode* node, WffRuleSymbol* symbols, WffTokenVariable** wildcards, size_t* symbol_count, size_t* wildcard_count);
+void _wff_rule_index_traversal(WffRuleIndex* index, WffParseTreeNode* node, WffRuleIndexSearch* search, size_t* site);
+void _wff_rule_index_retrieve(WffRuleIndexNode* trie_node, WffParseTreeNode** pending, size_t pending_count, size_t wildcard_count, WffRuleIndexSearch* search);
+void _wff_rule_index_report(WffRuleIndexEntry* entry, WffRuleIndexSearch* search);
+WffRuleMatchList* _wff_rule_index_explain(WffRuleIndex* index, Wff* source, Wff* result, const WffRule* rule);
+void _wff_rule_index_explain_site(WffRuleIndex* index, WffParseTreeNode* source, WffParseTreeNode* result, size_t site, WffRuleIndexSearch* search);
+void _wff_rule_index_explain_unchanged(WffRuleIndex* index, WffParseTreeNode* node, WffRuleIndexSearch* search, size_t* site);
+bool _wff_rule_same_subwff(WffParseTreeNode* node1, WffParseTreeNode* node2);
+bool _wff_rule_index_outcome_equals(WffRuleIndexEntry* entry, WffParseTreeNode* template_node, WffParseTreeNode** bindings, WffParseTreeNode* target);
+WffRuleSymbol _wff_rule_symbol(WffParseTreeNode* node, WffParseTreeNode** operands, size_t* operand_count);
+
+
+/* === WffRuleMatch === */
+struct WffRuleMatch {
+    WffRuleIndexEntry* entry;
+    // Root of the matched subwff and its preorder position among the wff's
+    // nonterminals (see WffMatch).
+    WffParseTreeNode* subwff_root;
+    size_t site;
+    // Subwff bound to each of entry->vars.
+    WffParseTreeNode** bindings;
+};
+
+WffParseTreeNode* _wff_rule_match_rewrite_root(Wff* wff, WffRuleMatch* match, size_t* var_count);
+
+
+/* === WffRuleMatchList === */
+struct WffRuleMatchList {
+    WffVector matches;
+};
+
+#endif
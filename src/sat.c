@@ -0,0 +1,853 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "logic_internal.h"
+#include "eval.h"
+#include "sat.h"
+#include "sat_internal.h"
+
+// Initial capacities; they double as they fill.
+#define WFF_CNF_MIN_CAPACITY 64
+#define WFF_SAT_MIN_CAPACITY 256
+#define WFF_SAT_WATCH_MIN_CAPACITY 4
+// Conflicts per unit of the Luby sequence between restarts.
+#define WFF_SAT_RESTART_BASE 100
+// Variable activities are scaled up by 1 / decay after every conflict, which
+// decays older bumps relative to newer ones.
+#define WFF_SAT_ACTIVITY_DECAY 0.95
+#define WFF_SAT_ACTIVITY_LIMIT 1e100
+// Learned clauses allowed before the first reduction; the limit grows by a
+// tenth after each one.
+#define WFF_SAT_LEARNED_MIN 2000
+
+
+/* === Wff === */
+
+bool wff_sat_is_satisfiable(Wff* wff, WffEvalAssignment* model) {
+    return _wff_sat_check(wff, NULL, false, model);
+}
+
+bool wff_sat_is_valid(Wff* wff, WffEvalAssignment* counterexample) {
+    return !_wff_sat_check(wff, NULL, true, counterexample);
+}
+
+bool wff_sat_equivalent(Wff* wff1, Wff* wff2, WffEvalAssignment* counterexample) {
+    return !_wff_sat_check(wff1, wff2, true, counterexample);
+}
+
+// Looks for an assignment that makes 'wff1' true, or false if 'valid' is set,
+// or, if 'wff2' is given, that gives 'wff1' and 'wff2' different values.
+bool _wff_sat_check(Wff* wff1, Wff* wff2, bool valid, WffEvalAssignment* assignment) {
+    WffCnf* cnf = wff_cnf_create();
+    WffTseitin encoder;
+    size_t node_count = wff1->parse_tree->nodes->count + (wff2 == NULL ? 0 : wff2->parse_tree->nodes->count);
+    _wff_tseitin_init(&encoder, cnf, node_count);
+    int root = _wff_tseitin_encode(&encoder, wff1->parse_tree->root);
+    if (wff2 != NULL) {
+        int root2 = _wff_tseitin_encode(&encoder, wff2->parse_tree->root);
+        int differ[2][2] = {{root, root2}, {-root, -root2}};
+        wff_cnf_add_clause(cnf, differ[0], 2);
+        wff_cnf_add_clause(cnf, differ[1], 2);
+    } else {
+        int goal = valid ? -root : root;
+        wff_cnf_add_clause(cnf, &goal, 1);
+    }
+
+    bool* model = malloc((cnf->var_count + 1) * sizeof(bool));
+    bool found = wff_sat_solve(cnf, model);
+    if (found && assignment != NULL) {
+        _wff_tseitin_assignment(&encoder, model, assignment);
+    }
+    free(model);
+    _wff_tseitin_finish(&encoder);
+    wff_cnf_destroy(cnf);
+    return found;
+}
+
+
+/* === WffCnf === */
+
+WffCnf* wff_cnf_create() {
+    WffCnf* cnf = malloc(sizeof(WffCnf));
+    cnf->var_count = 0;
+    cnf->literal_capacity = WFF_CNF_MIN_CAPACITY;
+    cnf->literals = malloc(cnf->literal_capacity * sizeof(int));
+    cnf->literal_count = 0;
+    cnf->clause_capacity = WFF_CNF_MIN_CAPACITY;
+    cnf->starts = malloc((cnf->clause_capacity + 1) * sizeof(size_t));
+    cnf->starts[0] = 0;
+    cnf->clause_count = 0;
+    return cnf;
+}
+
+void wff_cnf_destroy(WffCnf* cnf) {
+    free(cnf->literals);
+    free(cnf->starts);
+    free(cnf);
+}
+
+int wff_cnf_new_var(WffCnf* cnf) {
+    cnf->var_count++;
+    return cnf->var_count;
+}
+
+void wff_cnf_add_clause(WffCnf* cnf, const int* literals, size_t count) {
+    if (cnf->literal_count + count > cnf->literal_capacity) {
+        while (cnf->literal_count + count > cnf->literal_capacity) {
+            cnf->literal_capacity *= 2;
+        }
+        cnf->literals = realloc(cnf->literals, cnf->literal_capacity * sizeof(int));
+    }
+    if (cnf->clause_count == cnf->clause_capacity) {
+        cnf->clause_capacity *= 2;
+        cnf->starts = realloc(cnf->starts, (cnf->clause_capacity + 1) * sizeof(size_t));
+    }
+    memcpy(cnf->literals + cnf->literal_count, literals, count * sizeof(int));
+    cnf->literal_count += count;
+    cnf->clause_count++;
+    cnf->starts[cnf->clause_count] = cnf->literal_count;
+}
+
+size_t wff_cnf_var_count(const WffCnf* cnf) {
+    return cnf->var_count;
+}
+
+size_t wff_cnf_clause_count(const WffCnf* cnf) {
+    return cnf->clause_count;
+}
+
+// Writes the CNF in DIMACS format: a "p cnf <variables> <clauses>" line, then
+// each clause as its literals followed by 0.
+void wff_cnf_write_dimacs(const WffCnf* cnf, FILE* file) {
+    fprintf(file, "p cnf %zu %zu\n", cnf->var_count, cnf->clause_count);
+    for (size_t i = 0; i < cnf->clause_count; i++) {
+        for (size_t j = cnf->starts[i]; j < cnf->starts[i + 1]; j++) {
+            fprintf(file, "%d ", cnf->literals[j]);
+        }
+        fprintf(file, "0\n");
+    }
+}
+
+bool wff_sat_solve(const WffCnf* cnf, bool* model) {
+    WffSatSolver* solver = _wff_sat_solver_create(cnf->var_count);
+    for (size_t i = 0; i < cnf->clause_count; i++) {
+        size_t start = cnf->starts[i];
+        _wff_sat_solver_add_clause(solver, cnf->literals + start, cnf->starts[i + 1] - start);
+    }
+    bool satisfiable = _wff_sat_solver_solve(solver);
+    if (satisfiable && model != NULL) {
+        for (size_t v = 0; v < cnf->var_count; v++) {
+            model[v + 1] = solver->values[v] == WSV_TRUE;
+        }
+    }
+    _wff_sat_solver_destroy(solver);
+    return satisfiable;
+}
+
+
+/* === WffTseitin === */
+
+// 'node_count' is about how many distinct nodes will be encoded.
+void _wff_tseitin_init(WffTseitin* encoder, WffCnf* cnf, size_t node_count) {
+    encoder->cnf = cnf;
+    wff_node_map_init(&encoder->entries, sizeof(WffTseitinEntry), node_count);
+    memset(encoder->variables, 0, sizeof(encoder->variables));
+    encoder->true_var = 0;
+}
+
+void _wff_tseitin_finish(WffTseitin* encoder) {
+    wff_node_map_finish(&encoder->entries);
+}
+
+// Returns a CNF literal that is true exactly when the subwff rooted at 'node'
+// is, adding the clauses that make it so.
+int _wff_tseitin_encode(WffTseitin* encoder, WffParseTreeNode* node) {
+    return _wff_tseitin_encode_polarity(encoder, node, WFF_TSEITIN_BOTH);
+}
+
+// Returns a CNF literal for the subwff rooted at 'node', adding only the
+// clauses its polarity calls for: with WFF_TSEITIN_POSITIVE the literal
+// implies the subwff, and with WFF_TSEITIN_NEGATIVE the subwff implies it.
+int _wff_tseitin_encode_polarity(WffTseitin* encoder, WffParseTreeNode* node, uint8_t polarity) {
+    WffTseitinEntry* entry = wff_node_map_get(&encoder->entries, node);
+    if (entry != NULL) {
+        int literal = entry->literal;
+        uint8_t missing = polarity & ~entry->polarities;
+        if (missing != 0) {
+            // Recorded before adding the clauses, which may add other keys
+            // and move the entry.
+            entry->polarities |= missing;
+            if (node->child_count == 2) {
+                _wff_tseitin_encode_polarity(encoder, node->children[1], _wff_tseitin_flip(missing));
+            } else if (node->child_count == 5) {
+                _wff_tseitin_define(encoder, node, literal, missing);
+            }
+        }
+        return literal;
+    }
+
+    WffCnf* cnf = encoder->cnf;
+    int result;
+    if (node->child_count == 1) {
+        WffToken* token = node->children[0]->token;
+        if (token->type == WTT_CONSTANT) {
+            if (encoder->true_var == 0) {
+                encoder->true_var = wff_cnf_new_var(cnf);
+                wff_cnf_add_clause(cnf, &encoder->true_var, 1);
+            }
+            result = token->value ? encoder->true_var : -encoder->true_var;
+        } else {
+            size_t id = token->variable->id;
+            if (encoder->variables[id] == 0) {
+                encoder->variables[id] = wff_cnf_new_var(cnf);
+            }
+            result = encoder->variables[id];
+        }
+        // A variable stands for itself whichever way it appears.
+        polarity = WFF_TSEITIN_BOTH;
+    } else if (node->child_count == 2) {
+        result = -_wff_tseitin_encode_polarity(encoder, node->children[1], _wff_tseitin_flip(polarity));
+    } else {
+        result = _wff_tseitin_define(encoder, node, 0, polarity);
+    }
+
+    entry = wff_node_map_put(&encoder->entries, node);
+    entry->literal = result;
+    entry->polarities = polarity;
+    return result;
+}
+
+// Adds the halves of the constraint 'x <=> node' that 'polarity' calls for,
+// encoding the operands of the binary subwff as needed. If 'x' is 0 a new
+// variable is made for it, after the operands'. Returns 'x'.
+int _wff_tseitin_define(WffTseitin* encoder, WffParseTreeNode* node, int x, uint8_t polarity) {
+    WffCnf* cnf = encoder->cnf;
+    WffOperator operator = node->children[2]->token->operator;
+    uint8_t left_polarity = polarity;
+    uint8_t right_polarity = polarity;
+    if (operator == WO_COND) {
+        left_polarity = _wff_tseitin_flip(polarity);
+    } else if (operator == WO_BICOND) {
+        left_polarity = WFF_TSEITIN_BOTH;
+        right_polarity = WFF_TSEITIN_BOTH;
+    }
+    int a = _wff_tseitin_encode_polarity(encoder, node->children[1], left_polarity);
+    int b = _wff_tseitin_encode_polarity(encoder, node->children[3], right_polarity);
+    if (x == 0) {
+        x = wff_cnf_new_var(cnf);
+    }
+
+    bool positive = polarity & WFF_TSEITIN_POSITIVE;
+    bool negative = polarity & WFF_TSEITIN_NEGATIVE;
+    switch (operator) {
+        case WO_COND:
+            // (a => b) is (~a v b).
+            a = -a;
+            // fall through
+        case WO_OR: {
+            int clauses[3][3] = {{-x, a, b}, {x, -a}, {x, -b}};
+            if (positive) {
+                wff_cnf_add_clause(cnf, clauses[0], 3);
+            }
+            if (negative) {
+                wff_cnf_add_clause(cnf, clauses[1], 2);
+                wff_cnf_add_clause(cnf, clauses[2], 2);
+            }
+            break;
+        }
+        case WO_AND: {
+            int clauses[3][3] = {{x, -a, -b}, {-x, a}, {-x, b}};
+            if (negative) {
+                wff_cnf_add_clause(cnf, clauses[0], 3);
+            }
+            if (positive) {
+                wff_cnf_add_clause(cnf, clauses[1], 2);
+                wff_cnf_add_clause(cnf, clauses[2], 2);
+            }
+            break;
+        }
+        case WO_BICOND: {
+            int clauses[4][3] = {{-x, -a, b}, {-x, a, -b}, {x, a, b}, {x, -a, -b}};
+            for (int k = positive ? 0 : 2; k < (negative ? 4 : 2); k++) {
+                wff_cnf_add_clause(cnf, clauses[k], 3);
+            }
+            break;
+        }
+        default:
+            printf("ERROR: Unhandled case\n");
+            abort();
+    }
+    return x;
+}
+
+uint8_t _wff_tseitin_flip(uint8_t polarity) {
+    return ((polarity & WFF_TSEITIN_POSITIVE) ? WFF_TSEITIN_NEGATIVE : 0) | ((polarity & WFF_TSEITIN_NEGATIVE) ? WFF_TSEITIN_POSITIVE : 0);
+}
+
+// Reads the values of the wff variables encoded so far out of a CNF model, in
+// alphabetical order.
+void _wff_tseitin_assignment(const WffTseitin* encoder, const bool* model, WffEvalAssignment* out) {
+    out->var_count = 0;
+    for (size_t id = 0; id < WFF_VARIABLE_COUNT; id++) {
+        if (encoder->variables[id] != 0) {
+            out->names[out->var_count] = WFF_VARIABLES[id].string[0];
+            out->values[out->var_count] = model[encoder->variables[id]];
+            out->var_count++;
+        }
+    }
+}
+
+
+/* === WffSatSolver === */
+
+WffSatSolver* _wff_sat_solver_create(size_t var_count) {
+    WffSatSolver* solver = malloc(sizeof(WffSatSolver));
+    solver->var_count = var_count;
+    solver->unsat = false;
+    solver->clauses_capacity = WFF_SAT_MIN_CAPACITY;
+    solver->clauses = malloc(solver->clauses_capacity * sizeof(uint32_t));
+    solver->clauses_length = 0;
+    solver->learned_count = 0;
+    solver->learned_limit = WFF_SAT_LEARNED_MIN;
+    solver->watches = calloc(2 * var_count, sizeof(WffSatWatchList));
+
+    solver->values = malloc(var_count * sizeof(uint8_t));
+    memset(solver->values, WSV_UNDEF, var_count * sizeof(uint8_t));
+    solver->levels = calloc(var_count, sizeof(uint32_t));
+    solver->reasons = malloc(var_count * sizeof(uint32_t));
+    solver->phases = calloc(var_count, sizeof(bool));
+    solver->activity = calloc(var_count, sizeof(double));
+    solver->heap_index = malloc(var_count * sizeof(int));
+    solver->activity_increment = 1;
+
+    solver->trail = malloc(var_count * sizeof(uint32_t));
+    solver->trail_length = 0;
+    solver->propagate_head = 0;
+    solver->trail_limits = malloc((var_count + 1) * sizeof(size_t));
+    solver->level = 0;
+
+    solver->heap = malloc(var_count * sizeof(uint32_t));
+    solver->heap_length = 0;
+    for (uint32_t v = 0; v < var_count; v++) {
+        solver->heap_index[v] = -1;
+        _wff_sat_heap_insert(solver, v);
+    }
+
+    solver->seen = calloc(var_count, sizeof(bool));
+    solver->learned = malloc((var_count + 1) * sizeof(uint32_t));
+    solver->level_stamps = calloc(var_count + 1, sizeof(uint32_t));
+    solver->stamp = 0;
+    return solver;
+}
+
+void _wff_sat_solver_destroy(WffSatSolver* solver) {
+    for (size_t i = 0; i < 2 * solver->var_count; i++) {
+        free(solver->watches[i].watches);
+    }
+    free(solver->watches);
+    free(solver->clauses);
+    free(solver->values);
+    free(solver->levels);
+    free(solver->reasons);
+    free(solver->phases);
+    free(solver->activity);
+    free(solver->heap_index);
+    free(solver->trail);
+    free(solver->trail_limits);
+    free(solver->heap);
+    free(solver->seen);
+    free(solver->learned);
+    free(solver->level_stamps);
+    free(solver);
+}
+
+// Adds a clause of DIMACS literals before solving. Duplicate literals are
+// dropped, as are clauses that are always true or already satisfied, and
+// literals already false are removed; what is left of a unit clause is
+// assigned and propagated right away.
+void _wff_sat_solver_add_clause(WffSatSolver* solver, const int* literals, size_t count) {
+    if (solver->unsat) {
+        return;
+    }
+    uint32_t* clause = solver->learned;
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        int literal = literals[i];
+        uint32_t internal = literal > 0 ? 2 * (literal - 1) : 2 * (-literal - 1) + 1;
+        WffSatValue value = _wff_sat_solver_value(solver, internal);
+        if (value == WSV_TRUE) {
+            return;
+        } else if (value == WSV_FALSE) {
+            continue;
+        }
+        bool duplicate = false;
+        for (size_t j = 0; j < length; j++) {
+            if (clause[j] == (internal ^ 1)) {
+                return;
+            } else if (clause[j] == internal) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate) {
+            clause[length] = internal;
+            length++;
+        }
+    }
+
+    if (length == 0) {
+        solver->unsat = true;
+    } else if (length == 1) {
+        _wff_sat_solver_enqueue(solver, clause[0], WFF_SAT_NO_REASON);
+        if (_wff_sat_solver_propagate(solver) != WFF_SAT_NO_REASON) {
+            solver->unsat = true;
+        }
+    } else {
+        _wff_sat_solver_store(solver, clause, length, WFF_SAT_ORIGINAL);
+    }
+}
+
+bool _wff_sat_solver_solve(WffSatSolver* solver) {
+    if (solver->unsat) {
+        return false;
+    }
+    size_t restarts = 0;
+    size_t conflicts = 0;
+    size_t conflict_limit = WFF_SAT_RESTART_BASE * _wff_sat_luby(restarts);
+    while (true) {
+        uint32_t conflict = _wff_sat_solver_propagate(solver);
+        if (conflict != WFF_SAT_NO_REASON) {
+            if (solver->level == 0) {
+                solver->unsat = true;
+                return false;
+            }
+            conflicts++;
+            size_t backjump_level;
+            uint32_t lbd;
+            size_t length = _wff_sat_solver_analyze(solver, conflict, &backjump_level, &lbd);
+            _wff_sat_solver_backtrack(solver, backjump_level);
+            if (length == 1) {
+                _wff_sat_solver_enqueue(solver, solver->learned[0], WFF_SAT_NO_REASON);
+            } else {
+                uint32_t clause = _wff_sat_solver_store(solver, solver->learned, length, lbd);
+                _wff_sat_solver_enqueue(solver, solver->learned[0], clause);
+                solver->learned_count++;
+            }
+            solver->activity_increment /= WFF_SAT_ACTIVITY_DECAY;
+            continue;
+        }
+
+        if (conflicts >= conflict_limit) {
+            _wff_sat_solver_backtrack(solver, 0);
+            restarts++;
+            conflicts = 0;
+            conflict_limit = WFF_SAT_RESTART_BASE * _wff_sat_luby(restarts);
+        }
+        if (solver->learned_count >= solver->learned_limit) {
+            _wff_sat_solver_reduce(solver);
+        }
+
+        uint32_t var = UINT32_MAX;
+        while (solver->heap_length > 0) {
+            var = _wff_sat_heap_pop(solver);
+            if (solver->values[var] == WSV_UNDEF) {
+                break;
+            }
+            var = UINT32_MAX;
+        }
+        if (var == UINT32_MAX) {
+            return true;
+        }
+        solver->trail_limits[solver->level] = solver->trail_length;
+        solver->level++;
+        _wff_sat_solver_enqueue(solver, 2 * var + !solver->phases[var], WFF_SAT_NO_REASON);
+    }
+}
+
+WffSatValue _wff_sat_solver_value(const WffSatSolver* solver, uint32_t literal) {
+    uint8_t value = solver->values[literal >> 1];
+    if (value == WSV_UNDEF) {
+        return WSV_UNDEF;
+    }
+    return value ^ (literal & 1);
+}
+
+void _wff_sat_solver_enqueue(WffSatSolver* solver, uint32_t literal, uint32_t reason) {
+    uint32_t var = literal >> 1;
+    solver->values[var] = !(literal & 1);
+    solver->levels[var] = solver->level;
+    solver->reasons[var] = reason;
+    solver->trail[solver->trail_length] = literal;
+    solver->trail_length++;
+}
+
+// Copies a clause of at least two literals into the database and watches its
+// first two literals. Returns its offset.
+uint32_t _wff_sat_solver_store(WffSatSolver* solver, const uint32_t* literals, size_t count, uint32_t tier) {
+    size_t needed = solver->clauses_length + WFF_SAT_HEADER + count;
+    if (needed > solver->clauses_capacity) {
+        while (needed > solver->clauses_capacity) {
+            solver->clauses_capacity *= 2;
+        }
+        solver->clauses = realloc(solver->clauses, solver->clauses_capacity * sizeof(uint32_t));
+    }
+    uint32_t offset = solver->clauses_length;
+    solver->clauses[offset] = count;
+    solver->clauses[offset + 1] = tier;
+    memcpy(solver->clauses + offset + WFF_SAT_HEADER, literals, count * sizeof(uint32_t));
+    solver->clauses_length = needed;
+    _wff_sat_watch_list_push(&solver->watches[literals[0]], offset, literals[1]);
+    _wff_sat_watch_list_push(&solver->watches[literals[1]], offset, literals[0]);
+    return offset;
+}
+
+// Assigns the literals implied by the trail. Returns a clause made false, or
+// WFF_SAT_NO_REASON if there is none.
+//
+// A clause is watched by two of its literals, kept first. It only needs to be
+// looked at when one of them becomes false: then either another literal that
+// isn't false takes over the watch, or the clause is a conflict or implies
+// its other watched literal.
+uint32_t _wff_sat_solver_propagate(WffSatSolver* solver) {
+    uint32_t conflict = WFF_SAT_NO_REASON;
+    while (solver->propagate_head < solver->trail_length && conflict == WFF_SAT_NO_REASON) {
+        uint32_t false_literal = solver->trail[solver->propagate_head] ^ 1;
+        solver->propagate_head++;
+        WffSatWatchList* list = &solver->watches[false_literal];
+        WffSatWatch* watches = list->watches;
+        size_t kept = 0;
+        size_t i = 0;
+        while (i < list->count) {
+            WffSatWatch watch = watches[i];
+            i++;
+            if (_wff_sat_solver_value(solver, watch.blocker) == WSV_TRUE) {
+                watches[kept] = watch;
+                kept++;
+                continue;
+            }
+            uint32_t offset = watch.clause;
+            uint32_t size = solver->clauses[offset];
+            uint32_t* literals = solver->clauses + offset + WFF_SAT_HEADER;
+            if (literals[0] == false_literal) {
+                literals[0] = literals[1];
+                literals[1] = false_literal;
+            }
+            watch.blocker = literals[0];
+            if (_wff_sat_solver_value(solver, literals[0]) == WSV_TRUE) {
+                watches[kept] = watch;
+                kept++;
+                continue;
+            }
+
+            bool moved = false;
+            for (uint32_t k = 2; k < size; k++) {
+                if (_wff_sat_solver_value(solver, literals[k]) != WSV_FALSE) {
+                    literals[1] = literals[k];
+                    literals[k] = false_literal;
+                    _wff_sat_watch_list_push(&solver->watches[literals[1]], offset, literals[0]);
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved) {
+                continue;
+            }
+
+            watches[kept] = watch;
+            kept++;
+            if (_wff_sat_solver_value(solver, literals[0]) == WSV_FALSE) {
+                conflict = offset;
+                while (i < list->count) {
+                    watches[kept] = watches[i];
+                    kept++;
+                    i++;
+                }
+            } else {
+                _wff_sat_solver_enqueue(solver, literals[0], offset);
+            }
+        }
+        list->count = kept;
+    }
+    return conflict;
+}
+
+// Learns a clause from a conflict by resolving it with the reasons of the
+// literals assigned at the current level, latest first, until one literal of
+// that level is left (the first unique implication point). The clause is
+// written to solver->learned with that literal first and a literal of the
+// level to backjump to second. Returns its length.
+size_t _wff_sat_solver_analyze(WffSatSolver* solver, uint32_t conflict, size_t* backjump_level, uint32_t* lbd) {
+    uint32_t* learned = solver->learned;
+    size_t length = 1;
+    size_t pending = 0;
+    size_t index = solver->trail_length;
+    uint32_t literal = UINT32_MAX;
+    do {
+        uint32_t size = solver->clauses[conflict];
+        uint32_t* literals = solver->clauses + conflict + WFF_SAT_HEADER;
+        // Apart from a conflict, the first literal of a reason is the one it
+        // implied, which is being resolved away.
+        for (uint32_t k = literal == UINT32_MAX ? 0 : 1; k < size; k++) {
+            uint32_t var = literals[k] >> 1;
+            if (!solver->seen[var] && solver->levels[var] > 0) {
+                solver->seen[var] = true;
+                _wff_sat_solver_bump(solver, var);
+                if (solver->levels[var] == solver->level) {
+                    pending++;
+                } else {
+                    learned[length] = literals[k];
+                    length++;
+                }
+            }
+        }
+        do {
+            index--;
+        } while (!solver->seen[solver->trail[index] >> 1]);
+        literal = solver->trail[index];
+        conflict = solver->reasons[literal >> 1];
+        solver->seen[literal >> 1] = false;
+        pending--;
+    } while (pending > 0);
+    learned[0] = literal ^ 1;
+
+    size_t full_length = length;
+    length = _wff_sat_solver_minimize(solver, length);
+    for (size_t k = 1; k < full_length; k++) {
+        solver->seen[learned[k] >> 1] = false;
+    }
+
+    solver->stamp++;
+    solver->level_stamps[solver->level] = solver->stamp;
+    *lbd = 1;
+    *backjump_level = 0;
+    for (size_t k = 1; k < length; k++) {
+        uint32_t level = solver->levels[learned[k] >> 1];
+        if (solver->level_stamps[level] != solver->stamp) {
+            solver->level_stamps[level] = solver->stamp;
+            (*lbd)++;
+        }
+        if (level > *backjump_level) {
+            *backjump_level = level;
+            uint32_t swap = learned[1];
+            learned[1] = learned[k];
+            learned[k] = swap;
+        }
+    }
+    return length;
+}
+
+// Drops the literals of a learned clause of 'length' literals that are implied
+// by the others: those whose reason has no other literals than ones in the
+// clause or assigned at level 0. The dropped literals are moved past the new
+// length, which is returned, so their marks can still be cleared.
+size_t _wff_sat_solver_minimize(WffSatSolver* solver, size_t length) {
+    uint32_t* learned = solver->learned;
+    size_t k = 1;
+    while (k < length) {
+        uint32_t reason = solver->reasons[learned[k] >> 1];
+        bool implied = reason != WFF_SAT_NO_REASON;
+        if (implied) {
+            uint32_t size = solver->clauses[reason];
+            uint32_t* literals = solver->clauses + reason + WFF_SAT_HEADER;
+            for (uint32_t i = 1; i < size; i++) {
+                uint32_t var = literals[i] >> 1;
+                if (!solver->seen[var] && solver->levels[var] > 0) {
+                    implied = false;
+                    break;
+                }
+            }
+        }
+        if (implied) {
+            length--;
+            uint32_t swap = learned[k];
+            learned[k] = learned[length];
+            learned[length] = swap;
+        } else {
+            k++;
+        }
+    }
+    return length;
+}
+
+// Deletes the worse half of the learned clauses, keeping those with an LBD of
+// two or less and those that are the reason of an assignment, then compacts
+// the database and rebuilds the watch lists. Must be called after a
+// propagation that found no conflict.
+void _wff_sat_solver_reduce(WffSatSolver* solver) {
+    WffSatCandidate* candidates = malloc(solver->learned_count * sizeof(WffSatCandidate));
+    size_t candidate_count = 0;
+    size_t offset = 0;
+    while (offset < solver->clauses_length) {
+        uint32_t size = solver->clauses[offset];
+        uint32_t tier = solver->clauses[offset + 1];
+        uint32_t first = solver->clauses[offset + WFF_SAT_HEADER];
+        bool locked = solver->reasons[first >> 1] == offset && _wff_sat_solver_value(solver, first) == WSV_TRUE;
+        if (tier > 2 && !locked) {
+            candidates[candidate_count].offset = offset;
+            candidates[candidate_count].tier = tier;
+            candidates[candidate_count].size = size;
+            candidate_count++;
+        }
+        offset += WFF_SAT_HEADER + size;
+    }
+    qsort(candidates, candidate_count, sizeof(WffSatCandidate), _wff_sat_candidate_compare);
+    for (size_t i = 0; i < candidate_count / 2; i++) {
+        solver->clauses[candidates[i].offset + 1] = WFF_SAT_DELETED;
+    }
+    solver->learned_count -= candidate_count / 2;
+    free(candidates);
+
+    for (size_t i = 0; i < 2 * solver->var_count; i++) {
+        solver->watches[i].count = 0;
+    }
+    size_t length = 0;
+    offset = 0;
+    while (offset < solver->clauses_length) {
+        uint32_t size = solver->clauses[offset];
+        uint32_t tier = solver->clauses[offset + 1];
+        if (tier != WFF_SAT_DELETED) {
+            uint32_t* literals = solver->clauses + length + WFF_SAT_HEADER;
+            memmove(solver->clauses + length, solver->clauses + offset, (WFF_SAT_HEADER + size) * sizeof(uint32_t));
+            // The literal a reason implied is always its first.
+            uint32_t var = literals[0] >> 1;
+            if (solver->reasons[var] == offset && _wff_sat_solver_value(solver, literals[0]) == WSV_TRUE) {
+                solver->reasons[var] = length;
+            }
+            _wff_sat_watch_list_push(&solver->watches[literals[0]], length, literals[1]);
+            _wff_sat_watch_list_push(&solver->watches[literals[1]], length, literals[0]);
+            length += WFF_SAT_HEADER + size;
+        }
+        offset += WFF_SAT_HEADER + size;
+    }
+    solver->clauses_length = length;
+    solver->learned_limit += solver->learned_limit / 10;
+}
+
+// Orders learned clauses from worst to best: highest LBD first, then longest.
+int _wff_sat_candidate_compare(const void* a, const void* b) {
+    const WffSatCandidate* x = a;
+    const WffSatCandidate* y = b;
+    if (x->tier != y->tier) {
+        return x->tier > y->tier ? -1 : 1;
+    }
+    if (x->size != y->size) {
+        return x->size > y->size ? -1 : 1;
+    }
+    return 0;
+}
+
+// Undoes every assignment above 'level', saving each variable's value as the
+// phase to try next.
+void _wff_sat_solver_backtrack(WffSatSolver* solver, size_t level) {
+    if (solver->level <= level) {
+        return;
+    }
+    size_t limit = solver->trail_limits[level];
+    for (size_t i = solver->trail_length; i > limit; i--) {
+        uint32_t var = solver->trail[i - 1] >> 1;
+        solver->phases[var] = solver->values[var] == WSV_TRUE;
+        solver->values[var] = WSV_UNDEF;
+        if (solver->heap_index[var] < 0) {
+            _wff_sat_heap_insert(solver, var);
+        }
+    }
+    solver->trail_length = limit;
+    solver->propagate_head = limit;
+    solver->level = level;
+}
+
+void _wff_sat_solver_bump(WffSatSolver* solver, uint32_t var) {
+    solver->activity[var] += solver->activity_increment;
+    if (solver->activity[var] > WFF_SAT_ACTIVITY_LIMIT) {
+        for (size_t v = 0; v < solver->var_count; v++) {
+            solver->activity[v] /= WFF_SAT_ACTIVITY_LIMIT;
+        }
+        solver->activity_increment /= WFF_SAT_ACTIVITY_LIMIT;
+    }
+    if (solver->heap_index[var] >= 0) {
+        _wff_sat_heap_sift_up(solver, solver->heap_index[var]);
+    }
+}
+
+void _wff_sat_watch_list_push(WffSatWatchList* list, uint32_t clause, uint32_t blocker) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity == 0 ? WFF_SAT_WATCH_MIN_CAPACITY : list->capacity * 2;
+        list->watches = realloc(list->watches, list->capacity * sizeof(WffSatWatch));
+    }
+    list->watches[list->count].clause = clause;
+    list->watches[list->count].blocker = blocker;
+    list->count++;
+}
+
+void _wff_sat_heap_insert(WffSatSolver* solver, uint32_t var) {
+    solver->heap[solver->heap_length] = var;
+    solver->heap_index[var] = solver->heap_length;
+    solver->heap_length++;
+    _wff_sat_heap_sift_up(solver, solver->heap_length - 1);
+}
+
+void _wff_sat_heap_sift_up(WffSatSolver* solver, size_t position) {
+    uint32_t var = solver->heap[position];
+    double activity = solver->activity[var];
+    while (position > 0) {
+        size_t parent = (position - 1) / 2;
+        if (solver->activity[solver->heap[parent]] >= activity) {
+            break;
+        }
+        solver->heap[position] = solver->heap[parent];
+        solver->heap_index[solver->heap[position]] = position;
+        position = parent;
+    }
+    solver->heap[position] = var;
+    solver->heap_index[var] = position;
+}
+
+void _wff_sat_heap_sift_down(WffSatSolver* solver, size_t position) {
+    uint32_t var = solver->heap[position];
+    double activity = solver->activity[var];
+    while (2 * position + 1 < solver->heap_length) {
+        size_t child = 2 * position + 1;
+        if (child + 1 < solver->heap_length && solver->activity[solver->heap[child + 1]] > solver->activity[solver->heap[child]]) {
+            child++;
+        }
+        if (solver->activity[solver->heap[child]] <= activity) {
+            break;
+        }
+        solver->heap[position] = solver->heap[child];
+        solver->heap_index[solver->heap[position]] = position;
+        position = child;
+    }
+    solver->heap[position] = var;
+    solver->heap_index[var] = position;
+}
+
+uint32_t _wff_sat_heap_pop(WffSatSolver* solver) {
+    uint32_t top = solver->heap[0];
+    solver->heap_index[top] = -1;
+    solver->heap_length--;
+    if (solver->heap_length > 0) {
+        solver->heap[0] = solver->heap[solver->heap_length];
+        _wff_sat_heap_sift_down(solver, 0);
+    }
+    return top;
+}
+
+// The i-th term (from 0) of the Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, ...
+size_t _wff_sat_luby(size_t i) {
+    size_t size = 1;
+    size_t power = 1;
+    while (size < i + 1) {
+        size = 2 * size + 1;
+        power *= 2;
+    }
+    while (size - 1 != i) {
+        size = (size - 1) / 2;
+        power /= 2;
+        i %= size;
+    }
+    return power;
+}
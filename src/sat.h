@@ -0,0 +1,34 @@
+#ifndef SAT_H_
+#define SAT_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "eval.h"
+
+
+typedef struct WffCnf WffCnf;
+
+
+// A formula in conjunctive normal form over variables 1 to var_count, with
+// literals written as in DIMACS: v for a variable and -v for its negation.
+WffCnf* wff_cnf_create();
+void wff_cnf_destroy(WffCnf* cnf);
+int wff_cnf_new_var(WffCnf* cnf);
+void wff_cnf_add_clause(WffCnf* cnf, const int* literals, size_t count);
+size_t wff_cnf_var_count(const WffCnf* cnf);
+size_t wff_cnf_clause_count(const WffCnf* cnf);
+void wff_cnf_write_dimacs(const WffCnf* cnf, FILE* file);
+
+// Fills model[1] to model[var_count] if satisfiable and 'model' isn't NULL.
+bool wff_sat_solve(const WffCnf* cnf, bool* model);
+
+// When the answer is "satisfiable" or "not valid/equivalent" and the
+// assignment isn't NULL, the assignment that shows it is written there.
+bool wff_sat_is_satisfiable(Wff* wff, WffEvalAssignment* model);
+bool wff_sat_is_valid(Wff* wff, WffEvalAssignment* counterexample);
+bool wff_sat_equivalent(Wff* wff1, Wff* wff2, WffEvalAssignment* counterexample);
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef SAT_INTERNAL_H_
+#define SAT_INTERNAL_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "logic_internal.h"
+#include "sat.h"
+
+typedef struct WffTseitin WffTseitin;
+typedef struct WffTseitinEntry WffTseitinEntry;
+typedef struct WffSatSolver WffSatSolver;
+typedef struct WffSatWatchList WffSatWatchList;
+typedef struct WffSatWatch WffSatWatch;
+typedef struct WffSatCandidate WffSatCandidate;
+
+// Polarities of a subwff in a Tseitin encoding (see WffTseitin).
+#define WFF_TSEITIN_POSITIVE 1
+#define WFF_TSEITIN_NEGATIVE 2
+#define WFF_TSEITIN_BOTH 3
+
+// Reason of a decision or of a literal assigned at level 0.
+#define WFF_SAT_NO_REASON UINT32_MAX
+// Words before the literals of a stored clause: its size, then its tier.
+#define WFF_SAT_HEADER 2
+// Tier of a clause from the input, and of a learned clause marked for
+// deletion; any other tier is the LBD of a learned clause.
+#define WFF_SAT_ORIGINAL 0
+#define WFF_SAT_DELETED UINT32_MAX
+
+typedef enum {
+    WSV_FALSE,
+    WSV_TRUE,
+    WSV_UNDEF
+} WffSatValue;
+
+
+/* === WffCnf === */
+struct WffCnf {
+    size_t var_count;
+    // Literals of every clause back to back: clause i is literals[starts[i]]
+    // to literals[starts[i + 1] - 1].
+    int* literals;
+    size_t literal_count;
+    size_t literal_capacity;
+    size_t* starts;
+    size_t clause_count;
+    size_t clause_capacity;
+};
+
+
+/* === WffTseitin === */
+// Encodes parse trees into a CNF with one variable per distinct binary
+// subwff, constrained to equal it, so the CNF stays linear in the size of the
+// hash-consed tree. Negations are just negated literals. Subwffs already
+// encoded are found in a node map.
+//
+// Following Plaisted and Greenbaum, a subwff that only ever appears with one
+// polarity needs only half of its constraint: its variable must imply it if it
+// appears positively (e.g. under ^ and v, or on the right of =>), and be
+// implied by it if it appears negatively (under ~ or on the left of =>).
+// The map records which halves each subwff has so far, and the rest is added
+// if it turns up with the other polarity later. The CNF is then only
+// equisatisfiable with the wff, but smaller.
+struct WffTseitin {
+    WffCnf* cnf;
+    WffNodeMap entries;
+    // CNF variable of each wff variable ID, or 0 if it hasn't appeared.
+    int variables[WFF_VARIABLE_COUNT];
+    // Variable forced true by a unit clause, made for the first constant.
+    int true_var;
+};
+
+struct WffTseitinEntry {
+    int literal;
+    uint8_t polarities;
+};
+
+void _wff_tseitin_init(WffTseitin* encoder, WffCnf* cnf, size_t node_count);
+void _wff_tseitin_finish(WffTseitin* encoder);
+int _wff_tseitin_encode(WffTseitin* encoder, WffParseTreeNode* node);
+int _wff_tseitin_encode_polarity(WffTseitin* encoder, WffParseTreeNode* node, uint8_t polarity);
+int _wff_tseitin_define(WffTseitin* encoder, WffParseTreeNode* node, int x, uint8_t polarity);
+uint8_t _wff_tseitin_flip(uint8_t polarity);
+void _wff_tseitin_assignment(const WffTseitin* encoder, const bool* model, WffEvalAssignment* out);
+bool _wff_sat_check(Wff* wff1, Wff* wff2, bool valid, WffEvalAssignment* assignment);
+
+
+/* === WffSatSolver === */
+// CDCL solver: two watched literals per clause, VSIDS branching with phase
+// saving, first-UIP clause learning with non-chronological backjumping and
+// Luby restarts. Literals are numbered 2v for variable v (from 0) and 2v + 1
+// for its negation.
+//
+// Learned clauses are ranked by LBD, the number of distinct decision levels
+// among their literals when learned: the lower, the more often they propagate.
+// Whenever there are more than 'learned_limit' of them, the worse half is
+// deleted and the database compacted.
+struct WffSatSolver {
+    size_t var_count;
+    bool unsat;
+    // Clause database: each clause is a header followed by its literals, and
+    // is referred to by its offset. The first two literals are watched.
+    uint32_t* clauses;
+    size_t clauses_length;
+    size_t clauses_capacity;
+    size_t learned_count;
+    size_t learned_limit;
+    // For each literal, the clauses watching it.
+    WffSatWatchList* watches;
+
+    // Per variable: value (WffSatValue), decision level, reason clause,
+    // saved phase, activity and position in the heap (-1 if not in it).
+    uint8_t* values;
+    uint32_t* levels;
+    uint32_t* reasons;
+    bool* phases;
+    double* activity;
+    int* heap_index;
+    double activity_increment;
+
+    // Assigned literals in order, and where each decision level starts.
+    uint32_t* trail;
+    size_t trail_length;
+    size_t propagate_head;
+    size_t* trail_limits;
+    size_t level;
+
+    // Max-heap of variables by activity.
+    uint32_t* heap;
+    size_t heap_length;
+
+    // Scratch space for conflict analysis: marks on variables, the clause
+    // being learned, and per decision level the last conflict that met it.
+    bool* seen;
+    uint32_t* learned;
+    uint32_t* level_stamps;
+    uint32_t stamp;
+};
+
+struct WffSatWatchList {
+    WffSatWatch* watches;
+    size_t count;
+    size_t capacity;
+};
+
+// A clause watching a literal, with another of its literals: if that one is
+// true the clause is satisfied and can be skipped without being read.
+struct WffSatWatch {
+    uint32_t clause;
+    uint32_t blocker;
+};
+
+// A learned clause that may be deleted when the database is reduced.
+struct WffSatCandidate {
+    uint32_t offset;
+    uint32_t tier;
+    uint32_t size;
+};
+
+WffSatSolver* _wff_sat_solver_create(size_t var_count);
+void _wff_sat_solver_destroy(WffSatSolver* solver);
+void _wff_sat_solver_add_clause(WffSatSolver* solver, const int* literals, size_t count);
+bool _wff_sat_solver_solve(WffSatSolver* solver);
+WffSatValue _wff_sat_solver_value(const WffSatSolver* solver, uint32_t literal);
+void _wff_sat_solver_enqueue(WffSatSolver* solver, uint32_t literal, uint32_t reason);
+uint32_t _wff_sat_solver_store(WffSatSolver* solver, const uint32_t* literals, size_t count, uint32_t tier);
+uint32_t _wff_sat_solver_propagate(WffSatSolver* solver);
+size_t _wff_sat_solver_analyze(WffSatSolver* solver, uint32_t conflict, size_t* backjump_level, uint32_t* lbd);
+size_t _wff_sat_solver_minimize(WffSatSolver* solver, size_t length);
+void _wff_sat_solver_reduce(WffSatSolver* solver);
+int _wff_sat_candidate_compare(const void* a, const void* b);
+void _wff_sat_solver_backtrack(WffSatSolver* solver, size_t level);
+void _wff_sat_solver_bump(WffSatSolver* solver, uint32_t var);
+void _wff_sat_watch_list_push(WffSatWatchList* list, uint32_t clause, uint32_t blocker);
+void _wff_sat_heap_insert(WffSatSolver* solver, uint32_t var);
+void _wff_sat_heap_sift_up(WffSatSolver* solver, size_t position);
+void _wff_sat_heap_sift_down(WffSatSolver* solver, size_t position);
+uint32_t _wff_sat_heap_pop(WffSatSolver* solver);
+size_t _wff_sat_luby(size_t i);
+
+#endif
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "stats.h"
+#include "stats_internal.h"
+
+WffStats WFF_STATS_TOTALS;
+
+
+/* === WffStats === */
+
+bool wff_stats_enabled() {
+#ifdef WFF_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Not safe while other threads are counting.
+void wff_stats_reset() {
+    memset(&WFF_STATS_TOTALS, 0, sizeof(WffStats));
+}
+
+void wff_stats_snapshot(WffStats* stats) {
+    stats->tokens_lexed = __atomic_load_n(&WFF_STATS_TOTALS.tokens_lexed, __ATOMIC_RELAXED);
+    stats->nodes_allocated = __atomic_load_n(&WFF_STATS_TOTALS.nodes_allocated, __ATOMIC_RELAXED);
+    stats->bytes_allocated = __atomic_load_n(&WFF_STATS_TOTALS.bytes_allocated, __ATOMIC_RELAXED);
+    stats->match_attempts = __atomic_load_n(&WFF_STATS_TOTALS.match_attempts, __ATOMIC_RELAXED);
+    stats->subtree_equals_calls = __atomic_load_n(&WFF_STATS_TOTALS.subtree_equals_calls, __ATOMIC_RELAXED);
+    stats->substitutions = __atomic_load_n(&WFF_STATS_TOTALS.substitutions, __ATOMIC_RELAXED);
+    for (WffStatsPhase phase = 0; phase < WSTP_COUNT; phase++) {
+        stats->phase_nanoseconds[phase] = __atomic_load_n(&WFF_STATS_TOTALS.phase_nanoseconds[phase], __ATOMIC_RELAXED);
+        stats->phase_calls[phase] = __atomic_load_n(&WFF_STATS_TOTALS.phase_calls[phase], __ATOMIC_RELAXED);
+    }
+}
+
+void wff_stats_print(const WffStats* stats, FILE* file) {
+    fprintf(file, "tokens lexed:          %zu\n", stats->tokens_lexed);
+    fprintf(file, "nodes allocated:       %zu\n", stats->nodes_allocated);
+    fprintf(file, "bytes allocated:       %zu\n", stats->bytes_allocated);
+    fprintf(file, "match attempts:        %zu\n", stats->match_attempts);
+    fprintf(file, "subtree_equals calls:  %zu\n", stats->subtree_equals_calls);
+    fprintf(file, "substitutions:         %zu\n", stats->substitutions);
+    fprintf(file, "%-12s %10s %12s\n", "phase", "calls", "ms");
+    for (WffStatsPhase phase = 0; phase < WSTP_COUNT; phase++) {
+        fprintf(file, "%-12s %10zu %12.3f\n", wff_stats_phase_string(phase), stats->phase_calls[phase], stats->phase_nanoseconds[phase] / 1e6);
+    }
+}
+
+const char* wff_stats_phase_string(WffStatsPhase phase) {
+    switch (phase) {
+        case WSTP_TOKENIZE:
+            return "tokenize";
+        case WSTP_PARSE:
+            return "parse";
+        case WSTP_TREE:
+            return "tree";
+        case WSTP_RENDER:
+            return "render";
+        case WSTP_MATCH:
+            return "match";
+        case WSTP_SUBSTITUTE:
+            return "substitute";
+        case WSTP_SUBWFFS:
+            return "subwffs";
+        case WSTP_CHECK:
+            return "check";
+        case WSTP_PROVE:
+            return "prove";
+        default:
+            return "?";
+    }
+}
+
+uint64_t _wff_stats_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+void _wff_stats_phase_end(WffStatsPhase phase, uint64_t start) {
+#ifdef WFF_STATS
+    __atomic_fetch_add(&WFF_STATS_TOTALS.phase_nanoseconds[phase], _wff_stats_now() - start, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&WFF_STATS_TOTALS.phase_calls[phase], 1, __ATOMIC_RELAXED);
+#endif
+}
@@ -0,0 +1,52 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+typedef struct WffStats WffStats;
+
+// Phases timed by the stats. A phase that runs inside another (rendering
+// while a wff tree is made, say) is counted in both.
+typedef enum {
+    WSTP_TOKENIZE,
+    WSTP_PARSE,
+    WSTP_TREE,
+    WSTP_RENDER,
+    WSTP_MATCH,
+    WSTP_SUBSTITUTE,
+    WSTP_SUBWFFS,
+    WSTP_CHECK,
+    WSTP_PROVE,
+    WSTP_COUNT
+} WffStatsPhase;
+
+// Counts of the work done since the last wff_stats_reset, kept only in
+// builds with WFF_STATS defined ("make STATS=1"); otherwise the counting
+// compiles to nothing and every count stays 0. All threads add to the same
+// counts, so phase times are summed over threads.
+struct WffStats {
+    size_t tokens_lexed;
+    // Parse tree nodes, not counting the ones found in a node table.
+    size_t nodes_allocated;
+    // Given out by arenas, or by malloc for trees without one.
+    size_t bytes_allocated;
+    // Sites a pattern or the rule index was tried at.
+    size_t match_attempts;
+    size_t subtree_equals_calls;
+    size_t substitutions;
+    uint64_t phase_nanoseconds[WSTP_COUNT];
+    size_t phase_calls[WSTP_COUNT];
+};
+
+
+bool wff_stats_enabled();
+void wff_stats_reset();
+void wff_stats_snapshot(WffStats* stats);
+void wff_stats_print(const WffStats* stats, FILE* file);
+const char* wff_stats_phase_string(WffStatsPhase phase);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef STATS_INTERNAL_H_
+#define STATS_INTERNAL_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "stats.h"
+
+
+/* === WffStats === */
+// The counting macros. Without WFF_STATS they expand to nothing, their
+// arguments included, so a release build pays nothing for them. A phase is
+// timed from WFF_STATS_BEGIN to WFF_STATS_END in the same block, which must
+// not be left in between.
+#ifdef WFF_STATS
+
+extern WffStats WFF_STATS_TOTALS;
+
+#define WFF_STATS_ADD(counter, n) __atomic_fetch_add(&WFF_STATS_TOTALS.counter, (n), __ATOMIC_RELAXED)
+#define WFF_STATS_BEGIN(phase) uint64_t wff_stats_start_##phase = _wff_stats_now()
+#define WFF_STATS_END(phase) _wff_stats_phase_end(phase, wff_stats_start_##phase)
+
+#else
+
+#define WFF_STATS_ADD(counter, n) ((void) 0)
+#define WFF_STATS_BEGIN(phase) ((void) 0)
+#define WFF_STATS_END(phase) ((void) 0)
+
+#endif
+
+uint64_t _wff_stats_now();
+void _wff_stats_phase_end(WffStatsPhase phase, uint64_t start);
+
+#endif
@@ -0,0 +1,31 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "threads.h"
+
+
+/* === Threads === */
+
+int wff_threads_parse_option(int argc, char** argv, size_t* thread_count) {
+    if (argc < 2 || strcmp(argv[0], "-j") != 0) {
+        return 0;
+    }
+    char* end;
+    long requested = strtol(argv[1], &end, 10);
+    if (*end != '\0' || requested < 1) {
+        fprintf(stderr, "ERROR: Invalid thread count %s\n", argv[1]);
+        return -1;
+    }
+    *thread_count = requested;
+    return 2;
+}
+
+size_t wff_threads_resolve(size_t thread_count) {
+    if (thread_count == 0) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = processors > 0 ? processors : 1;
+    }
+    return thread_count;
+}
@@ -0,0 +1,16 @@
+#ifndef THREADS_H_
+#define THREADS_H_
+
+#include <stdlib.h>
+
+
+// Reads the "-j threads" option from the front of a command's arguments, if
+// it is there, into 'thread_count' (left alone otherwise). Returns how many
+// arguments it took, or -1 after printing an error if the count isn't a
+// positive number.
+int wff_threads_parse_option(int argc, char** argv, size_t* thread_count);
+
+// 'thread_count', or one thread per online processor if it is 0.
+size_t wff_threads_resolve(size_t thread_count);
+
+#endif
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "logic.h"
+#include "vector.h"
+
+// Elements room is made for by the first append.
+#define WFF_VECTOR_MIN_CAPACITY 8
+
+
+/* === WffVector === */
+
+void wff_vector_init(WffVector* vector, size_t element_size, WffArena* arena) {
+    vector->data = NULL;
+    vector->element_size = element_size;
+    vector->length = 0;
+    vector->capacity = 0;
+    vector->arena = arena;
+}
+
+// Frees the elements, unless they belong to an arena; the vector can be used
+// again after wff_vector_init.
+void wff_vector_finish(WffVector* vector) {
+    if (vector->arena == NULL) {
+        free(vector->data);
+    }
+    vector->data = NULL;
+    vector->length = 0;
+    vector->capacity = 0;
+}
+
+void* wff_vector_push(WffVector* vector) {
+    if (vector->length == vector->capacity) {
+        size_t capacity = vector->capacity == 0 ? WFF_VECTOR_MIN_CAPACITY : vector->capacity * 2;
+        if (vector->arena == NULL) {
+            vector->data = realloc(vector->data, capacity * vector->element_size);
+        } else {
+            void* data = wff_arena_alloc(vector->arena, capacity * vector->element_size);
+            if (vector->length > 0) {
+                memcpy(data, vector->data, vector->length * vector->element_size);
+            }
+            vector->data = data;
+        }
+        vector->capacity = capacity;
+    }
+    return (char*) vector->data + vector->length++ * vector->element_size;
+}
+
+void wff_vector_append(WffVector* vector, const void* element) {
+    memcpy(wff_vector_push(vector), element, vector->element_size);
+}
+
+void wff_vector_append_all(WffVector* vector, const WffVector* other) {
+    for (size_t i = 0; i < other->length; i++) {
+        wff_vector_append(vector, (char*) other->data + i * other->element_size);
+    }
+}
+
+// Drops the elements past 'length', if there are any.
+void wff_vector_truncate(WffVector* vector, size_t length) {
+    if (length < vector->length) {
+        vector->length = length;
+    }
+}
+
+void* wff_vector_get(const WffVector* vector, size_t index) {
+    if (index >= vector->length) {
+        return NULL;
+    }
+    return (char*) vector->data + index * vector->element_size;
+}
+
+size_t wff_vector_length(const WffVector* vector) {
+    return vector->length;
+}
+
+WffVectorIterator wff_vector_iterate(const WffVector* vector) {
+    return (WffVectorIterator) {.vector = vector, .index = 0};
+}
+
+void* wff_vector_iterator_next(WffVectorIterator* iterator) {
+    void* element = wff_vector_get(iterator->vector, iterator->index);
+    if (element != NULL) {
+        iterator->index++;
+    }
+    return element;
+}
@@ -0,0 +1,48 @@
+#ifndef VECTOR_H_
+#define VECTOR_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+
+typedef struct WffArena WffArena;
+typedef struct WffVector WffVector;
+typedef struct WffVectorIterator WffVectorIterator;
+
+
+// A growable array of elements of one size, stored contiguously: indexing is
+// O(1), and appending is amortized O(1) with one allocation per doubling. A
+// vector given an arena grows inside it and is freed along with it; the
+// arrays it outgrows stay behind, which at worst doubles what it takes.
+struct WffVector {
+    void* data;
+    size_t element_size;
+    size_t length;
+    size_t capacity;
+    WffArena* arena;
+};
+
+// A walk over a vector, kept by the caller, so any number of walks can be
+// going on at once. Appending during a walk is fine; nothing else is.
+struct WffVectorIterator {
+    const WffVector* vector;
+    size_t index;
+};
+
+
+void wff_vector_init(WffVector* vector, size_t element_size, WffArena* arena);
+void wff_vector_finish(WffVector* vector);
+// Adds an uninitialized element to the end and returns it.
+void* wff_vector_push(WffVector* vector);
+void wff_vector_append(WffVector* vector, const void* element);
+void wff_vector_append_all(WffVector* vector, const WffVector* other);
+void wff_vector_truncate(WffVector* vector, size_t length);
+// NULL if 'index' is out of range.
+void* wff_vector_get(const WffVector* vector, size_t index);
+size_t wff_vector_length(const WffVector* vector);
+
+WffVectorIterator wff_vector_iterate(const WffVector* vector);
+// The next element, or NULL after the last.
+void* wff_vector_iterator_next(WffVectorIterator* iterator);
+
+#endif
@@ -6,6 +6,9 @@
 
 #include "wff-helper.h"
 #include "logic.h"
+#include "batch.h"
+#include "prover.h"
+#include "stats.h"
 
 /*
 TODO:
@@ -21,10 +24,37 @@ TODO:
 */
 
 
-int main(void) {
-    test();
+int main(int argc, char** argv) {
+    // "--profile" before the other arguments prints what the run did to
+    // stderr at the end.
+    bool profile = argc > 1 && strcmp(argv[1], "--profile") == 0;
+    if (profile) {
+        if (!wff_stats_enabled()) {
+            fprintf(stderr, "ERROR: --profile needs a build with WFF_STATS (make clean && make STATS=1)\n");
+            return 1;
+        }
+        argc--;
+        argv++;
+        wff_stats_reset();
+    }
 
-    printf("done\n");
+    int status = 0;
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+        status = wff_batch_main(argc - 2, argv + 2);
+    } else if (argc > 1 && strcmp(argv[1], "--prove") == 0) {
+        status = wff_prover_main(argc - 2, argv + 2);
+    } else {
+        test();
+        printf("done\n");
+    }
+
+    if (profile) {
+        WffStats stats;
+        wff_stats_snapshot(&stats);
+        fflush(stdout);
+        wff_stats_print(&stats, stderr);
+    }
+    return status;
 }
 
 
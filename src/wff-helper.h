@@ -9,8 +9,6 @@
 
 
 
-WffMatchList* wff_match(Wff* wff, char* wff_pattern_string);
-bool wff_substitute(Wff* wff, char* search, char* replace, size_t index);
 
 
 #endif
\ No newline at end of file